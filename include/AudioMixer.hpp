@@ -0,0 +1,45 @@
+#ifndef AUDIO_MIXER_HPP
+#define AUDIO_MIXER_HPP
+
+#include <stdint.h>
+
+#ifndef AUDIO_SAMPLE_RATE
+#define AUDIO_SAMPLE_RATE 22050
+#endif
+
+// samples mixed per call to AudioMixer_RenderBlock, one output interrupt each on the device
+#define AUDIO_BLOCK_SAMPLES 128
+#define AUDIO_VOICE_COUNT 4
+
+// one cycle of sine; the other waveforms are computed from the phase directly
+#define AUDIO_WAVETABLE_BITS 8
+#define AUDIO_WAVETABLE_SIZE (1 << AUDIO_WAVETABLE_BITS)
+
+enum Waveform
+{
+  Sine,
+  Square,
+  Triangle,
+  Sawtooth,
+  Noise
+};
+
+// generated at compile time so the table lives in flash rather than RAM
+struct AudioWavetables
+{
+  int16_t sine[AUDIO_WAVETABLE_SIZE];
+};
+
+extern const AudioWavetables audioWavetables;
+
+// Voices are changed from the main loop and picked up at the start of the next block, so a
+// change never waits on the interrupt and the interrupt never sees a half-written voice.
+// volume 0-255; durationMilliseconds 0 plays until AudioMixer_Stop
+void AudioMixer_Play(unsigned int voice, Waveform waveform, unsigned int frequency, uint8_t volume, unsigned int durationMilliseconds);
+void AudioMixer_Stop(unsigned int voice);
+bool AudioMixer_IsPlaying(unsigned int voice);
+
+// mixes the next AUDIO_BLOCK_SAMPLES signed 16-bit samples, saturating rather than wrapping
+void AudioMixer_RenderBlock(int16_t *samples);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,23 @@
+#ifndef AUDIO_OUTPUT_HPP
+#define AUDIO_OUTPUT_HPP
+
+#include <stdint.h>
+
+// Teensy 3.1 DAC on pin A14. The PDB timer paces samples at AUDIO_SAMPLE_RATE and DMA copies
+// them to the DAC from a two-block ring, so the CPU is only interrupted once per block to mix
+// the half that has just been played.
+void AudioOutput_Begin(void);
+
+// cycles spent in the mixer per block, against the cycles one block lasts
+struct AudioLoad
+{
+  uint32_t blocks;
+  uint32_t lastCycles;
+  uint32_t peakCycles;
+  uint32_t budgetCycles;
+};
+
+AudioLoad AudioOutput_GetLoad(void);
+void AudioOutput_PrintLoad(void);
+
+#endif
\ No newline at end of file
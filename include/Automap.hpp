@@ -0,0 +1,90 @@
+#ifndef AUTOMAP_HPP
+#define AUTOMAP_HPP
+
+#include <stdint.h>
+
+#include "Vector2.hpp"
+#include "WorldMap.hpp"
+#include "Raycaster.hpp"
+#include "DisplayWrapper.hpp"
+
+// largest map the image covers; cells beyond it are left off the automap
+#ifndef AUTOMAP_MAX_MAP_WIDTH
+#define AUTOMAP_MAX_MAP_WIDTH MAP_WIDTH
+#endif
+#ifndef AUTOMAP_MAX_MAP_HEIGHT
+#define AUTOMAP_MAX_MAP_HEIGHT MAP_HEIGHT
+#endif
+
+// pixels per map cell
+#define AUTOMAP_MAX_SCALE 4
+#ifndef AUTOMAP_DEFAULT_SCALE
+#define AUTOMAP_DEFAULT_SCALE 3
+#endif
+
+// the whole map at the largest scale, in OLED page layout: 8 rows per byte, bit 0 on top
+#define AUTOMAP_IMAGE_WIDTH (AUTOMAP_MAX_MAP_WIDTH * AUTOMAP_MAX_SCALE)
+#define AUTOMAP_IMAGE_PAGES ((AUTOMAP_MAX_MAP_HEIGHT * AUTOMAP_MAX_SCALE + 7) / 8)
+
+// the image is cached in tiles of 8 x 8 pixels (one page byte wide, eight columns across)
+#define AUTOMAP_TILES_ACROSS ((AUTOMAP_IMAGE_WIDTH + 7) / 8)
+#define AUTOMAP_TILE_COUNT (AUTOMAP_TILES_ACROSS * AUTOMAP_IMAGE_PAGES)
+
+struct AutomapStats
+{
+  uint32_t framesDrawn;
+  uint32_t tilesRedrawn;     // since construction
+  uint16_t lastTilesRedrawn;
+  uint16_t tiles;
+};
+
+// A map of the wall faces the player has actually seen, taken from the raycaster's seen-face bits
+// and drawn as a window into the display's 1-bit pages, centred on the player with north up. The
+// whole map is kept as an image in page layout; only the tiles under cells whose faces changed are
+// redrawn, and the seen bits are only compared when the raycaster's change count moves. Each frame
+// is then one shifted byte copy per window column and page.
+class Automap
+{
+public:
+  Automap(Raycaster *raycaster);
+
+  // where on the display the automap goes: columns x to x + width - 1, pages firstPage onwards
+  void SetWindow(unsigned int x, unsigned int width, unsigned int firstPage, unsigned int pages);
+  // pixels per cell, 1 to AUTOMAP_MAX_SCALE; redraws the whole image
+  void SetScale(unsigned int scale);
+  unsigned int GetScale(void);
+  // forgets what has been drawn, for after the seen faces are cleared or the map changes
+  void Invalidate(void);
+
+  // call after the display's pages are prepared and before they are sent
+  void Draw(DisplayWrapper *display, Vector2 player, Vector2 direction);
+
+  AutomapStats GetStats(void);
+
+private:
+  Raycaster *raycaster;
+  int mapWidth;
+  int mapHeight;
+  unsigned int scale;
+
+  unsigned int windowX;
+  unsigned int windowWidth;
+  unsigned int windowFirstPage;
+  unsigned int windowPages;
+
+  uint8_t image[AUTOMAP_IMAGE_PAGES * AUTOMAP_IMAGE_WIDTH];
+  uint8_t dirtyTiles[(AUTOMAP_TILE_COUNT + 7) / 8];
+  // the raycaster's seen bits as of the last Draw
+  uint8_t drawnFaces[RAYCASTER_SEEN_BYTES];
+  uint32_t drawnChanges;
+
+  AutomapStats stats;
+
+  void FindChangedCells(void);
+  void MarkCellDirty(int x, int y);
+  void RedrawTile(unsigned int tile);
+  unsigned char ImageByte(int page, int column);
+  void SetPixel(uint8_t *pages, unsigned int displayWidth, int x, int y);
+};
+
+#endif
\ No newline at end of file
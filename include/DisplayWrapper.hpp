@@ -1,25 +1,43 @@
 #ifndef DISPLAY_WRAPPER_HPP
 #define DISPLAY_WRAPPER_HPP
 
-#include <U8g2lib.h>
+#include <stdint.h>
+
+// the SSD1309 OLED
+#define DISPLAY_WIDTH 128
+#define DISPLAY_HEIGHT 64
+
+class SharedFrameRing;
 
 class DisplayWrapper
 {
 public:
   DisplayWrapper(void);
+  // host builds only: an off-screen frame of any size, height a multiple of 8
+  DisplayWrapper(unsigned int width, unsigned int height);
+  // host builds only: draws straight into the ring's slots; Clear starts a frame, Render publishes it
+  DisplayWrapper(SharedFrameRing *ring);
+  ~DisplayWrapper(void);
 
   void Clear(void);
   unsigned char* GetBuffer(void);
+  // 1-bit OLED pages from the last Render: 8 pages of 128 bytes, bit 0 is the top row of a page
+  unsigned char* GetPageBuffer(void);
   void Render(bool dither);
+  // Render in two halves, so overlays can be drawn into the pages in between
+  void PreparePages(bool dither);
+  void SendPages(void);
   unsigned int GetWidth(void);
   unsigned int GetHeight(void);
 
 private:
   //U8G2_SSD1309_128X64_NONAME0_F_4W_SW_SPI u8g2;
   unsigned char *displayBuffer;
+  unsigned char *pageBuffer;
+  SharedFrameRing *sharedFrames;
+  unsigned int width;
+  unsigned int height;
   int bufferSize;
-
-  void ApplyDither(unsigned char *buffer, const uint16_t offset, const unsigned char error, const bool negate);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,97 @@
+#ifndef ENTITY_STORE_HPP
+#define ENTITY_STORE_HPP
+
+#include <stdint.h>
+
+#include "Vector2.hpp"
+#include "WorldMap.hpp"
+#include "SpriteRenderer.hpp"
+#include "VisibilitySet.hpp"
+
+// entities per store; host builds raise it for the benchmarks
+#ifndef ENTITY_MAX_COUNT
+#define ENTITY_MAX_COUNT 256
+#endif
+
+// largest map the cell index covers
+#ifndef ENTITY_MAX_MAP_CELLS
+#define ENTITY_MAX_MAP_CELLS (MAP_WIDTH * MAP_HEIGHT)
+#endif
+
+#define ENTITY_INVALID 0xffff
+
+// handles stay valid while entities move around the arrays; indices do not
+typedef uint16_t EntityHandle;
+
+enum EntityFlags
+{
+  EntityMoving = 1,  // integrated by Update
+  EntitySolid = 2,   // bounces off walls instead of passing through them
+  EntityVisible = 4, // drawn as a sprite
+  EntityChasing = 8  // steered along the flow field towards the player each frame
+};
+
+// Every entity in one structure-of-arrays store: the arrays are indexed 0 to GetCount() - 1 and
+// removal moves the last entity into the hole, so they stay packed and Update walks them front
+// to back. Update also rebuilds a per-map-cell index (a counting sort by cell), which is what the
+// queries use: entities added or moved since the last Update are not in it yet.
+class EntityStore
+{
+public:
+  float positionX[ENTITY_MAX_COUNT];
+  float positionY[ENTITY_MAX_COUNT];
+  float velocityX[ENTITY_MAX_COUNT];
+  float velocityY[ENTITY_MAX_COUNT];
+  uint8_t spriteId[ENTITY_MAX_COUNT];
+  uint8_t flags[ENTITY_MAX_COUNT];
+  EntityHandle handles[ENTITY_MAX_COUNT];
+
+  EntityStore(int mapWidth, int mapHeight, int *worldMap);
+
+  // ENTITY_INVALID when the store is full
+  EntityHandle Add(Vector2 position, Vector2 velocity, uint8_t sprite, uint8_t flags);
+  void Remove(EntityHandle handle);
+  void Clear(void);
+  bool IsAlive(EntityHandle handle);
+  // -1 for a removed entity
+  int GetIndex(EntityHandle handle);
+  unsigned int GetCount(void);
+
+  Vector2 GetPosition(EntityHandle handle);
+  void SetPosition(EntityHandle handle, Vector2 position);
+  void SetVelocity(EntityHandle handle, Vector2 velocity);
+
+  // moves every moving entity and rebuilds the cell index; no allocation, linear in entities
+  // plus map cells
+  void Update(float deltaTime);
+
+  // entities within radius of a point, at most maxResults; returns how many were found
+  unsigned int QueryRadius(Vector2 centre, float radius, EntityHandle *results, unsigned int maxResults);
+  // another entity closer than radius to this one, ENTITY_INVALID if there is none
+  EntityHandle FindOverlap(EntityHandle handle, float radius);
+  bool IsWall(float x, float y);
+
+  // replaces the renderer's sprites with the visible entities within range of the camera, skipping
+  // those in cells the camera's cell cannot see when a visibility set is given
+  unsigned int SubmitSprites(SpriteRenderer *sprites, Vector2 camera, float range, VisibilitySet *visibility);
+
+private:
+  int mapWidth;
+  int mapHeight;
+  int *worldMap;
+  unsigned int count;
+  unsigned int freeCount;
+
+  uint16_t indexOfHandle[ENTITY_MAX_COUNT];
+  EntityHandle freeHandles[ENTITY_MAX_COUNT];
+
+  // the index: cellEntities[cellStart[c], cellStart[c + 1]) are the entities in cell c
+  uint16_t cell[ENTITY_MAX_COUNT];
+  uint16_t cellStart[ENTITY_MAX_MAP_CELLS + 1];
+  EntityHandle cellEntities[ENTITY_MAX_COUNT];
+  unsigned int indexedCells;
+
+  int CellOf(float x, float y);
+};
+
+#endif
\ No newline at end of file
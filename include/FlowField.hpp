@@ -0,0 +1,78 @@
+#ifndef FLOW_FIELD_HPP
+#define FLOW_FIELD_HPP
+
+#include <stdint.h>
+
+#include "Vector2.hpp"
+#include "WorldMap.hpp"
+
+// largest map the field covers
+#ifndef FLOW_FIELD_MAX_CELLS
+#define FLOW_FIELD_MAX_CELLS (MAP_WIDTH * MAP_HEIGHT)
+#endif
+
+// cells expanded per Update by default: the shipped map settles in under ten frames
+#define FLOW_FIELD_CELLS_PER_FRAME 64
+
+// what each cell's step is, in the low bits of its field byte
+enum FlowDirection
+{
+  FlowEast,  // x + 1
+  FlowSouth, // y + 1
+  FlowWest,  // x - 1
+  FlowNorth, // y - 1
+  FlowGoal,
+  FlowUnreached
+};
+
+struct FlowFieldStats
+{
+  uint32_t passes;           // searches that ran to completion
+  uint32_t restarts;         // searches abandoned because the goal moved first
+  uint16_t lastCellsExpanded;
+  uint16_t lastPassCells;    // cells the last completed search reached
+};
+
+// A breadth-first flow field over the tile map towards one goal cell (the player), shared by every
+// agent: each cell holds the step to its neighbour one cell closer to the goal, so an agent's next
+// step is a single lookup. The search runs in place a few cells per Update. When the goal moves,
+// the search starts over from the new cell, and cells it has not reached yet keep their step
+// towards the old goal, which is close by. One byte per cell plus a queue of cell indices.
+// Cells are in world coordinates (x = column from the right of worldMap, as the raycaster sees it).
+class FlowField
+{
+public:
+  FlowField(int mapWidth, int mapHeight, int *worldMap);
+
+  // starts a new search when position is in a different open cell from the current goal
+  void SetGoal(Vector2 position);
+  // expands at most maxCells cells of the running search
+  void Update(unsigned int maxCells);
+  bool IsSettled(void);
+
+  FlowDirection GetDirection(int x, int y);
+  // centre of the next cell from position, or false in the goal cell and where no path is known
+  bool GetNextCellCentre(Vector2 position, Vector2 *centre);
+
+  FlowFieldStats GetStats(void);
+
+private:
+  int mapWidth;
+  int mapHeight;
+  int *worldMap;
+  int goalCell;
+
+  // the high five bits are the search generation that last wrote the cell, the low three its
+  // FlowDirection
+  uint8_t field[FLOW_FIELD_MAX_CELLS];
+  uint16_t queue[FLOW_FIELD_MAX_CELLS];
+  unsigned int queueHead;
+  unsigned int queueTail;
+  uint8_t generation;
+
+  FlowFieldStats stats;
+
+  bool IsOpen(int x, int y);
+};
+
+#endif
\ No newline at end of file
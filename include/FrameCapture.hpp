@@ -0,0 +1,65 @@
+#ifndef FRAME_CAPTURE_HPP
+#define FRAME_CAPTURE_HPP
+
+#include <stdint.h>
+
+#include "DisplayWrapper.hpp"
+
+// the capture snapshot holds one 128 x 64 greyscale frame; page frames use an eighth of it, and
+// the next eighth for the previous page frame
+#ifndef FRAME_CAPTURE_BUFFER_SIZE
+#define FRAME_CAPTURE_BUFFER_SIZE 8192
+#endif
+
+// encoded bytes carried by one data packet at most
+#define FRAME_CAPTURE_CHUNK_SIZE 250
+
+// page frames are sent whole this often, so a decoder that lost a packet picks up again
+#define FRAME_CAPTURE_KEYFRAME_INTERVAL 30
+
+// Stream packets start with the sync byte and a type; multi-byte fields are little-endian.
+// Text printed on the same port between packets is skipped by the decoder.
+#define FRAME_CAPTURE_SYNC 0xa5
+#define FRAME_CAPTURE_FRAME 'F' // u32 frame since the start, u32 milliseconds, u32 frame cost in microseconds,
+                                // u8 format, u8 delta, u16 width, u16 height
+#define FRAME_CAPTURE_DATA 'D'  // u16 length, then that many PackBits bytes, or frame bytes for a stored frame
+#define FRAME_CAPTURE_END 'E'   // u32 FNV-1a of the decoded frame
+#define FRAME_CAPTURE_FRAME_PACKET_SIZE 20
+#define FRAME_CAPTURE_END_PACKET_SIZE 6
+
+// set in the delta byte of the frame header when PackBits would not have made the frame smaller,
+// so the data packets carry the delta-coded bytes as they are
+#define FRAME_CAPTURE_STORED 0x80
+
+enum CaptureFormat
+{
+  CaptureGreyscale, // the 8-bit DisplayWrapper buffer, row-major
+  CapturePages      // the packed 1-bit page buffer sent to the OLED
+};
+
+// what each byte is XORed with before run-length coding, chosen frame by frame
+enum CaptureDelta
+{
+  DeltaNone,
+  DeltaPreviousFrame, // pages: only changed pixels are non-zero
+  DeltaRowAbove       // greyscale: wall columns and flat floor rows become runs of zero
+};
+
+// Frames are snapshotted once drawn and sent a few packets at a time, so capturing never holds up a
+// frame; frames rendered while one is still going out are skipped. Greyscale frames are taken
+// before PreparePages dithers the frame buffer in place, page frames after it.
+// frames 0 captures until FrameCapture_Stop
+void FrameCapture_Start(CaptureFormat format, unsigned int frames);
+void FrameCapture_Stop(void);
+bool FrameCapture_IsActive(void);
+CaptureFormat FrameCapture_GetFormat(void);
+// false when the frame was skipped
+bool FrameCapture_Snapshot(DisplayWrapper *display, uint32_t milliseconds, uint32_t frameMicroseconds);
+// fills out with whole packets, at most space bytes; returns the bytes to send
+unsigned int FrameCapture_Pump(unsigned char *out, unsigned int space);
+
+// decoding, for the host tools
+unsigned int FrameCapture_UnpackBits(const unsigned char *packed, unsigned int packedLength, unsigned char *out, unsigned int space);
+uint32_t FrameCapture_Checksum(const unsigned char *bytes, unsigned int length);
+
+#endif
\ No newline at end of file
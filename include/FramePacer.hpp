@@ -0,0 +1,44 @@
+#ifndef FRAME_PACER_HPP
+#define FRAME_PACER_HPP
+
+#include <stdint.h>
+
+#include "Scheduler.hpp"
+
+// sleep in chunks until this close to the frame boundary, then spin the rest; the device
+// wakes from WFI on its 1 ms tick, so sleeping any closer could overshoot
+#define FRAME_PACER_SPIN_MICROSECONDS 1000
+// a stall longer than this (Serial, a breakpoint) is not passed on to the game as one huge step
+#define FRAME_PACER_MAX_DELTA 0.25
+
+enum DeltaTimeMode
+{
+  MeasuredDelta, // time since the previous frame started
+  SmoothedDelta, // running average of it, so frame jitter does not show up as judder
+  FixedDelta     // the frame interval, whatever the frame actually took
+};
+
+struct FramePacerStats
+{
+  uint32_t frames;
+  uint32_t missedFrames;            // frames that ran past their interval
+  // running averages over roughly the last 16 frames
+  float utilisation;                // share of each frame spent awake, 0 to 1
+  float meanFrameMicroseconds;
+  float frameMicrosecondsDeviation; // standard deviation of the frame time
+};
+
+// idle is called while waiting for the next frame: WFI on the device, a simulated wait on host
+void FramePacer_Init(SchedulerClock clock, void (*idle)(void));
+// 0 runs frames back to back as fast as they go
+void FramePacer_SetInterval(uint32_t intervalMicroseconds);
+void FramePacer_SetDeltaTimeMode(DeltaTimeMode mode);
+
+// marks the start of a frame and returns the game time step in seconds
+double FramePacer_StartFrame(void);
+// sleeps until the next frame is due
+void FramePacer_FinishFrame(void);
+
+FramePacerStats FramePacer_GetStats(void);
+
+#endif
\ No newline at end of file
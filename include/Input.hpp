@@ -2,7 +2,6 @@
 #define INPUT_HPP
 
 #include <Arduino.h>
-#include <map>
 
 enum Button
 {
@@ -0,0 +1,108 @@
+#ifndef LIGHT_MAP_HPP
+#define LIGHT_MAP_HPP
+
+#include <stdint.h>
+
+#include "Vector2.hpp"
+#include "WorldMap.hpp"
+#include "LightTables.hpp"
+#include "Raycaster.hpp"
+
+// largest map the face table covers; faces beyond it stay unlit
+#ifndef LIGHT_MAP_MAX_MAP_CELLS
+#define LIGHT_MAP_MAX_MAP_CELLS (MAP_WIDTH * MAP_HEIGHT)
+#endif
+
+#ifndef LIGHT_MAP_MAX_LIGHTS
+#define LIGHT_MAP_MAX_LIGHTS 16
+#endif
+
+// points along each face that rays from a light are cast to, for soft shadow edges
+#ifndef LIGHT_MAP_SAMPLES_PER_FACE
+#define LIGHT_MAP_SAMPLES_PER_FACE 3
+#endif
+
+// faces relit per Update by default
+#define LIGHT_MAP_FACES_PER_FRAME 32
+
+// each face keeps four bits of added light, in steps of LIGHT_MAP_LEVEL_STEP light table levels
+#define LIGHT_MAP_FACE_LEVELS 16
+#define LIGHT_MAP_LEVEL_STEP (LIGHT_LEVEL_MAX / LIGHT_MAP_FACE_LEVELS)
+#define LIGHT_MAP_FACE_BYTES (LIGHT_MAP_MAX_MAP_CELLS * 4 / 2)
+#define LIGHT_MAP_DIRTY_BYTES ((LIGHT_MAP_MAX_MAP_CELLS * 4 + 7) / 8)
+
+#define LIGHT_MAP_NO_LIGHT -1
+
+struct PointLight
+{
+  Vector2 position;
+  float radius;    // cells; nothing beyond it is lit
+  float intensity; // 1 lights a face it squarely faces, close up, by LIGHT_MAP_FACE_LEVELS - 1 steps
+  bool enabled;
+  bool used;
+};
+
+struct LightMapStats
+{
+  uint16_t lights;
+  uint16_t pendingFaces;
+  uint16_t lastFacesRelit;
+  uint32_t facesRelit; // since construction
+  uint32_t raysCast;   // since construction
+  uint32_t bytes;      // the whole map
+};
+
+// Light from point sources baked onto the wall faces of the tile map: each face holds how much its
+// lights add to the renderer's distance shading, four bits in the same cell and face order as the
+// raycaster's seen faces. A face is lit by a light that is within range, in front of it and not
+// shadowed, sampled at a few points along the face with the raycaster's line-of-sight queries.
+//
+// Changing a light only marks the faces within its radius before and after the change; Update
+// then relights at most a budget of them per call, round the map from where it left off, and the
+// faces still waiting keep their old light until their turn comes. Cells are in world coordinates.
+class LightMap
+{
+public:
+  LightMap(Raycaster *raycaster);
+
+  // LIGHT_MAP_NO_LIGHT when every light is in use; lights belong in open cells
+  int AddLight(Vector2 position, float radius, float intensity);
+  void RemoveLight(int light);
+  void MoveLight(int light, Vector2 position);
+  void SetLightEnabled(int light, bool enabled);
+
+  // relights at most maxFaces marked faces
+  void Update(unsigned int maxFaces);
+  // marks every face and relights them all, for load time and the host tools
+  void Bake(void);
+  bool IsSettled(void);
+
+  // call after the map cell at world (x, y) has been changed: it may cast or lift shadows
+  void TileChanged(int x, int y);
+
+  // light table levels the face adds, 0 to (LIGHT_MAP_FACE_LEVELS - 1) * LIGHT_MAP_LEVEL_STEP
+  unsigned char GetFaceLevel(int x, int y, WallFace face);
+
+  LightMapStats GetStats(void);
+
+private:
+  Raycaster *raycaster;
+  int mapWidth;
+  int mapHeight;
+
+  PointLight lights[LIGHT_MAP_MAX_LIGHTS];
+  uint8_t faceLevels[LIGHT_MAP_FACE_BYTES];
+  uint8_t dirtyFaces[LIGHT_MAP_DIRTY_BYTES];
+  unsigned int pendingCount;
+  unsigned int nextFace; // where the next Update starts looking for marked faces
+
+  LightMapStats stats;
+
+  bool IsOpen(int x, int y);
+  unsigned int FaceCount(void);
+  void MarkLight(int light);
+  void MarkFace(unsigned int face);
+  unsigned char LightFace(unsigned int face);
+};
+
+#endif
\ No newline at end of file
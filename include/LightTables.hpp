@@ -0,0 +1,20 @@
+#ifndef LIGHT_TABLES_HPP
+#define LIGHT_TABLES_HPP
+
+// light levels are fractions of full brightness in steps of 1 / LIGHT_LEVEL_MAX
+#define LIGHT_LEVEL_SHIFT 5
+#define LIGHT_LEVEL_MAX (1 << LIGHT_LEVEL_SHIFT)
+#define LIGHT_LEVEL_COUNT (LIGHT_LEVEL_MAX + 1)
+
+// Doom-style colour maps: level[l][texel] = texel * l / LIGHT_LEVEL_MAX
+// generated at compile time so the tables live in flash rather than RAM
+struct LightTables
+{
+  unsigned char level[LIGHT_LEVEL_COUNT][256];
+};
+
+extern const LightTables lightTables;
+
+unsigned char LightTables_LevelForShade(double shade);
+
+#endif
\ No newline at end of file
@@ -1,8 +1,38 @@
 #ifndef MELODY_PLAYER_HPP
 #define MELODY_PLAYER_HPP
 
-void MelodyPlayer_SetPassiveBuzzerPin(int passiveBuzzerPin);
-void MelodyPlayer_SetMelody(const int *melody, const int arraySize);
-void MelodyPlayer_Play();
+#include <stdint.h>
+
+// one note of a melody: frequency in Hz (below 32 is a rest), duration in milliseconds.
+// melodies are constexpr Note tables in flash and are played in place, never copied
+struct Note
+{
+  uint16_t frequency;
+  uint16_t duration;
+};
+
+// a queued track starts straight away over one of lower priority, which resumes afterwards;
+// tracks of equal or lower priority wait their turn
+#define MELODY_PRIORITY_MUSIC 0
+#define MELODY_PRIORITY_EFFECT 1
+#define MELODY_PRIORITY_COUNT 2
+
+// tracks waiting to play at each priority, a power of two
+#define MELODY_QUEUE_SIZE 4
+
+// the sequencer advances once per tick; note changes and pre-emption happen on tick boundaries
+#define MELODY_TICK_MICROSECONDS 1000
+
+// sounds a note: frequency in Hz, 0 for silence. tone() on a buzzer pin on the device
+typedef void (*MelodyOutput)(uint16_t frequency);
+
+void MelodyPlayer_Init(MelodyOutput output);
+// every MELODY_TICK_MICROSECONDS, from a timer interrupt on the device
+void MelodyPlayer_Tick(void);
+
+// never blocks or allocates; false when that priority's queue is full
+bool MelodyPlayer_Queue(const Note *notes, uint16_t noteCount, uint8_t priority, bool loop);
+void MelodyPlayer_Stop(void);
+bool MelodyPlayer_IsPlaying(void);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,11 @@
+#ifndef MEMORY_REPORT_HPP
+#define MEMORY_REPORT_HPP
+
+// RAM headroom over Serial: static data, arena, heap and the deepest the stack has reached.
+// The stack is measured by painting the unused RAM between heap and stack with a pattern at
+// startup and later finding how much of it has been overwritten.
+void MemoryReport_PaintStack(void);  // first thing in setup
+void MemoryReport_MarkStartup(void); // end of setup, heap growth is measured from here
+void MemoryReport_Print(void);
+
+#endif
\ No newline at end of file
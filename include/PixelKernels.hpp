@@ -0,0 +1,89 @@
+#ifndef PIXEL_KERNELS_HPP
+#define PIXEL_KERNELS_HPP
+
+#include <stdint.h>
+
+// widest row the dither pass keeps error rows for
+#define DITHER_MAX_WIDTH 128
+
+// Packed 8-bit kernels: four greyscale pixels per 32-bit word, byte 0 is the leftmost pixel.
+// Cortex-M4 builds use the DSP instructions; everything else uses SWAR fallbacks that give
+// identical results, so the kernels can be checked on the host.
+
+#if defined(__ARM_FEATURE_DSP)
+
+static inline uint32_t PixelKernels_SaturatingAdd4(uint32_t a, uint32_t b)
+{
+  uint32_t result;
+  __asm__("uqadd8 %0, %1, %2" : "=r"(result) : "r"(a), "r"(b));
+  return result;
+}
+
+static inline uint32_t PixelKernels_SaturatingSubtract4(uint32_t a, uint32_t b)
+{
+  uint32_t result;
+  __asm__("uqsub8 %0, %1, %2" : "=r"(result) : "r"(a), "r"(b));
+  return result;
+}
+
+// 0xff in every byte where pixels >= thresholds, 0x00 elsewhere
+static inline uint32_t PixelKernels_Threshold4(uint32_t pixels, uint32_t thresholds)
+{
+  uint32_t result;
+  // usub8 sets the GE flag of each byte with no borrow, sel then picks per byte
+  __asm__("usub8 %0, %1, %2\n\tsel %0, %3, %4" : "=&r"(result) : "r"(pixels), "r"(thresholds), "r"(0xffffffffu), "r"(0u) : "cc");
+  return result;
+}
+
+static inline uint8_t PixelKernels_ClampByte(int32_t value)
+{
+  int32_t result;
+  __asm__("usat %0, #8, %1" : "=r"(result) : "r"(value));
+  return (uint8_t)result;
+}
+
+#else
+
+static inline uint32_t PixelKernels_SaturatingAdd4(uint32_t a, uint32_t b)
+{
+  // add the low 7 bits of each byte without carries crossing bytes, then fix up bit 7
+  const uint32_t low = (a & 0x7f7f7f7fu) + (b & 0x7f7f7f7fu);
+  const uint32_t sum = low ^ ((a ^ b) & 0x80808080u);
+  const uint32_t carry = ((a & b) | ((a ^ b) & low)) & 0x80808080u;
+  return sum | ((carry >> 7) * 0xffu);
+}
+
+static inline uint32_t PixelKernels_SaturatingSubtract4(uint32_t a, uint32_t b)
+{
+  // bit 7 of each byte of a is set first so no borrow crosses bytes, then fixed up
+  const uint32_t low = (a | 0x80808080u) - (b & 0x7f7f7f7fu);
+  const uint32_t difference = low ^ (~(a ^ b) & 0x80808080u);
+  const uint32_t borrow = ((~a & b) | (~(a ^ b) & ~low)) & 0x80808080u;
+  return difference & ~((borrow >> 7) * 0xffu);
+}
+
+// 0xff in every byte where pixels >= thresholds, 0x00 elsewhere
+static inline uint32_t PixelKernels_Threshold4(uint32_t pixels, uint32_t thresholds)
+{
+  const uint32_t low = (pixels | 0x80808080u) - (thresholds & 0x7f7f7f7fu);
+  const uint32_t borrow = ((~pixels & thresholds) | (~(pixels ^ thresholds) & ~low)) & 0x80808080u;
+  return ((~borrow & 0x80808080u) >> 7) * 0xffu;
+}
+
+static inline uint8_t PixelKernels_ClampByte(int32_t value)
+{
+  if (value < 0)
+    return 0;
+  if (value > 255)
+    return 255;
+  return (uint8_t)value;
+}
+
+#endif
+
+// Converts a greyscale frame (row-major, one byte per pixel) into 1-bit OLED pages: each page
+// byte holds 8 vertical pixels, bit 0 at the top. Pixels >= 128 are lit. With dither the frame is
+// Floyd-Steinberg dithered in place first. width must be a multiple of 4 and height of 8.
+void PixelKernels_RenderPages(unsigned char *greyscale, unsigned char *pages, unsigned int width, unsigned int height, bool dither);
+
+#endif
\ No newline at end of file
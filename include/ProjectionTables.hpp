@@ -0,0 +1,41 @@
+#ifndef PROJECTION_TABLES_HPP
+#define PROJECTION_TABLES_HPP
+
+// display height the tables are built for; displays of any other height divide per column
+#ifndef PROJECTION_DISPLAY_HEIGHT
+#define PROJECTION_DISPLAY_HEIGHT 64
+#endif
+
+// table precision: wall distances are quantised to 1 / (1 << PROJECTION_DISTANCE_BITS) of a cell
+#ifndef PROJECTION_DISTANCE_BITS
+#define PROJECTION_DISTANCE_BITS 6
+#endif
+
+// cells; walls farther away share the last entry
+#ifndef PROJECTION_MAX_DISTANCE
+#define PROJECTION_MAX_DISTANCE 64
+#endif
+
+#define PROJECTION_DISTANCE_COUNT ((PROJECTION_MAX_DISTANCE << PROJECTION_DISTANCE_BITS) + 1)
+
+// the closest entry holds PROJECTION_DISPLAY_HEIGHT << PROJECTION_DISTANCE_BITS in an unsigned
+// short, and the tables are generated and indexed with ints
+static_assert(((long long)PROJECTION_DISPLAY_HEIGHT << PROJECTION_DISTANCE_BITS) <= 0xffff,
+  "PROJECTION_DISTANCE_BITS is too large for the lineHeight table");
+static_assert(((long long)PROJECTION_MAX_DISTANCE << PROJECTION_DISTANCE_BITS) < 0x7fffffff,
+  "PROJECTION_DISTANCE_BITS is too large for the distance index");
+
+// per-column projection without division, generated at compile time so the tables live in flash
+struct ProjectionTables
+{
+  unsigned short lineHeight[PROJECTION_DISTANCE_COUNT];   // PROJECTION_DISPLAY_HEIGHT / distance
+  unsigned char lightLevel[2][PROJECTION_DISTANCE_COUNT]; // light table level for the distance: [0] lit, [1] east-west faces at 3/4
+  int wallTextureStep[PROJECTION_DISPLAY_HEIGHT];         // 16.16 texels per pixel down a wall lineHeight pixels tall
+};
+
+extern const ProjectionTables projectionTables;
+
+// nearest table entry for a wall distance
+unsigned int ProjectionTables_DistanceIndex(double distance);
+
+#endif
\ No newline at end of file
@@ -1,8 +1,101 @@
 #ifndef RAYCASTER_HPP
 #define RAYCASTER_HPP
 
+#include <stdint.h>
+
 #include "Vector2.hpp"
 #include "DisplayWrapper.hpp"
+#include "TrigTables.hpp"
+#include "WorldMap.hpp"
+
+// widest display the per-column buffers cover; host builds raise it for large previews
+#ifndef RAYCASTER_MAX_WIDTH
+#define RAYCASTER_MAX_WIDTH 128
+#endif
+
+// one wall depth and wall span per display column, filled by RenderToDisplay
+#define DEPTH_BUFFER_SIZE RAYCASTER_MAX_WIDTH
+
+// segment coherence: rays are cast at most this many columns apart, then refined where the edges disagree
+#define COHERENCE_SEGMENT_WIDTH 8
+
+// rays walked together by CastColumnPacket (SIMD on x86 host builds, scalar elsewhere)
+#define RAY_PACKET_SIZE 4
+
+// largest map the seen-face bits cover; faces in cells beyond it are not recorded
+#ifndef RAYCASTER_MAX_MAP_CELLS
+#define RAYCASTER_MAX_MAP_CELLS (MAP_WIDTH * MAP_HEIGHT)
+#endif
+
+// four bits per map cell, one per face: bit (y * mapWidth + x) * 4 + WallFace
+#define RAYCASTER_SEEN_BYTES ((RAYCASTER_MAX_MAP_CELLS * 4 + 7) / 8)
+
+// floor / ceiling texture index meaning "leave untextured (black)"
+#define NO_TEXTURE -1
+
+// 1 makes RenderToDisplay count its work into a RenderStats each frame; at 0 the counting and the
+// accessor compile away
+#ifndef RAYCASTER_STATS
+#define RAYCASTER_STATS 0
+#endif
+
+#if RAYCASTER_STATS
+#define RAYCASTER_STAT(statement) statement
+#else
+#define RAYCASTER_STAT(statement)
+#endif
+
+// what one RenderToDisplay did, for finding out why one view is slower than another
+struct RenderStats
+{
+  unsigned int raysCast;            // full grid walks
+  unsigned int ddaSteps;            // grid cells stepped through by those walks
+  unsigned int clampedRays;         // walls further than mapWidth + mapHeight, drawn at that distance
+  unsigned int halfRateColumns;     // columns filled from their neighbour on the full-height half-rate path
+  unsigned int texelsSampled;       // walls, floor and ceiling
+  unsigned int pixelsWritten;
+  unsigned int maxColumnDdaSteps;   // the longest single walk
+  unsigned int maxDdaStepsColumn;   // and the column it was cast for
+  unsigned int maxColumnWallPixels; // most wall pixels written by one column (a doubled column writes two)
+};
+
+// which grid line a ray crossed into the wall it hit, named as the renderer names wall faces
+enum RayHitSide
+{
+  RayHitNorthSouth, // an x boundary: texture U runs along y
+  RayHitEastWest    // a y boundary: texture U runs along x
+};
+
+// the side of a wall cell a face is on; north is y + 1, as the automap draws the world with y up
+enum WallFace
+{
+  FaceWest,  // x - 1 side
+  FaceEast,  // x + 1 side
+  FaceSouth, // y - 1 side
+  FaceNorth  // y + 1 side
+};
+
+// what one ray query found; cells are in world coordinates, as the camera sees them
+struct RayHit
+{
+  bool hit;
+  int cellX;
+  int cellY;
+  RayHitSide side;
+  unsigned char wall;   // map value of the cell hit (outside the map reads as wall 1)
+  float distance;       // along the normalised ray, from the origin
+  float textureU;       // 0 to 1 across the face, as the renderer samples it
+  unsigned int steps;   // grid cells stepped through
+};
+
+struct RayQuery
+{
+  Vector2 origin;
+  Vector2 direction;    // need not be normalised
+  float maxDistance;
+};
+
+class LightMap;
 
 class Raycaster
 {
@@ -16,24 +109,145 @@ public:
   void SetCameraPosition(Vector2 position);
   void SetCameraDirection(Vector2 direction);
   void SetCameraDirection(double angleInRadians);
+  // table-driven camera: direction and clip plane come from the trig tables, no libm calls
+  void SetCameraAngle(BinaryAngle angle);
   void SetFOVInRadians(double fovInRadians);
+  void SetFOV(BinaryAngle fov);
+  // distances of 0 or less are ignored
   void SetClipPlaneDistance(double distance);
+  void SetFloorTexture(int texture);
+  void SetCeilingTexture(int texture);
+  void SetSegmentCoherence(bool enabled);
+  void SetPacketTraversal(bool enabled);
+  // baked face light added to the distance shading of every wall column; nullptr for none
+  void SetLightMap(LightMap *lightMap);
   void RenderToDisplay(DisplayWrapper *display);
+  // Walls, floor and ceiling for columns [firstX, endX) only, every column at full rate. Only
+  // per-column state is written, so disjoint ranges may render on separate threads while the
+  // camera is left alone. Returns the rays cast.
+  unsigned int RenderColumnRange(DisplayWrapper *display, unsigned int firstX, unsigned int endX);
+
+  Vector2 GetCameraPosition(void);
+  Vector2 GetCameraDirection(void);
+  Vector2 GetClipPlaneRightVector(void);
+  double GetClipPlaneDistance(void);
+  const float* GetDepthBuffer(void);
+  unsigned int GetRaysCast(void);
+#if RAYCASTER_STATS
+  const RenderStats &GetRenderStats(void);
+#endif
+
+  // Grid queries for game logic, the same walk the renderer does but without the camera: they only
+  // read the map, so they are safe to call between or during renders. A miss (nothing within
+  // maxDistance, or a zero direction) leaves hit->hit false and returns false.
+  bool CastRay(Vector2 origin, Vector2 direction, float maxDistance, RayHit *hit);
+  // the first wall between two points, if any
+  bool CastSegment(Vector2 from, Vector2 to, RayHit *hit);
+  bool HasLineOfSight(Vector2 from, Vector2 to);
+  // many rays in one call; returns how many hit
+  unsigned int CastRays(const RayQuery *queries, RayHit *hits, unsigned int count);
+  // line of sight from one point to many, sharing the origin's cell setup between the walks;
+  // returns how many targets are visible
+  unsigned int CheckLineOfSight(Vector2 from, const Vector2 *targets, bool *visible, unsigned int count);
+
+  // Wall faces hit by the rays RenderToDisplay cast, accumulated until ClearSeen. Columns filled
+  // from their neighbours (coherent segments, half-rate walls) show faces their neighbours already
+  // marked, so the cost is one bit test per ray. RenderColumnRange marks nothing, so ranges on
+  // separate threads never share a byte.
+  void SetSeenTracking(bool enabled);
+  void ClearSeen(void);
+  bool IsFaceSeen(int x, int y, WallFace face);
+  // bit WallFace of the result is set for each seen face of the cell
+  unsigned char GetSeenFaces(int x, int y);
+  // the packed bits themselves, RAYCASTER_SEEN_BYTES of them
+  const uint8_t *GetSeenFaceBits(void);
+  // goes up whenever a face is first seen or the faces are cleared, so caches can tell they are stale
+  uint32_t GetSeenChanges(void);
 
 private:
+  enum Side {
+    NorthSouth,
+    EastWest
+  };
+
+  struct ColumnHit
+  {
+    int mapX;
+    int mapY;
+    int signX;
+    int signY;
+    Side side;
+    double perpendicularWallDistance;
+    double textureUV_U;
+  };
+
+  struct ColumnSpan
+  {
+    unsigned int lineHeight;
+    int startPixelY;
+    int endPixelY;
+    int textureColumn;
+    int textureRow;     // 16.16 texture row at startPixelY
+    int textureRowStep; // 16.16 texture rows per pixel
+    const unsigned char *texture;
+    const unsigned char *lightTable;
+  };
+
+  // state carried from column to column within one pass over a range of columns
+  struct RenderPass
+  {
+    bool halfRateFullHeight; // walls filling the display are drawn every other column and doubled
+    bool markSeen;
+    bool fullHeightLine;
+    unsigned char fullHeightLineCode;
+    unsigned int raysCast;
+#if RAYCASTER_STATS
+    RenderStats stats;
+#endif
+  };
+
   Vector2 cameraPosition;
   Vector2 cameraDirection;
   Vector2 clipPlaneRightVector;
   double fovInRadians;
   double distanceToClipPlane;
+  double clipPlaneHalfWidth; // distanceToClipPlane * tan(fov / 2), kept up to date by the setters
+  float depthBuffer[DEPTH_BUFFER_SIZE];
+  unsigned short wallTop[DEPTH_BUFFER_SIZE];
+  unsigned short wallBottom[DEPTH_BUFFER_SIZE];
+  int floorTexture;
+  int ceilingTexture;
+  bool segmentCoherence;
+  bool packetTraversal;
+  bool seenTracking;
+  LightMap *lightMap;
+  unsigned int raysCast; // full grid walks during the last RenderToDisplay
+  uint8_t seenFaces[RAYCASTER_SEEN_BYTES];
+  uint32_t seenChanges;
+#if RAYCASTER_STATS
+  RenderStats renderStats;
+#endif
 
   void UpdateClipPlaneVector(void);
+  Vector2 RayForColumn(unsigned int x, unsigned int displayWidth);
+  void RenderColumns(DisplayWrapper *display, unsigned int firstX, unsigned int endX, RenderPass &pass);
+  void CastColumn(unsigned int x, unsigned int displayWidth, ColumnHit &columnHit, RenderPass &pass);
+  void ResolveWallDistance(const Vector2 &ray, ColumnHit &columnHit);
+  void MarkSeen(const ColumnHit &hit);
+  WallFace FaceOf(const ColumnHit &hit);
+  void RefineSegment(ColumnHit *hits, unsigned int segmentStart, int first, int last, unsigned int displayWidth, RenderPass &pass);
+  void DrawColumn(unsigned int x, const ColumnHit &hit, DisplayWrapper *display, RenderPass &pass);
+  void PrepareColumn(unsigned int x, const ColumnHit &hit, unsigned int displayHeight, ColumnSpan &span, RenderPass &pass);
+  void DrawColumnSpan(unsigned int x, const ColumnSpan &span, DisplayWrapper *display, RenderPass &pass);
+  void CastColumnPacket(unsigned int firstX, unsigned int displayWidth, ColumnHit *hits, RenderPass &pass);
+  void DrawColumnPacket(unsigned int firstX, const ColumnHit *hits, DisplayWrapper *display, RenderPass &pass);
+  void RenderFloorAndCeiling(DisplayWrapper *display, unsigned int firstX, unsigned int endX, RenderPass &pass);
+#if RAYCASTER_STATS
+  void CountWalk(unsigned int x, unsigned int steps, RenderPass &pass);
+  void CountWallPixels(unsigned int pixels, unsigned int texels, RenderPass &pass);
+#endif
   unsigned char WallAtMapPosition(int xPos, int yPos);
-
-  enum Side {
-    NorthSouth,
-    EastWest
-  };
+  bool WalkRay(float originX, float originY, int cellX, int cellY, float directionX, float directionY, float maxDistance, RayHit *hit);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,52 @@
+#ifndef SCHEDULER_HPP
+#define SCHEDULER_HPP
+
+#include <stdint.h>
+
+#define SCHEDULER_MAX_TASKS 12
+
+// frame tasks run every time they are due, in the order they were added; background tasks
+// only start in the slack left before the frame deadline, and only if their budget fits
+#define SCHEDULER_PRIORITY_FRAME 0
+#define SCHEDULER_PRIORITY_BACKGROUND 1
+
+typedef void (*SchedulerTask)(void *context);
+// microseconds, free running and allowed to wrap; micros on the device, simulated on host
+typedef uint32_t (*SchedulerClock)(void);
+
+struct TaskStats
+{
+  const char *name;
+  uint32_t runs;
+  uint32_t overruns;  // runs that took longer than the task's budget
+  uint32_t deferrals; // frames the task was due but did not fit in the slack
+  uint32_t lastMicroseconds;
+  uint32_t worstMicroseconds;
+};
+
+struct SchedulerStats
+{
+  uint32_t frames;
+  uint32_t frameOverruns; // frames that finished after their deadline
+  uint32_t lastSlackMicroseconds;
+};
+
+// Cooperative and allocation-free: tasks live in a fixed table and run to completion.
+void Scheduler_Init(SchedulerClock clock);
+
+// periodMicroseconds 0 runs the task every frame. Both return a task id, or -1 when the table
+// is full
+int Scheduler_AddPeriodic(const char *name, SchedulerTask task, void *context, uint32_t periodMicroseconds,
+  uint32_t budgetMicroseconds, uint8_t priority);
+// runs once, no earlier than delayMicroseconds from now, then frees its slot
+int Scheduler_Defer(const char *name, SchedulerTask task, void *context, uint32_t delayMicroseconds,
+  uint32_t budgetMicroseconds, uint8_t priority);
+void Scheduler_Cancel(int taskId);
+
+// one frame: due frame tasks, then background tasks until the deadline; returns the slack left
+uint32_t Scheduler_RunFrame(uint32_t frameMicroseconds);
+
+bool Scheduler_GetTaskStats(int taskId, TaskStats *stats);
+SchedulerStats Scheduler_GetStats(void);
+
+#endif
\ No newline at end of file
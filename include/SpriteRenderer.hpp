@@ -0,0 +1,56 @@
+#ifndef SPRITE_RENDERER_HPP
+#define SPRITE_RENDERER_HPP
+
+#include "Vector2.hpp"
+#include "Raycaster.hpp"
+#include "DisplayWrapper.hpp"
+
+#define MAX_SPRITES 64
+// per-frame budget: only the nearest MAX_VISIBLE_SPRITES sprites in view are drawn
+#define MAX_VISIBLE_SPRITES 24
+
+struct Sprite
+{
+  Vector2 position;
+  unsigned char texture;
+  bool active;
+};
+
+struct SpriteStats
+{
+  unsigned int drawn;      // sprites that passed culling and were drawn
+  unsigned int culled;     // sprites behind the camera or outside the field of view
+  unsigned int overBudget; // visible sprites dropped because the frame budget was full
+};
+
+class SpriteRenderer
+{
+public:
+  SpriteRenderer(void);
+
+  int AddSprite(Vector2 position, unsigned char texture);
+  void RemoveSprite(int handle);
+  void SetSpritePosition(int handle, Vector2 position);
+  void Clear(void);
+
+  void RenderToDisplay(Raycaster *raycaster, DisplayWrapper *display);
+  SpriteStats GetStats(void);
+
+private:
+  struct VisibleSprite
+  {
+    float depth;   // perpendicular distance, same units as the raycaster depth buffer
+    float screenX; // centre column of the sprite
+    unsigned char index;
+  };
+
+  Sprite sprites[MAX_SPRITES];
+  VisibleSprite visibleSprites[MAX_VISIBLE_SPRITES];
+  int visibleCount;
+  SpriteStats stats;
+
+  void InsertVisible(float depth, float screenX, unsigned char index);
+  void DrawSprite(const VisibleSprite &visible, float pixelsPerUnitWide, const float *depthBuffer, DisplayWrapper *display);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,77 @@
+#ifndef SPRITE_TEXTURES_HPP
+#define SPRITE_TEXTURES_HPP
+
+// texel value 0 is transparent
+const unsigned char spriteTextures[2][1024] =
+{
+  {
+      0,   0,   0,  90, 110, 128, 145, 160, 173, 185, 194, 191, 209, 214, 218, 219, 219, 218, 214, 209, 203, 194, 173, 173, 160, 145, 128, 110,  90,   0,   0,   0,
+      0,   0,   0,  90, 110, 128, 133, 160, 173, 185, 194, 203, 209, 214, 218, 219, 219, 206, 214, 209, 203, 194, 185, 173, 160, 145, 128, 110,  78,   0,   0,   0,
+      0,   0,   0,   0,   0,  92, 115, 136, 154, 171, 185, 196, 193, 212, 217, 219, 219, 217, 212, 205, 196, 185, 171, 142, 136, 115,  92,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,  52,  75,  84, 114, 131, 145, 156, 165, 172, 177, 179, 179, 177, 160, 165, 156, 145, 131, 114,  96,  75,  52,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,  56,  87, 113, 135, 153, 154, 175, 179, 179, 175, 166, 153, 135, 113,  87,  56,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,  84, 127, 153, 175, 193, 206, 215, 219, 219, 215, 206, 181, 175, 153, 127,  96,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,  96, 127, 153, 175, 193, 206, 203, 219, 219, 215, 206, 193, 175, 153, 127,  96,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,  96, 115, 153, 175, 193, 206, 215, 219, 219, 215, 206, 193, 163, 153, 127,  96,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,  96, 127, 153, 175, 193, 206, 215, 207, 219, 215, 206, 193, 175, 153, 127,  96,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,  96, 127, 141, 175, 193, 206, 215, 219, 219, 215, 206, 193, 175, 141, 127,  96,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,  96, 127, 153, 175, 193, 206, 215, 219, 207, 215, 206, 193, 175, 153, 127,  96,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,  96, 127, 153, 163, 193, 206, 215, 219, 219, 215, 206, 193, 175, 153, 115,  96,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,  96, 127, 153, 175, 193, 206, 215, 219, 219, 203, 206, 193, 175, 153, 127,  96,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,  96, 127, 153, 175, 181, 206, 215, 219, 219, 215, 206, 193, 175, 153, 127,  84,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,  96, 127, 153, 175, 193, 206, 215, 219, 219, 215, 194, 193, 175, 153, 127,  96,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,  96, 127, 153, 175, 193, 194, 215, 219, 219, 215, 206, 193, 175, 153, 127,  96,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,  84, 127, 153, 175, 193, 206, 215, 219, 219, 215, 206, 181, 175, 153, 127,  96,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,  96, 127, 153, 175, 193, 206, 203, 219, 219, 215, 206, 193, 175, 153, 127,  96,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,  96, 115, 153, 175, 193, 206, 215, 219, 219, 215, 206, 193, 163, 153, 127,  96,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,  96, 127, 153, 175, 193, 206, 215, 207, 219, 215, 206, 193, 175, 153, 127,  96,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,  96, 127, 141, 175, 193, 206, 215, 219, 219, 215, 206, 193, 175, 141, 127,  96,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,  96, 127, 153, 175, 193, 206, 215, 219, 207, 215, 206, 193, 175, 153, 127,  96,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,  96, 127, 153, 163, 193, 206, 215, 219, 219, 215, 206, 193, 175, 153, 115,  96,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,  96, 127, 153, 175, 193, 206, 215, 219, 219, 203, 206, 193, 175, 153, 127,  96,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,  96, 127, 153, 175, 181, 206, 215, 219, 219, 215, 206, 193, 175, 153, 127,  84,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,  96, 127, 153, 175, 193, 206, 215, 219, 219, 215, 194, 193, 175, 153, 127,  96,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,  96, 127, 153, 175, 193, 194, 215, 219, 219, 215, 206, 193, 175, 153, 127,  96,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,  44,  87, 113, 135, 153, 166, 175, 179, 179, 175, 166, 141, 135, 113,  87,  56,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,  52,  75,  96, 114, 131, 145, 156, 165, 172, 165, 179, 179, 177, 172, 165, 156, 145, 131, 114,  96,  63,  52,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,  92, 115, 136, 154, 159, 185, 196, 205, 212, 217, 219, 219, 217, 212, 205, 184, 185, 171, 154, 136, 115,  92,   0,   0,   0,   0,   0,
+      0,   0,   0,  90,  98, 128, 145, 160, 173, 185, 194, 203, 209, 214, 218, 207, 219, 218, 214, 209, 203, 194, 185, 173, 160, 145, 116, 110,  90,   0,   0,   0,
+      0,   0,   0,  90, 110, 128, 145, 160, 173, 185, 182, 203, 209, 214, 218, 219, 219, 218, 214, 209, 203, 182, 185, 173, 160, 145, 128, 110,  90,   0,   0,   0,
+  },
+  {
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0, 120, 120,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0, 120, 120,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0, 120, 120,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0, 120, 120,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0, 120, 120,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0, 120, 120,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0, 120, 120,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0, 142, 150, 155, 158, 158, 155, 150, 142,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0, 139, 153, 163, 171, 177, 179, 179, 177, 171, 163, 153, 139,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0, 142, 158, 171, 182, 190, 195, 198, 198, 195, 190, 182, 171, 158, 142,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0, 139, 158, 174, 187, 198, 206, 211, 214, 214, 211, 206, 198, 187, 174, 158, 139,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0, 153, 171, 187, 201, 211, 219, 225, 227, 227, 225, 219, 211, 201, 187, 171, 153,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0, 142, 163, 182, 198, 211, 222, 230, 235, 238, 238, 235, 230, 222, 211, 198, 182, 163, 142,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0, 150, 171, 190, 206, 219, 230, 238, 243, 246, 246, 243, 238, 230, 219, 206, 190, 171, 150,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0, 155, 177, 195, 211, 225, 235, 243, 249, 251, 251, 249, 243, 235, 225, 211, 195, 177, 155,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0, 158, 179, 198, 214, 227, 238, 246, 251, 254, 254, 251, 246, 238, 227, 214, 198, 179, 158,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0, 157, 178, 196, 212, 226, 236, 244, 250, 252, 252, 250, 244, 236, 226, 212, 196, 178, 157,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0, 151, 172, 191, 207, 220, 230, 238, 244, 246, 246, 244, 238, 230, 220, 207, 191, 172, 151,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0, 142, 164, 182, 198, 211, 222, 230, 235, 238, 238, 235, 230, 222, 211, 198, 182, 164, 142,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0, 131, 152, 171, 187, 200, 211, 219, 224, 227, 227, 224, 219, 211, 200, 187, 171, 152, 131,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0, 139, 157, 173, 186, 197, 205, 210, 213, 213, 210, 205, 197, 186, 173, 157, 139,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0, 122, 141, 157, 170, 181, 189, 194, 197, 197, 194, 189, 181, 170, 157, 141, 122,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0, 122, 138, 151, 162, 169, 175, 177, 177, 175, 169, 162, 151, 138, 122,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0, 116, 129, 140, 148, 153, 156, 156, 153, 148, 140, 129, 116,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0, 115, 123, 129, 131, 131, 129, 123, 115,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+  }
+};
+
+#endif
\ No newline at end of file
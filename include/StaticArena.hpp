@@ -0,0 +1,32 @@
+#ifndef STATIC_ARENA_HPP
+#define STATIC_ARENA_HPP
+
+#include <stddef.h>
+#include <new>
+
+// bytes reserved for engine objects created at startup; the arena is a static array, so the
+// linker accounts for it and fails the build if RAM runs out
+#ifndef STATIC_ARENA_SIZE
+#define STATIC_ARENA_SIZE 27648
+#endif
+
+// Bump allocator over static storage: objects are created once during setup and never freed.
+// After StaticArena_Seal every allocation fails, so nothing can quietly allocate mid-game.
+void *StaticArena_Allocate(size_t size, size_t alignment);
+void StaticArena_Seal(void);
+size_t StaticArena_Used(void);
+size_t StaticArena_Capacity(void);
+unsigned int StaticArena_FailedAllocations(void);
+
+// constructs a T inside the arena, nullptr when it does not fit or the arena is sealed
+template <typename T, typename... Args>
+T *StaticArena_New(Args... args)
+{
+  void *memory = StaticArena_Allocate(sizeof(T), alignof(T));
+  if (memory == nullptr)
+    return nullptr;
+
+  return new (memory) T(args...);
+}
+
+#endif
\ No newline at end of file
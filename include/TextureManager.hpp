@@ -1,7 +1,7 @@
 #ifndef TEXTURE_MANAGER_HPP
 #define TEXTURE_MANAGER_HPP
 
-unsigned char textures[15][1024] = 
+const unsigned char textures[15][1024] = 
 {
   {
     179, 178, 188, 189, 188, 199, 189, 188, 170, 170, 188, 188, 199, 200, 189, 189, 188, 189, 179, 179, 188, 188, 178, 168, 188, 200, 189, 188, 188, 188, 178, 178,
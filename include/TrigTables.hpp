@@ -0,0 +1,36 @@
+#ifndef TRIG_TABLES_HPP
+#define TRIG_TABLES_HPP
+
+#include <stdint.h>
+
+#include "Vector2.hpp"
+
+// binary angles: a full turn is 65536, so adding and subtracting wraps for free and repeated
+// small turns never drift
+typedef uint16_t BinaryAngle;
+#define BINARY_ANGLE_BITS 16
+#define BINARY_ANGLE_QUARTER_TURN (1 << (BINARY_ANGLE_BITS - 2))
+
+// table resolution: 1 << TRIG_TABLE_BITS steps per turn (4096 is about 0.09 degrees a step)
+#define TRIG_TABLE_BITS 12
+#define TRIG_TABLE_QUARTER (1 << (TRIG_TABLE_BITS - 2))
+
+// sine over the first quarter turn, endpoints included; the other quadrants are reflections.
+// generated at compile time so the table lives in flash rather than RAM
+struct TrigTables
+{
+  float quarterSine[TRIG_TABLE_QUARTER + 1];
+};
+
+extern const TrigTables trigTables;
+
+float TrigTables_Sin(BinaryAngle angle);
+float TrigTables_Cos(BinaryAngle angle);
+float TrigTables_Tan(BinaryAngle angle);
+// unit vector pointing along angle, (cos, sin)
+Vector2 TrigTables_Direction(BinaryAngle angle);
+
+BinaryAngle TrigTables_FromRadians(double radians);
+double TrigTables_ToRadians(BinaryAngle angle);
+
+#endif
\ No newline at end of file
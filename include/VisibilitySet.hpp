@@ -0,0 +1,113 @@
+#ifndef VISIBILITY_SET_HPP
+#define VISIBILITY_SET_HPP
+
+#include <stdint.h>
+
+#include "Vector2.hpp"
+#include "WorldMap.hpp"
+#include "Raycaster.hpp"
+
+// largest map the cell table covers
+#ifndef VISIBILITY_MAX_MAP_CELLS
+#define VISIBILITY_MAX_MAP_CELLS (MAP_WIDTH * MAP_HEIGHT)
+#endif
+
+// open cells the pair bits have room for (the shipped map has 317); past this every pair reads
+// as visible
+#ifndef VISIBILITY_MAX_OPEN_CELLS
+#define VISIBILITY_MAX_OPEN_CELLS 320
+#endif
+
+// sample points along each axis of a cell: rays go from every sample of one cell to every sample
+// of the other until one gets through
+#ifndef VISIBILITY_SAMPLES_PER_AXIS
+#define VISIBILITY_SAMPLES_PER_AXIS 2
+#endif
+
+// cell pairs tested per Update by default
+#define VISIBILITY_PAIRS_PER_FRAME 64
+
+// one bit per unordered pair of open cells, each cell paired with itself included
+#define VISIBILITY_PAIR_BITS ((uint32_t)VISIBILITY_MAX_OPEN_CELLS * (VISIBILITY_MAX_OPEN_CELLS + 1) / 2)
+#define VISIBILITY_CELL_BYTES ((VISIBILITY_MAX_OPEN_CELLS + 7) / 8)
+
+#define VISIBILITY_NOT_OPEN 0xffff
+
+struct VisibilityStats
+{
+  uint16_t openCells;
+  uint16_t pendingCells;  // cells whose pairs are still to be (re)tested
+  uint32_t visiblePairs;
+  uint32_t pairsTested;   // since construction
+  uint32_t raysCast;      // since construction
+  uint32_t bytes;         // the whole set
+};
+
+// A potentially visible set over the tile map: one bit for each pair of open cells, set when some
+// ray from a sample point in one cell reaches a sample point in the other. Visibility is taken to
+// be symmetric, so each pair is tested and stored once, and cells are numbered over the open cells
+// only, so walls cost nothing but their entry in the cell table.
+//
+// The tests run a few pairs per Update, like FlowField's search. Until a cell's pairs are done it
+// reads as visible from everywhere, so culling only ever errs towards drawing. When a tile changes,
+// the cells that could see it or the cells around it are retested against each other, the cells
+// around it against every cell, and a newly opened tile's whole view after that; everything else
+// keeps its bits. Cells are in world coordinates, as the raycaster sees them.
+class VisibilitySet
+{
+public:
+  VisibilitySet(Raycaster *raycaster);
+
+  // marks every pair for testing; Update then does the work
+  void Invalidate(void);
+  // tests at most maxPairs pairs
+  void Update(unsigned int maxPairs);
+  // Invalidate and Update until done, for load time and the host tools
+  void Build(void);
+  bool IsComplete(void);
+
+  // call after the map cell at world (x, y) has been changed
+  void TileChanged(int x, int y);
+
+  // O(1); walls and cells off the map are not in the set and, like unfinished cells, read as visible
+  bool IsPotentiallyVisible(int fromX, int fromY, int toX, int toY);
+  bool IsPotentiallyVisible(Vector2 from, Vector2 to);
+
+  VisibilityStats GetStats(void);
+
+private:
+  Raycaster *raycaster;
+  int mapWidth;
+  int mapHeight;
+  bool overflowed; // more open cells than VISIBILITY_MAX_OPEN_CELLS
+
+  unsigned int openCount;
+  uint16_t openIndex[VISIBILITY_MAX_MAP_CELLS];  // world cell to open cell number, or VISIBILITY_NOT_OPEN
+  uint16_t openCells[VISIBILITY_MAX_OPEN_CELLS]; // open cell number to world cell
+
+  uint8_t pairs[(VISIBILITY_PAIR_BITS + 7) / 8];
+  // pending cells are tested against the region cells (or every cell, for whole rows) that are
+  // not pending themselves; every pending cell is also in the region
+  uint8_t pending[VISIBILITY_CELL_BYTES];
+  uint8_t region[VISIBILITY_CELL_BYTES];
+  uint8_t wholeRow[VISIBILITY_CELL_BYTES];
+  uint8_t opened[VISIBILITY_CELL_BYTES];   // whole rows whose visible cells are retested once they are done
+  int currentCell;      // pending cell being tested, -1 between cells
+  unsigned int nextPartner;
+  unsigned int pendingCount;
+
+  uint32_t pairsTested;
+  uint32_t raysCast;
+
+  bool IsOpen(int x, int y);
+  void IndexCells(void);
+  void InsertCell(unsigned int index, uint16_t cell);
+  void RemoveCell(unsigned int index);
+  void MarkRow(unsigned int index, uint8_t *cells);
+  void MarkCell(unsigned int index);
+  bool GetPair(unsigned int a, unsigned int b);
+  void SetPair(unsigned int a, unsigned int b, bool visible);
+  bool TestPair(unsigned int a, unsigned int b);
+};
+
+#endif
\ No newline at end of file
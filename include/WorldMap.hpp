@@ -0,0 +1,11 @@
+#ifndef WORLD_MAP_HPP
+#define WORLD_MAP_HPP
+
+#define MAP_WIDTH 24
+#define MAP_HEIGHT 24
+
+// worldMap[row][column], 0 = open cell, otherwise the wall's texture index
+// (the raycaster mirrors columns: world x = MAP_WIDTH - 1 - column)
+extern int worldMap[MAP_HEIGHT][MAP_WIDTH];
+
+#endif
\ No newline at end of file
@@ -0,0 +1,186 @@
+#include "AudioMixer.hpp"
+
+#include <math.h>
+
+#define AUDIO_AMPLITUDE 32767
+#define AUDIO_BLOCK_MILLISECONDS_X1000 (AUDIO_BLOCK_SAMPLES * 1000000 / AUDIO_SAMPLE_RATE)
+
+// Taylor series with range reduction to [-pi, pi], plenty for 16-bit samples
+static constexpr double ConstexprSin(double x)
+{
+  while (x > M_PI)
+    x -= 2.0 * M_PI;
+
+  double term = x;
+  double sum = x;
+
+  for (int n = 1; n < 14; n++)
+  {
+    term *= -x * x / ((2 * n) * (2 * n + 1));
+    sum += term;
+  }
+
+  return sum;
+}
+
+static constexpr AudioWavetables BuildAudioWavetables(void)
+{
+  AudioWavetables tables = {};
+
+  for (int i = 0; i < AUDIO_WAVETABLE_SIZE; i++)
+  {
+    const double sample = ConstexprSin(i * (2.0 * M_PI) / AUDIO_WAVETABLE_SIZE) * AUDIO_AMPLITUDE;
+    tables.sine[i] = (int16_t)(sample < 0 ? sample - 0.5 : sample + 0.5);
+  }
+
+  return tables;
+}
+
+constexpr AudioWavetables audioWavetables = BuildAudioWavetables();
+
+// written by the main loop; the interrupt only copies it while pending is set
+struct VoiceRequest
+{
+  volatile bool pending;
+  volatile uint8_t waveform;
+  volatile uint8_t volume;
+  volatile uint32_t phaseStep;
+  volatile uint32_t blocksLeft; // 0 plays until stopped
+};
+
+// owned by the block interrupt
+struct Voice
+{
+  uint8_t waveform;
+  uint8_t volume;
+  bool active;
+  uint32_t phase;
+  uint32_t phaseStep;
+  uint32_t blocksLeft;
+  uint32_t noise; // xorshift state
+  int32_t noiseSample;
+};
+
+static VoiceRequest requests[AUDIO_VOICE_COUNT];
+static Voice voices[AUDIO_VOICE_COUNT];
+static volatile bool voicePlaying[AUDIO_VOICE_COUNT];
+
+static void MixVoice(Voice &voice, int32_t *mix);
+
+void AudioMixer_Play(unsigned int voice, Waveform waveform, unsigned int frequency, uint8_t volume, unsigned int durationMilliseconds)
+{
+  if (voice >= AUDIO_VOICE_COUNT)
+    return;
+
+  // if the interrupt lands in the middle of this it sees no request and takes it next block
+  VoiceRequest &request = requests[voice];
+  request.pending = false;
+  request.waveform = waveform;
+  request.volume = volume;
+  request.phaseStep = (uint32_t)(((uint64_t)frequency << 32) / AUDIO_SAMPLE_RATE);
+  request.blocksLeft = (durationMilliseconds == 0) ? 0 : (durationMilliseconds * 1000 + AUDIO_BLOCK_MILLISECONDS_X1000 - 1) / AUDIO_BLOCK_MILLISECONDS_X1000;
+  request.pending = true;
+  voicePlaying[voice] = volume > 0;
+}
+
+void AudioMixer_Stop(unsigned int voice)
+{
+  AudioMixer_Play(voice, Sine, 0, 0, 0);
+}
+
+bool AudioMixer_IsPlaying(unsigned int voice)
+{
+  return voice < AUDIO_VOICE_COUNT && voicePlaying[voice];
+}
+
+void AudioMixer_RenderBlock(int16_t *samples)
+{
+  int32_t mix[AUDIO_BLOCK_SAMPLES] = {};
+
+  for (unsigned int i = 0; i < AUDIO_VOICE_COUNT; i++)
+  {
+    Voice &voice = voices[i];
+    VoiceRequest &request = requests[i];
+
+    if (request.pending)
+    {
+      voice.waveform = request.waveform;
+      voice.volume = request.volume;
+      voice.phaseStep = request.phaseStep;
+      voice.blocksLeft = request.blocksLeft;
+      voice.active = voice.volume > 0;
+      if (voice.noise == 0)
+        voice.noise = 0x9e3779b9u + i;
+      request.pending = false;
+    }
+
+    if (!voice.active)
+      continue;
+
+    MixVoice(voice, mix);
+
+    if (voice.blocksLeft > 0 && --voice.blocksLeft == 0)
+    {
+      voice.active = false;
+      if (!request.pending)
+        voicePlaying[i] = false;
+    }
+  }
+
+  for (unsigned int i = 0; i < AUDIO_BLOCK_SAMPLES; i++)
+  {
+    const int32_t sample = mix[i];
+    samples[i] = (int16_t)(sample > 32767 ? 32767 : (sample < -32768 ? -32768 : sample));
+  }
+}
+
+// one waveform per loop, so the per-sample work is a table read or a couple of integer ops
+static void MixVoice(Voice &voice, int32_t *mix)
+{
+  const int32_t volume = voice.volume;
+  const uint32_t step = voice.phaseStep;
+  uint32_t phase = voice.phase;
+
+  switch (voice.waveform)
+  {
+  case Sine:
+    for (unsigned int i = 0; i < AUDIO_BLOCK_SAMPLES; i++, phase += step)
+      mix[i] += (audioWavetables.sine[phase >> (32 - AUDIO_WAVETABLE_BITS)] * volume) >> 8;
+    break;
+  case Square:
+    for (unsigned int i = 0; i < AUDIO_BLOCK_SAMPLES; i++, phase += step)
+      mix[i] += ((phase & 0x80000000u) ? -AUDIO_AMPLITUDE : AUDIO_AMPLITUDE) * volume >> 8;
+    break;
+  case Triangle:
+    for (unsigned int i = 0; i < AUDIO_BLOCK_SAMPLES; i++, phase += step)
+    {
+      // fold the phase into a rising then falling ramp, -32768 to 32767
+      const int32_t ramp = (int32_t)(((phase & 0x80000000u) ? ~phase : phase) >> 15) - 32768;
+      mix[i] += (ramp * volume) >> 8;
+    }
+    break;
+  case Sawtooth:
+    for (unsigned int i = 0; i < AUDIO_BLOCK_SAMPLES; i++, phase += step)
+      mix[i] += (((int32_t)phase >> 16) * volume) >> 8;
+    break;
+  case Noise:
+  default:
+    // a new random level each time the phase wraps, so frequency sets the noise colour
+    for (unsigned int i = 0; i < AUDIO_BLOCK_SAMPLES; i++)
+    {
+      const uint32_t next = phase + step;
+      if (next < phase)
+      {
+        voice.noise ^= voice.noise << 13;
+        voice.noise ^= voice.noise >> 17;
+        voice.noise ^= voice.noise << 5;
+        voice.noiseSample = (int32_t)(voice.noise >> 16) - 32768;
+      }
+      phase = next;
+      mix[i] += (voice.noiseSample * volume) >> 8;
+    }
+    break;
+  }
+
+  voice.phase = phase;
+}
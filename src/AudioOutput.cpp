@@ -0,0 +1,101 @@
+#include "AudioOutput.hpp"
+
+#include <Arduino.h>
+#include <DMAChannel.h>
+
+#include "AudioMixer.hpp"
+
+// DAC requests come from the PDB, which counts bus clocks
+#define PDB_CONFIG (PDB_SC_TRGSEL(15) | PDB_SC_PDBEN | PDB_SC_CONT | PDB_SC_PDBIE | PDB_SC_DMAEN)
+#define PDB_PERIOD (F_BUS / AUDIO_SAMPLE_RATE - 1)
+
+// mid-scale for the 12-bit DAC
+#define DAC_SILENCE 2048
+
+static DMAChannel dma(false);
+// DMA plays one half while the interrupt mixes the other
+static uint16_t dacBuffer[AUDIO_BLOCK_SAMPLES * 2];
+
+static volatile AudioLoad load;
+
+static void BlockInterrupt(void);
+
+void AudioOutput_Begin(void)
+{
+  for (unsigned int i = 0; i < AUDIO_BLOCK_SAMPLES * 2; i++)
+    dacBuffer[i] = DAC_SILENCE;
+
+  // cycle counter for the load figures
+  ARM_DEMCR |= ARM_DEMCR_TRCENA;
+  ARM_DWT_CTRL |= ARM_DWT_CTRL_CYCCNTENA;
+  load.budgetCycles = (uint32_t)((uint64_t)F_CPU * AUDIO_BLOCK_SAMPLES / AUDIO_SAMPLE_RATE);
+
+  dma.begin(true);
+
+  // 3.3 V reference, output at mid-scale
+  SIM_SCGC2 |= SIM_SCGC2_DAC0;
+  DAC0_C0 = DAC_C0_DACEN | DAC_C0_DACRFS;
+  *(volatile int16_t *)&(DAC0_DAT0L) = DAC_SILENCE;
+
+  SIM_SCGC6 |= SIM_SCGC6_PDB;
+  PDB0_IDLY = 1;
+  PDB0_MOD = PDB_PERIOD;
+  PDB0_SC = PDB_CONFIG | PDB_SC_LDOK;
+  PDB0_SC = PDB_CONFIG | PDB_SC_SWTRIG;
+  PDB0_CH0C1 = 0x0101;
+
+  // one 16-bit sample per request, wrapping round the whole ring, interrupting at each half
+  dma.TCD->SADDR = dacBuffer;
+  dma.TCD->SOFF = 2;
+  dma.TCD->ATTR = DMA_TCD_ATTR_SSIZE(1) | DMA_TCD_ATTR_DSIZE(1);
+  dma.TCD->NBYTES_MLNO = 2;
+  dma.TCD->SLAST = -(int32_t)sizeof(dacBuffer);
+  dma.TCD->DADDR = &DAC0_DAT0L;
+  dma.TCD->DOFF = 0;
+  dma.TCD->CITER_ELINKNO = sizeof(dacBuffer) / 2;
+  dma.TCD->DLASTSGA = 0;
+  dma.TCD->BITER_ELINKNO = sizeof(dacBuffer) / 2;
+  dma.TCD->CSR = DMA_TCD_CSR_INTHALF | DMA_TCD_CSR_INTMAJOR;
+  dma.triggerAtHardwareEvent(DMAMUX_SOURCE_PDB);
+  dma.attachInterrupt(BlockInterrupt);
+  dma.enable();
+}
+
+AudioLoad AudioOutput_GetLoad(void)
+{
+  AudioLoad copy;
+  copy.blocks = load.blocks;
+  copy.lastCycles = load.lastCycles;
+  copy.peakCycles = load.peakCycles;
+  copy.budgetCycles = load.budgetCycles;
+  return copy;
+}
+
+void AudioOutput_PrintLoad(void)
+{
+  const AudioLoad copy = AudioOutput_GetLoad();
+  Serial.printf("audio: %u blocks, mixer %u cycles per block (peak %u) of %u, %u.%u%% load\n",
+    (unsigned int)copy.blocks, (unsigned int)copy.lastCycles, (unsigned int)copy.peakCycles, (unsigned int)copy.budgetCycles,
+    (unsigned int)(copy.lastCycles * 100 / copy.budgetCycles), (unsigned int)(copy.lastCycles * 1000 / copy.budgetCycles % 10));
+}
+
+static void BlockInterrupt(void)
+{
+  const uint32_t start = ARM_DWT_CYCCNT;
+
+  // refill whichever half the DMA is not reading
+  const uintptr_t sourceAddress = (uintptr_t)dma.TCD->SADDR;
+  dma.clearInterrupt();
+  uint16_t *destination = (sourceAddress < (uintptr_t)dacBuffer + sizeof(dacBuffer) / 2) ? dacBuffer + AUDIO_BLOCK_SAMPLES : dacBuffer;
+
+  int16_t block[AUDIO_BLOCK_SAMPLES];
+  AudioMixer_RenderBlock(block);
+  for (unsigned int i = 0; i < AUDIO_BLOCK_SAMPLES; i++)
+    destination[i] = (uint16_t)(block[i] + 32768) >> 4;
+
+  const uint32_t cycles = ARM_DWT_CYCCNT - start;
+  load.blocks = load.blocks + 1;
+  load.lastCycles = cycles;
+  if (cycles > load.peakCycles)
+    load.peakCycles = cycles;
+}
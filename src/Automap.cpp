@@ -0,0 +1,238 @@
+#include "Automap.hpp"
+
+#include <math.h>
+#include <string.h>
+
+Automap::Automap(Raycaster *raycaster)
+{
+  this->raycaster = raycaster;
+  mapWidth = raycaster->mapWidth < AUTOMAP_MAX_MAP_WIDTH ? raycaster->mapWidth : AUTOMAP_MAX_MAP_WIDTH;
+  mapHeight = raycaster->mapHeight < AUTOMAP_MAX_MAP_HEIGHT ? raycaster->mapHeight : AUTOMAP_MAX_MAP_HEIGHT;
+  scale = AUTOMAP_DEFAULT_SCALE;
+  stats = AutomapStats();
+  stats.tiles = AUTOMAP_TILE_COUNT;
+
+  // the top right 48 x 48 of the OLED
+  SetWindow(80, 48, 0, 6);
+  Invalidate();
+}
+
+void Automap::SetWindow(unsigned int x, unsigned int width, unsigned int firstPage, unsigned int pages)
+{
+  windowX = x;
+  windowWidth = width;
+  windowFirstPage = firstPage;
+  windowPages = pages;
+}
+
+void Automap::SetScale(unsigned int scale)
+{
+  if (scale < 1)
+    scale = 1;
+  if (scale > AUTOMAP_MAX_SCALE)
+    scale = AUTOMAP_MAX_SCALE;
+  if (scale == this->scale)
+    return;
+
+  this->scale = scale;
+  memset(dirtyTiles, 0xff, sizeof(dirtyTiles));
+}
+
+unsigned int Automap::GetScale(void)
+{
+  return scale;
+}
+
+void Automap::Invalidate(void)
+{
+  memset(image, 0, sizeof(image));
+  memset(dirtyTiles, 0, sizeof(dirtyTiles));
+  memset(drawnFaces, 0, sizeof(drawnFaces));
+  // every seen face now differs from what is drawn, so the next Draw compares them all
+  drawnChanges = raycaster->GetSeenChanges() - 1;
+}
+
+void Automap::Draw(DisplayWrapper *display, Vector2 player, Vector2 direction)
+{
+  stats.framesDrawn++;
+
+  if (raycaster->GetSeenChanges() != drawnChanges)
+  {
+    FindChangedCells();
+    drawnChanges = raycaster->GetSeenChanges();
+  }
+
+  unsigned int redrawn = 0;
+  for (unsigned int i = 0; i < sizeof(dirtyTiles); i++)
+  {
+    if (dirtyTiles[i] == 0)
+      continue;
+    for (unsigned int bit = 0; bit < 8; bit++)
+    {
+      if ((dirtyTiles[i] >> bit) & 1 && i * 8 + bit < AUTOMAP_TILE_COUNT)
+      {
+        RedrawTile(i * 8 + bit);
+        redrawn++;
+      }
+    }
+    dirtyTiles[i] = 0;
+  }
+  stats.lastTilesRedrawn = redrawn;
+  stats.tilesRedrawn += redrawn;
+
+  // the window, clipped to the display
+  const unsigned int displayWidth = display->GetWidth();
+  const unsigned int displayPages = display->GetHeight() / 8;
+  if (windowX >= displayWidth || windowFirstPage >= displayPages)
+    return;
+  const unsigned int width = (windowWidth < displayWidth - windowX) ? windowWidth : displayWidth - windowX;
+  const unsigned int pages = (windowPages < displayPages - windowFirstPage) ? windowPages : displayPages - windowFirstPage;
+  if (width == 0 || pages == 0)
+    return;
+  unsigned char *pageBuffer = display->GetPageBuffer();
+
+  // image pixel under the window's top left corner, with the player in the middle; image rows
+  // run down from the north edge of the map
+  const int centreX = width / 2;
+  const int centreY = pages * 4;
+  const int originX = (int)floorf(player.x * scale) - centreX;
+  const int originY = (mapHeight * scale - 1 - (int)floorf(player.y * scale)) - centreY;
+  const int firstImagePage = (originY >= 0) ? originY / 8 : -((7 - originY) / 8);
+  const int shift = originY - firstImagePage * 8;
+
+  for (unsigned int page = 0; page < pages; page++)
+  {
+    unsigned char *out = pageBuffer + (windowFirstPage + page) * displayWidth + windowX;
+    const int imagePage = firstImagePage + page;
+    for (unsigned int column = 0; column < width; column++)
+    {
+      const int imageColumn = originX + column;
+      unsigned char bits = ImageByte(imagePage, imageColumn) >> shift;
+      if (shift != 0)
+        bits |= ImageByte(imagePage + 1, imageColumn) << (8 - shift);
+      out[column] = bits;
+    }
+  }
+
+  // border
+  unsigned char *top = pageBuffer + windowFirstPage * displayWidth + windowX;
+  unsigned char *bottom = pageBuffer + (windowFirstPage + pages - 1) * displayWidth + windowX;
+  for (unsigned int column = 0; column < width; column++)
+  {
+    top[column] |= 0x01;
+    bottom[column] |= 0x80;
+  }
+  for (unsigned int page = 0; page < pages; page++)
+  {
+    top[page * displayWidth] = 0xff;
+    top[page * displayWidth + width - 1] = 0xff;
+  }
+
+  // the player, with a short line the way they are facing (screen y runs south)
+  for (int step = 0; step < 3; step++)
+  {
+    const int x = centreX + (int)lroundf(direction.x * step);
+    const int y = centreY - (int)lroundf(direction.y * step);
+    if (x >= 0 && x < (int)width && y >= 0 && y < (int)pages * 8)
+      SetPixel(pageBuffer, displayWidth, windowX + x, windowFirstPage * 8 + y);
+  }
+}
+
+AutomapStats Automap::GetStats(void)
+{
+  return stats;
+}
+
+void Automap::FindChangedCells(void)
+{
+  const uint8_t *seen = raycaster->GetSeenFaceBits();
+  const unsigned int cells = raycaster->mapWidth * raycaster->mapHeight;
+  const unsigned int bytes = ((cells + 1) / 2 < RAYCASTER_SEEN_BYTES) ? (cells + 1) / 2 : RAYCASTER_SEEN_BYTES;
+
+  // two cells per byte, so most bytes match and are skipped whole
+  for (unsigned int i = 0; i < bytes; i++)
+  {
+    const uint8_t changed = seen[i] ^ drawnFaces[i];
+    if (changed == 0)
+      continue;
+
+    drawnFaces[i] = seen[i];
+    for (unsigned int half = 0; half < 2; half++)
+    {
+      if ((changed >> (half * 4)) & 0x0f)
+      {
+        const unsigned int cell = i * 2 + half;
+        MarkCellDirty(cell % raycaster->mapWidth, cell / raycaster->mapWidth);
+      }
+    }
+  }
+}
+
+void Automap::MarkCellDirty(int x, int y)
+{
+  if (x >= mapWidth || y >= mapHeight)
+    return;
+
+  const int left = x * scale;
+  const int top = (mapHeight - 1 - y) * scale;
+  for (int tileY = top / 8; tileY <= (int)(top + scale - 1) / 8; tileY++)
+  {
+    for (int tileX = left / 8; tileX <= (int)(left + scale - 1) / 8; tileX++)
+    {
+      const unsigned int tile = tileY * AUTOMAP_TILES_ACROSS + tileX;
+      dirtyTiles[tile >> 3] |= 1 << (tile & 7);
+    }
+  }
+}
+
+void Automap::RedrawTile(unsigned int tile)
+{
+  const unsigned int page = tile / AUTOMAP_TILES_ACROSS;
+  const unsigned int firstColumn = (tile % AUTOMAP_TILES_ACROSS) * 8;
+  const unsigned int columns = mapWidth * scale;
+  const unsigned int rows = mapHeight * scale;
+
+  for (unsigned int imageX = firstColumn; imageX < firstColumn + 8 && imageX < AUTOMAP_IMAGE_WIDTH; imageX++)
+  {
+    unsigned char bits = 0;
+    if (imageX < columns)
+    {
+      const unsigned int x = imageX / scale;
+      const unsigned int insideX = imageX % scale;
+      for (unsigned int bit = 0; bit < 8; bit++)
+      {
+        const unsigned int imageY = page * 8 + bit;
+        if (imageY >= rows)
+          break;
+
+        const unsigned int y = mapHeight - 1 - imageY / scale;
+        const unsigned int insideY = imageY % scale;
+        const unsigned int cell = y * raycaster->mapWidth + x;
+        if (cell >= RAYCASTER_SEEN_BYTES * 2)
+          continue;
+
+        // each seen face is the edge of the wall cell on its side
+        const unsigned int faces = (drawnFaces[cell >> 1] >> ((cell & 1) * 4)) & 0x0f;
+        if (((faces >> FaceWest) & 1 && insideX == 0)
+            || ((faces >> FaceEast) & 1 && insideX == scale - 1)
+            || ((faces >> FaceNorth) & 1 && insideY == 0)
+            || ((faces >> FaceSouth) & 1 && insideY == scale - 1))
+          bits |= 1 << bit;
+      }
+    }
+    image[page * AUTOMAP_IMAGE_WIDTH + imageX] = bits;
+  }
+}
+
+unsigned char Automap::ImageByte(int page, int column)
+{
+  if (page < 0 || page >= AUTOMAP_IMAGE_PAGES || column < 0 || column >= AUTOMAP_IMAGE_WIDTH)
+    return 0;
+
+  return image[page * AUTOMAP_IMAGE_WIDTH + column];
+}
+
+void Automap::SetPixel(uint8_t *pages, unsigned int displayWidth, int x, int y)
+{
+  pages[(y >> 3) * displayWidth + x] |= 1 << (y & 7);
+}
@@ -0,0 +1,261 @@
+#include "EntityStore.hpp"
+
+#include <math.h>
+#include <string.h>
+
+EntityStore::EntityStore(int mapWidth, int mapHeight, int *worldMap)
+{
+  this->mapWidth = mapWidth;
+  this->mapHeight = mapHeight;
+  this->worldMap = worldMap;
+
+  // a map bigger than the index can hold is indexed as one cell
+  indexedCells = (mapWidth * mapHeight <= ENTITY_MAX_MAP_CELLS) ? mapWidth * mapHeight : 1;
+  Clear();
+}
+
+EntityHandle EntityStore::Add(Vector2 position, Vector2 velocity, uint8_t sprite, uint8_t flags)
+{
+  if (freeCount == 0)
+    return ENTITY_INVALID;
+
+  const EntityHandle handle = freeHandles[--freeCount];
+  const unsigned int index = count++;
+  positionX[index] = position.x;
+  positionY[index] = position.y;
+  velocityX[index] = velocity.x;
+  velocityY[index] = velocity.y;
+  spriteId[index] = sprite;
+  this->flags[index] = flags;
+  handles[index] = handle;
+  indexOfHandle[handle] = index;
+  return handle;
+}
+
+void EntityStore::Remove(EntityHandle handle)
+{
+  const int index = GetIndex(handle);
+  if (index < 0)
+    return;
+
+  // the last entity fills the hole
+  const unsigned int last = --count;
+  positionX[index] = positionX[last];
+  positionY[index] = positionY[last];
+  velocityX[index] = velocityX[last];
+  velocityY[index] = velocityY[last];
+  spriteId[index] = spriteId[last];
+  flags[index] = flags[last];
+  handles[index] = handles[last];
+  indexOfHandle[handles[index]] = index;
+
+  indexOfHandle[handle] = ENTITY_INVALID;
+  freeHandles[freeCount++] = handle;
+}
+
+void EntityStore::Clear(void)
+{
+  count = 0;
+  freeCount = ENTITY_MAX_COUNT;
+  for (unsigned int i = 0; i < ENTITY_MAX_COUNT; i++)
+  {
+    indexOfHandle[i] = ENTITY_INVALID;
+    // handed out lowest first
+    freeHandles[i] = ENTITY_MAX_COUNT - 1 - i;
+  }
+  memset(cellStart, 0, sizeof(cellStart));
+}
+
+bool EntityStore::IsAlive(EntityHandle handle)
+{
+  return GetIndex(handle) >= 0;
+}
+
+int EntityStore::GetIndex(EntityHandle handle)
+{
+  if (handle >= ENTITY_MAX_COUNT || indexOfHandle[handle] == ENTITY_INVALID)
+    return -1;
+
+  return indexOfHandle[handle];
+}
+
+unsigned int EntityStore::GetCount(void)
+{
+  return count;
+}
+
+Vector2 EntityStore::GetPosition(EntityHandle handle)
+{
+  const int index = GetIndex(handle);
+  if (index < 0)
+    return Vector2();
+
+  return Vector2(positionX[index], positionY[index]);
+}
+
+void EntityStore::SetPosition(EntityHandle handle, Vector2 position)
+{
+  const int index = GetIndex(handle);
+  if (index < 0)
+    return;
+
+  positionX[index] = position.x;
+  positionY[index] = position.y;
+}
+
+void EntityStore::SetVelocity(EntityHandle handle, Vector2 velocity)
+{
+  const int index = GetIndex(handle);
+  if (index < 0)
+    return;
+
+  velocityX[index] = velocity.x;
+  velocityY[index] = velocity.y;
+}
+
+void EntityStore::Update(float deltaTime)
+{
+  memset(cellStart, 0, (indexedCells + 1) * sizeof(cellStart[0]));
+
+  for (unsigned int i = 0; i < count; i++)
+  {
+    if (flags[i] & EntityMoving)
+    {
+      // one axis at a time, so an entity sliding along a wall keeps the other component
+      const float x = positionX[i] + velocityX[i] * deltaTime;
+      if ((flags[i] & EntitySolid) && IsWall(x, positionY[i]))
+        velocityX[i] = -velocityX[i];
+      else
+        positionX[i] = x;
+
+      const float y = positionY[i] + velocityY[i] * deltaTime;
+      if ((flags[i] & EntitySolid) && IsWall(positionX[i], y))
+        velocityY[i] = -velocityY[i];
+      else
+        positionY[i] = y;
+    }
+
+    cell[i] = CellOf(positionX[i], positionY[i]);
+    cellStart[cell[i] + 1]++;
+  }
+
+  // counts to start offsets, then each entity goes to the end of its cell's run; that leaves
+  // cellStart[c] at the end of cell c, so it is shifted back up by one cell afterwards
+  for (unsigned int c = 1; c <= indexedCells; c++)
+    cellStart[c] += cellStart[c - 1];
+  for (unsigned int i = 0; i < count; i++)
+    cellEntities[cellStart[cell[i]]++] = handles[i];
+  for (unsigned int c = indexedCells; c > 0; c--)
+    cellStart[c] = cellStart[c - 1];
+  cellStart[0] = 0;
+}
+
+unsigned int EntityStore::QueryRadius(Vector2 centre, float radius, EntityHandle *results, unsigned int maxResults)
+{
+  const float x = centre.x;
+  const float y = centre.y;
+  const float radiusSquared = radius * radius;
+  int left = (int)floorf(x - radius);
+  int right = (int)floorf(x + radius);
+  int top = (int)floorf(y - radius);
+  int bottom = (int)floorf(y + radius);
+  if (indexedCells == 1)
+  {
+    left = right = top = bottom = 0;
+  }
+  else
+  {
+    // entities outside the map were filed under the nearest edge cell
+    left = (left < 0) ? 0 : ((left >= mapWidth) ? mapWidth - 1 : left);
+    right = (right < 0) ? 0 : ((right >= mapWidth) ? mapWidth - 1 : right);
+    top = (top < 0) ? 0 : ((top >= mapHeight) ? mapHeight - 1 : top);
+    bottom = (bottom < 0) ? 0 : ((bottom >= mapHeight) ? mapHeight - 1 : bottom);
+  }
+
+  unsigned int found = 0;
+  for (int cellY = top; cellY <= bottom; cellY++)
+  {
+    for (int cellX = left; cellX <= right; cellX++)
+    {
+      const unsigned int c = (indexedCells == 1) ? 0 : cellY * mapWidth + cellX;
+      for (unsigned int k = cellStart[c]; k < cellStart[c + 1]; k++)
+      {
+        // removed (or removed and reused) since the index was built: checked by position
+        const int index = GetIndex(cellEntities[k]);
+        if (index < 0)
+          continue;
+
+        const float dx = positionX[index] - x;
+        const float dy = positionY[index] - y;
+        if (dx * dx + dy * dy > radiusSquared)
+          continue;
+        if (found == maxResults)
+          return found;
+        results[found++] = cellEntities[k];
+      }
+    }
+  }
+
+  return found;
+}
+
+EntityHandle EntityStore::FindOverlap(EntityHandle handle, float radius)
+{
+  const int index = GetIndex(handle);
+  if (index < 0)
+    return ENTITY_INVALID;
+
+  EntityHandle nearby[8];
+  const unsigned int found = QueryRadius(Vector2(positionX[index], positionY[index]), radius, nearby, 8);
+  for (unsigned int i = 0; i < found; i++)
+  {
+    if (nearby[i] != handle)
+      return nearby[i];
+  }
+
+  return ENTITY_INVALID;
+}
+
+bool EntityStore::IsWall(float x, float y)
+{
+  // same cells as Raycaster::WallAtMapPosition: columns are mirrored, outside the map is wall
+  const int column = mapWidth - 1 - (int)floorf(x);
+  const int row = (int)floorf(y);
+  if (column < 0 || column >= mapWidth || row < 0 || row >= mapHeight)
+    return true;
+
+  return worldMap[row * mapWidth + column] != 0;
+}
+
+unsigned int EntityStore::SubmitSprites(SpriteRenderer *sprites, Vector2 camera, float range, VisibilitySet *visibility)
+{
+  EntityHandle nearby[MAX_SPRITES];
+  const unsigned int found = QueryRadius(camera, range, nearby, MAX_SPRITES);
+
+  sprites->Clear();
+  unsigned int submitted = 0;
+  for (unsigned int i = 0; i < found; i++)
+  {
+    const int index = GetIndex(nearby[i]);
+    if (!(flags[index] & EntityVisible))
+      continue;
+    if (visibility != nullptr && !visibility->IsPotentiallyVisible(camera, Vector2(positionX[index], positionY[index])))
+      continue;
+    sprites->AddSprite(Vector2(positionX[index], positionY[index]), spriteId[index]);
+    submitted++;
+  }
+
+  return submitted;
+}
+
+int EntityStore::CellOf(float x, float y)
+{
+  if (indexedCells == 1)
+    return 0;
+
+  int cellX = (int)floorf(x);
+  int cellY = (int)floorf(y);
+  cellX = (cellX < 0) ? 0 : ((cellX >= mapWidth) ? mapWidth - 1 : cellX);
+  cellY = (cellY < 0) ? 0 : ((cellY >= mapHeight) ? mapHeight - 1 : cellY);
+  return cellY * mapWidth + cellX;
+}
@@ -0,0 +1,135 @@
+#include "FlowField.hpp"
+
+#include <math.h>
+
+// the high bits of a cell's byte are the search that last wrote it, the low bits its direction
+#define GENERATION_SHIFT 3
+#define GENERATION_COUNT (1 << (8 - GENERATION_SHIFT))
+#define DIRECTION_MASK ((1 << GENERATION_SHIFT) - 1)
+
+// neighbour offsets by FlowDirection
+static const int stepX[4] = { 1, 0, -1, 0 };
+static const int stepY[4] = { 0, 1, 0, -1 };
+
+FlowField::FlowField(int mapWidth, int mapHeight, int *worldMap)
+{
+  this->mapWidth = mapWidth;
+  this->mapHeight = mapHeight;
+  this->worldMap = worldMap;
+  goalCell = -1;
+  queueHead = 0;
+  queueTail = 0;
+  generation = 0;
+  stats = FlowFieldStats();
+
+  for (int i = 0; i < FLOW_FIELD_MAX_CELLS; i++)
+    field[i] = FlowUnreached;
+}
+
+void FlowField::SetGoal(Vector2 position)
+{
+  const int x = (int)floor(position.x);
+  const int y = (int)floor(position.y);
+  // a map too big for the field never gets a goal, so every cell stays unreached
+  if (mapWidth * mapHeight > FLOW_FIELD_MAX_CELLS || !IsOpen(x, y))
+    return;
+
+  const int cell = y * mapWidth + x;
+  if (cell == goalCell)
+    return;
+
+  if (queueHead < queueTail)
+    stats.restarts++;
+
+  // A new generation makes every cell unvisited for this search without touching it. Generation 0
+  // is never searched with: when the counter wraps, every cell goes back to it first, so no cell
+  // left unreached by an abandoned search can look visited to a later one
+  generation++;
+  if (generation == GENERATION_COUNT)
+  {
+    for (int i = 0; i < FLOW_FIELD_MAX_CELLS; i++)
+      field[i] &= DIRECTION_MASK;
+    generation = 1;
+  }
+  goalCell = cell;
+  field[cell] = (generation << GENERATION_SHIFT) | FlowGoal;
+  queue[0] = cell;
+  queueHead = 0;
+  queueTail = 1;
+}
+
+void FlowField::Update(unsigned int maxCells)
+{
+  unsigned int expanded = 0;
+
+  while (expanded < maxCells && queueHead < queueTail)
+  {
+    const int cell = queue[queueHead++];
+    const int x = cell % mapWidth;
+    const int y = cell / mapWidth;
+
+    for (int direction = 0; direction < 4; direction++)
+    {
+      const int neighbourX = x + stepX[direction];
+      const int neighbourY = y + stepY[direction];
+      if (!IsOpen(neighbourX, neighbourY))
+        continue;
+
+      const int neighbour = neighbourY * mapWidth + neighbourX;
+      if ((field[neighbour] >> GENERATION_SHIFT) == generation)
+        continue;
+
+      // the neighbour steps back the opposite way, towards this cell
+      field[neighbour] = (generation << GENERATION_SHIFT) | ((direction + 2) & 3);
+      queue[queueTail++] = neighbour;
+    }
+    expanded++;
+  }
+
+  stats.lastCellsExpanded = expanded;
+  if (expanded > 0 && queueHead == queueTail)
+  {
+    stats.passes++;
+    stats.lastPassCells = queueTail;
+  }
+}
+
+bool FlowField::IsSettled(void)
+{
+  return queueHead == queueTail;
+}
+
+FlowDirection FlowField::GetDirection(int x, int y)
+{
+  if (x < 0 || x >= mapWidth || y < 0 || y >= mapHeight || mapWidth * mapHeight > FLOW_FIELD_MAX_CELLS)
+    return FlowUnreached;
+
+  return (FlowDirection)(field[y * mapWidth + x] & DIRECTION_MASK);
+}
+
+bool FlowField::GetNextCellCentre(Vector2 position, Vector2 *centre)
+{
+  const int x = (int)floor(position.x);
+  const int y = (int)floor(position.y);
+  const FlowDirection direction = GetDirection(x, y);
+  if (direction >= FlowGoal)
+    return false;
+
+  centre->x = x + stepX[direction] + 0.5;
+  centre->y = y + stepY[direction] + 0.5;
+  return true;
+}
+
+FlowFieldStats FlowField::GetStats(void)
+{
+  return stats;
+}
+
+bool FlowField::IsOpen(int x, int y)
+{
+  // same cells as Raycaster::WallAtMapPosition: columns are mirrored
+  if (x < 0 || x >= mapWidth || y < 0 || y >= mapHeight)
+    return false;
+
+  return worldMap[y * mapWidth + (mapWidth - 1 - x)] == 0;
+}
@@ -0,0 +1,339 @@
+#include "FrameCapture.hpp"
+
+#include <string.h>
+
+// shortest run worth a run token; shorter repeats stay in the surrounding literal
+#define MIN_RUN 3
+#define MAX_RUN 129
+#define MAX_LITERAL 128
+
+enum CapturePhase
+{
+  SendFrameHeader,
+  SendData,
+  SendEnd
+};
+
+static bool active;
+static bool pending; // a snapshot is waiting or partly sent
+static CaptureFormat captureFormat;
+static unsigned int framesLeft;
+static uint32_t frameNumber; // frames rendered since the start, so skipped frames leave gaps
+static uint32_t framesSent;
+
+static CapturePhase phase;
+static CaptureDelta frameDelta;
+static unsigned int frameWidth;
+static unsigned int frameHeight;
+static unsigned int frameSize;
+static unsigned int position;
+static uint32_t sendingFrameNumber;
+static uint32_t frameMilliseconds;
+static uint32_t frameCost;
+static uint32_t frameChecksum;
+static bool storedFrame;
+
+static unsigned char snapshot[FRAME_CAPTURE_BUFFER_SIZE];
+// page frames only fill the first eighth of the snapshot, so the previous one lives in the next
+static unsigned char *const previousPages = snapshot + FRAME_CAPTURE_BUFFER_SIZE / 8;
+static bool havePreviousPages;
+
+static void Put16(unsigned char *bytes, unsigned int value);
+static void Put32(unsigned char *bytes, uint32_t value);
+static unsigned int RunLength(unsigned int start);
+static unsigned int PackedSize(void);
+static unsigned int EncodeChunk(unsigned char *out, unsigned int space);
+
+void FrameCapture_Start(CaptureFormat format, unsigned int frames)
+{
+  active = true;
+  pending = false;
+  captureFormat = format;
+  framesLeft = frames;
+  frameNumber = 0;
+  framesSent = 0;
+  havePreviousPages = false;
+}
+
+void FrameCapture_Stop(void)
+{
+  // a frame already going out is finished first, so the stream never ends mid-frame
+  framesLeft = 1;
+  if (!pending)
+    active = false;
+}
+
+bool FrameCapture_IsActive(void)
+{
+  return active;
+}
+
+CaptureFormat FrameCapture_GetFormat(void)
+{
+  return captureFormat;
+}
+
+bool FrameCapture_Snapshot(DisplayWrapper *display, uint32_t milliseconds, uint32_t frameMicroseconds)
+{
+  if (!active)
+    return false;
+  const uint32_t number = frameNumber++;
+  if (pending)
+    return false;
+
+  const unsigned int width = display->GetWidth();
+  const unsigned int height = display->GetHeight();
+  const unsigned int size = (captureFormat == CaptureGreyscale) ? width * height : width * height / 8;
+  if (size > ((captureFormat == CaptureGreyscale) ? sizeof(snapshot) : sizeof(snapshot) / 8))
+  {
+    active = false;
+    return false;
+  }
+
+  memcpy(snapshot, (captureFormat == CaptureGreyscale) ? display->GetBuffer() : display->GetPageBuffer(), size);
+  frameChecksum = FrameCapture_Checksum(snapshot, size);
+
+  // each delta is only used when it leaves more repeated bytes for PackBits than the raw frame:
+  // textured floors and a turning camera can make either one worse
+  unsigned int rawRepeats = 0;
+  unsigned int deltaRepeats = 0;
+  if (captureFormat == CaptureGreyscale)
+  {
+    for (unsigned int i = width + 1; i < size; i++)
+    {
+      rawRepeats += (snapshot[i] == snapshot[i - 1]);
+      deltaRepeats += ((snapshot[i] ^ snapshot[i - width]) == (snapshot[i - 1] ^ snapshot[i - 1 - width]));
+    }
+    frameDelta = (deltaRepeats > rawRepeats) ? DeltaRowAbove : DeltaNone;
+
+    // bottom up, so every row is XORed with the raw row above it
+    if (frameDelta == DeltaRowAbove)
+    {
+      for (unsigned int i = size - 1; i >= width; i--)
+        snapshot[i] ^= snapshot[i - width];
+    }
+  }
+  else
+  {
+    const bool keyframe = !havePreviousPages || framesSent % FRAME_CAPTURE_KEYFRAME_INTERVAL == 0;
+    if (!keyframe)
+    {
+      for (unsigned int i = 1; i < size; i++)
+      {
+        rawRepeats += (snapshot[i] == snapshot[i - 1]);
+        deltaRepeats += ((snapshot[i] ^ previousPages[i]) == (snapshot[i - 1] ^ previousPages[i - 1]));
+      }
+    }
+    frameDelta = (!keyframe && deltaRepeats > rawRepeats) ? DeltaPreviousFrame : DeltaNone;
+
+    for (unsigned int i = 0; i < size; i++)
+    {
+      const unsigned char raw = snapshot[i];
+      if (frameDelta == DeltaPreviousFrame)
+        snapshot[i] ^= previousPages[i];
+      previousPages[i] = raw;
+    }
+    havePreviousPages = true;
+  }
+
+  frameWidth = width;
+  frameHeight = height;
+  frameSize = size;
+  // noisy frames can come out of PackBits bigger than they went in
+  storedFrame = (PackedSize() >= size);
+  sendingFrameNumber = number;
+  frameMilliseconds = milliseconds;
+  frameCost = frameMicroseconds;
+  position = 0;
+  phase = SendFrameHeader;
+  pending = true;
+  return true;
+}
+
+unsigned int FrameCapture_Pump(unsigned char *out, unsigned int space)
+{
+  unsigned int written = 0;
+
+  while (pending)
+  {
+    unsigned char *packet = out + written;
+    const unsigned int room = space - written;
+
+    if (phase == SendFrameHeader)
+    {
+      if (room < FRAME_CAPTURE_FRAME_PACKET_SIZE)
+        break;
+      packet[0] = FRAME_CAPTURE_SYNC;
+      packet[1] = FRAME_CAPTURE_FRAME;
+      Put32(packet + 2, sendingFrameNumber);
+      Put32(packet + 6, frameMilliseconds);
+      Put32(packet + 10, frameCost);
+      packet[14] = captureFormat;
+      packet[15] = frameDelta | (storedFrame ? FRAME_CAPTURE_STORED : 0);
+      Put16(packet + 16, frameWidth);
+      Put16(packet + 18, frameHeight);
+      written += FRAME_CAPTURE_FRAME_PACKET_SIZE;
+      phase = SendData;
+    }
+    else if (phase == SendData)
+    {
+      // at least a run token's worth of payload, or nothing
+      if (room < 4 + 2)
+        break;
+      unsigned int payloadSpace = room - 4;
+      if (payloadSpace > FRAME_CAPTURE_CHUNK_SIZE)
+        payloadSpace = FRAME_CAPTURE_CHUNK_SIZE;
+
+      const unsigned int length = EncodeChunk(packet + 4, payloadSpace);
+      packet[0] = FRAME_CAPTURE_SYNC;
+      packet[1] = FRAME_CAPTURE_DATA;
+      Put16(packet + 2, length);
+      written += 4 + length;
+      if (position >= frameSize)
+        phase = SendEnd;
+    }
+    else
+    {
+      if (room < FRAME_CAPTURE_END_PACKET_SIZE)
+        break;
+      packet[0] = FRAME_CAPTURE_SYNC;
+      packet[1] = FRAME_CAPTURE_END;
+      Put32(packet + 2, frameChecksum);
+      written += FRAME_CAPTURE_END_PACKET_SIZE;
+
+      pending = false;
+      framesSent++;
+      if (framesLeft > 0 && --framesLeft == 0)
+        active = false;
+    }
+  }
+
+  return written;
+}
+
+unsigned int FrameCapture_UnpackBits(const unsigned char *packed, unsigned int packedLength, unsigned char *out, unsigned int space)
+{
+  unsigned int read = 0;
+  unsigned int written = 0;
+
+  while (read < packedLength)
+  {
+    const unsigned int control = packed[read++];
+    if (control < 128)
+    {
+      // control + 1 literal bytes
+      const unsigned int count = control + 1;
+      if (read + count > packedLength || written + count > space)
+        break;
+      memcpy(out + written, packed + read, count);
+      read += count;
+      written += count;
+    }
+    else
+    {
+      // one byte repeated control - 126 times
+      const unsigned int count = control - 126;
+      if (read >= packedLength || written + count > space)
+        break;
+      memset(out + written, packed[read++], count);
+      written += count;
+    }
+  }
+
+  return written;
+}
+
+uint32_t FrameCapture_Checksum(const unsigned char *bytes, unsigned int length)
+{
+  uint32_t hash = 2166136261u;
+  for (unsigned int i = 0; i < length; i++)
+    hash = (hash ^ bytes[i]) * 16777619u;
+  return hash;
+}
+
+static void Put16(unsigned char *bytes, unsigned int value)
+{
+  bytes[0] = value & 0xff;
+  bytes[1] = (value >> 8) & 0xff;
+}
+
+static void Put32(unsigned char *bytes, uint32_t value)
+{
+  Put16(bytes, value & 0xffff);
+  Put16(bytes + 2, value >> 16);
+}
+
+static unsigned int RunLength(unsigned int start)
+{
+  unsigned int length = 1;
+  while (start + length < frameSize && length < MAX_RUN && snapshot[start + length] == snapshot[start])
+    length++;
+  return length;
+}
+
+// PackBits bytes for the whole snapshot, chunk boundaries aside
+static unsigned int PackedSize(void)
+{
+  unsigned int packed = 0;
+  unsigned int start = 0;
+  unsigned int literal = 0;
+
+  while (start < frameSize)
+  {
+    const unsigned int run = RunLength(start);
+    if (run >= MIN_RUN)
+    {
+      packed += 2;
+      start += run;
+      literal = 0;
+      continue;
+    }
+
+    // a control byte for every MAX_LITERAL bytes of a literal
+    packed += (literal % MAX_LITERAL == 0) ? 2 : 1;
+    literal++;
+    start++;
+  }
+
+  return packed;
+}
+
+// PackBits tokens from the current position until the chunk is full or the frame ends; stored
+// frames are copied as they are
+static unsigned int EncodeChunk(unsigned char *out, unsigned int space)
+{
+  unsigned int written = 0;
+
+  if (storedFrame)
+  {
+    written = (frameSize - position < space) ? frameSize - position : space;
+    memcpy(out, snapshot + position, written);
+    position += written;
+    return written;
+  }
+
+  while (position < frameSize && written + 2 <= space)
+  {
+    const unsigned int run = RunLength(position);
+    if (run >= MIN_RUN)
+    {
+      out[written++] = (unsigned char)(run + 126);
+      out[written++] = snapshot[position];
+      position += run;
+      continue;
+    }
+
+    // literal: up to the next worthwhile run, the token limit or the end of the chunk
+    unsigned int count = 0;
+    const unsigned int maxCount = (space - written - 1 < MAX_LITERAL) ? space - written - 1 : MAX_LITERAL;
+    while (count < maxCount && position + count < frameSize && (count == 0 || RunLength(position + count) < MIN_RUN))
+      count++;
+
+    out[written++] = (unsigned char)(count - 1);
+    memcpy(out + written, snapshot + position, count);
+    written += count;
+    position += count;
+  }
+
+  return written;
+}
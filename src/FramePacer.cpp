@@ -0,0 +1,117 @@
+#include "FramePacer.hpp"
+
+#include <math.h>
+
+// weight of the newest frame in the running averages
+#define FRAME_PACER_SMOOTHING (1.0f / 16.0f)
+
+static SchedulerClock pacerClock;
+static void (*pacerIdle)(void);
+static uint32_t interval;
+static DeltaTimeMode deltaTimeMode = SmoothedDelta;
+
+static bool started;
+static uint32_t frameStart;
+static uint32_t nextFrame;
+static uint32_t busyMicroseconds;
+static float measuredDelta;
+static float smoothedDelta;
+static float frameVariance;
+static FramePacerStats stats;
+
+void FramePacer_Init(SchedulerClock clock, void (*idle)(void))
+{
+  pacerClock = clock;
+  pacerIdle = idle;
+  started = false;
+  stats = FramePacerStats();
+  frameVariance = 0.0f;
+}
+
+void FramePacer_SetInterval(uint32_t intervalMicroseconds)
+{
+  interval = intervalMicroseconds;
+  started = false;
+}
+
+void FramePacer_SetDeltaTimeMode(DeltaTimeMode mode)
+{
+  deltaTimeMode = mode;
+}
+
+double FramePacer_StartFrame(void)
+{
+  const uint32_t now = pacerClock();
+
+  if (!started)
+  {
+    // first frame: nothing measured yet, assume one interval (or a 30 fps frame)
+    started = true;
+    frameStart = now;
+    nextFrame = now + interval;
+    measuredDelta = (interval > 0) ? interval * 1e-6f : 1.0f / 30.0f;
+    smoothedDelta = measuredDelta;
+    stats.meanFrameMicroseconds = smoothedDelta * 1e6f;
+  }
+  else
+  {
+    const uint32_t frameMicroseconds = now - frameStart;
+    frameStart = now;
+
+    stats.frames++;
+    const float deviation = frameMicroseconds - stats.meanFrameMicroseconds;
+    stats.meanFrameMicroseconds += deviation * FRAME_PACER_SMOOTHING;
+    frameVariance += (deviation * deviation - frameVariance) * FRAME_PACER_SMOOTHING;
+    stats.frameMicrosecondsDeviation = sqrtf(frameVariance);
+    if (frameMicroseconds > 0)
+      stats.utilisation += ((float)busyMicroseconds / frameMicroseconds - stats.utilisation) * FRAME_PACER_SMOOTHING;
+
+    measuredDelta = frameMicroseconds * 1e-6f;
+    if (measuredDelta > FRAME_PACER_MAX_DELTA)
+      measuredDelta = FRAME_PACER_MAX_DELTA;
+    smoothedDelta += (measuredDelta - smoothedDelta) * FRAME_PACER_SMOOTHING;
+  }
+
+  switch (deltaTimeMode)
+  {
+  case MeasuredDelta:
+    return measuredDelta;
+  case FixedDelta:
+    if (interval > 0)
+      return interval * 1e-6;
+    return smoothedDelta;
+  case SmoothedDelta:
+  default:
+    return smoothedDelta;
+  }
+}
+
+void FramePacer_FinishFrame(void)
+{
+  const uint32_t finish = pacerClock();
+  busyMicroseconds = finish - frameStart;
+
+  if (interval == 0)
+    return;
+
+  // a late frame starts the next one straight away and the schedule restarts from it, rather
+  // than running short frames to catch up
+  if ((int32_t)(finish - nextFrame) >= 0)
+  {
+    stats.missedFrames++;
+    nextFrame = finish + interval;
+    return;
+  }
+
+  while ((int32_t)(nextFrame - pacerClock()) > FRAME_PACER_SPIN_MICROSECONDS)
+    pacerIdle();
+  while ((int32_t)(nextFrame - pacerClock()) > 0)
+    ;
+
+  nextFrame += interval;
+}
+
+FramePacerStats FramePacer_GetStats(void)
+{
+  return stats;
+}
@@ -1,7 +1,6 @@
 #include "Input.hpp"
 
 #include <Arduino.h>
-#include <queue>
 
 #define PIN_UP    17
 #define PIN_DOWN  18
@@ -10,14 +9,23 @@
 #define PIN_A      1
 #define PIN_B      0
 
-static std::map<Button, bool> isHeld;
-static std::map<Button, bool> wasPressed;
-static std::map<Button, bool> wasReleased;
+#define BUTTON_COUNT 6
+// presses queued by the pin interrupts, drained by Input_Clear; a power of two so indices wrap with a mask
+#define INPUT_QUEUE_SIZE 16
 
-static std::map<Button, uint8_t> buttonToPin;
+// everything is indexed by Button and statically sized: the interrupts must not allocate
+static bool isHeld[BUTTON_COUNT];
+static bool wasPressed[BUTTON_COUNT];
+static bool wasReleased[BUTTON_COUNT];
 
-static std::queue<Button> inputQueue;
+static const uint8_t buttonToPin[BUTTON_COUNT] = { PIN_UP, PIN_DOWN, PIN_LEFT, PIN_RIGHT, PIN_A, PIN_B };
 
+// single producer (pin interrupts) and single consumer (Input_Clear)
+static volatile Button inputQueue[INPUT_QUEUE_SIZE];
+static volatile uint8_t inputQueueHead;
+static volatile uint8_t inputQueueTail;
+
+static void QueuePress(Button button);
 static void ToggleUp(void);
 static void ToggleDown(void);
 static void ToggleLeft(void);
@@ -29,68 +37,49 @@ void Input_InitPins(void)
 {
   pinMode(PIN_UP, INPUT_PULLUP);
   attachInterrupt(digitalPinToInterrupt(PIN_UP), ToggleUp, RISING);
-  isHeld.insert(std::pair<Button, bool>(Button::Up, (digitalRead(PIN_UP) == LOW)));
-  wasPressed.insert(std::pair<Button, bool>(Button::Up, false));
-  wasReleased.insert(std::pair<Button, bool>(Button::Up, false));
-  buttonToPin.insert(std::pair<Button, uint8_t>(Button::Up, PIN_UP));
 
   pinMode(PIN_DOWN, INPUT_PULLUP);
   attachInterrupt(digitalPinToInterrupt(PIN_DOWN), ToggleDown, RISING);
-  isHeld.insert(std::pair<Button, bool>(Button::Down, (digitalRead(PIN_DOWN) == LOW)));
-  wasPressed.insert(std::pair<Button, bool>(Button::Down, false));
-  wasReleased.insert(std::pair<Button, bool>(Button::Down, false));
-  buttonToPin.insert(std::pair<Button, uint8_t>(Button::Down, PIN_DOWN));
 
   pinMode(PIN_LEFT, INPUT_PULLUP);
   attachInterrupt(digitalPinToInterrupt(PIN_LEFT), ToggleLeft, RISING);
-  isHeld.insert(std::pair<Button, bool>(Button::Left, (digitalRead(PIN_LEFT) == LOW)));
-  wasPressed.insert(std::pair<Button, bool>(Button::Left, false));
-  wasReleased.insert(std::pair<Button, bool>(Button::Left, false));
-  buttonToPin.insert(std::pair<Button, uint8_t>(Button::Left, PIN_LEFT));
 
   pinMode(PIN_RIGHT, INPUT_PULLUP);
   attachInterrupt(digitalPinToInterrupt(PIN_RIGHT), ToggleRight, RISING);
-  isHeld.insert(std::pair<Button, bool>(Button::Right, (digitalRead(PIN_RIGHT) == LOW)));
-  wasPressed.insert(std::pair<Button, bool>(Button::Right, false));
-  wasReleased.insert(std::pair<Button, bool>(Button::Right, false));
-  buttonToPin.insert(std::pair<Button, uint8_t>(Button::Right, PIN_RIGHT));
 
   pinMode(PIN_A, INPUT_PULLUP);
   attachInterrupt(digitalPinToInterrupt(PIN_A), ToggleA, RISING);
-  isHeld.insert(std::pair<Button, bool>(Button::A, (digitalRead(PIN_A) == LOW)));
-  wasPressed.insert(std::pair<Button, bool>(Button::A, false));
-  wasReleased.insert(std::pair<Button, bool>(Button::A, false));
-  buttonToPin.insert(std::pair<Button, uint8_t>(Button::A, PIN_A));
 
   pinMode(PIN_B, INPUT_PULLUP);
   attachInterrupt(digitalPinToInterrupt(PIN_B), ToggleB, RISING);
-  isHeld.insert(std::pair<Button, bool>(Button::B, (digitalRead(PIN_B) == LOW)));
-  wasPressed.insert(std::pair<Button, bool>(Button::B, false));
-  wasReleased.insert(std::pair<Button, bool>(Button::B, false));
-  buttonToPin.insert(std::pair<Button, uint8_t>(Button::B, PIN_B));
+
+  for (int button = 0; button < BUTTON_COUNT; button++)
+  {
+    isHeld[button] = (digitalRead(buttonToPin[button]) == LOW);
+    wasPressed[button] = false;
+    wasReleased[button] = false;
+  }
 }
 
 void Input_Clear(void)
 {
   // clear all previous wasPressed & wasReleased states
-  for (auto it = wasPressed.begin(); it != wasPressed.end(); ++it)
-    it->second = false;
-
-  for (auto it = wasReleased.begin(); it != wasReleased.end(); ++it)
-    it->second = false;
+  for (int button = 0; button < BUTTON_COUNT; button++)
+  {
+    wasPressed[button] = false;
+    wasReleased[button] = false;
+  }
 
   // dequeue any new button presses
-  while (inputQueue.size() > 0)
+  while (inputQueueTail != inputQueueHead)
   {
-    wasPressed[inputQueue.front()] = true;
-    inputQueue.pop();
+    wasPressed[inputQueue[inputQueueTail]] = true;
+    inputQueueTail = (inputQueueTail + 1) & (INPUT_QUEUE_SIZE - 1);
   }
 
-  for (auto it = buttonToPin.begin(); it != buttonToPin.end(); ++it)
+  for (int button = 0; button < BUTTON_COUNT; button++)
   {
-    const Button button = it->first;
-    const byte pin = it->second;
-    const bool buttonState = digitalRead(pin) == LOW;
+    const bool buttonState = digitalRead(buttonToPin[button]) == LOW;
 
     if (isHeld[button] && !buttonState)
       wasReleased[button] = true;
@@ -114,33 +103,42 @@ bool Input_WasReleased(Button button)
   return wasReleased[button];
 }
 
+static void QueuePress(Button button)
+{
+  const uint8_t next = (inputQueueHead + 1) & (INPUT_QUEUE_SIZE - 1);
+  if (next == inputQueueTail) // full: drop the press rather than overwrite unread ones
+    return;
+
+  inputQueue[inputQueueHead] = button;
+  inputQueueHead = next;
+}
 
 static void ToggleUp()
 {
-  inputQueue.push(Button::Up);
+  QueuePress(Button::Up);
 }
 
 static void ToggleDown()
 {
-  inputQueue.push(Button::Down);
+  QueuePress(Button::Down);
 }
 
 static void ToggleLeft()
 {
-  inputQueue.push(Button::Left);
+  QueuePress(Button::Left);
 }
 
 static void ToggleRight()
 {
-  inputQueue.push(Button::Right);
+  QueuePress(Button::Right);
 }
 
 static void ToggleA()
 {
-  inputQueue.push(Button::A);
+  QueuePress(Button::A);
 }
 
 static void ToggleB()
 {
-  inputQueue.push(Button::B);
+  QueuePress(Button::B);
 }
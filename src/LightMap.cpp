@@ -0,0 +1,279 @@
+#include "LightMap.hpp"
+
+#include <math.h>
+#include <string.h>
+
+// each face of a cell by WallFace: its outward normal, where it starts and which way it runs
+static const int normalX[4] = { -1, 1, 0, 0 };
+static const int normalY[4] = { 0, 0, -1, 1 };
+static const int startX[4] = { 0, 1, 0, 0 };
+static const int startY[4] = { 0, 0, 0, 1 };
+static const int alongX[4] = { 0, 0, 1, 1 };
+static const int alongY[4] = { 1, 1, 0, 0 };
+
+// rays end this far in front of the face, so they finish in the open cell it faces
+#define SURFACE_OFFSET (1.0f / 64.0f)
+
+LightMap::LightMap(Raycaster *raycaster)
+{
+  this->raycaster = raycaster;
+  mapWidth = raycaster->mapWidth;
+  mapHeight = raycaster->mapHeight;
+  pendingCount = 0;
+  nextFace = 0;
+  stats = LightMapStats();
+  stats.bytes = sizeof(LightMap);
+
+  for (int i = 0; i < LIGHT_MAP_MAX_LIGHTS; i++)
+    lights[i].used = false;
+  memset(faceLevels, 0, sizeof(faceLevels));
+  memset(dirtyFaces, 0, sizeof(dirtyFaces));
+}
+
+int LightMap::AddLight(Vector2 position, float radius, float intensity)
+{
+  for (int i = 0; i < LIGHT_MAP_MAX_LIGHTS; i++)
+  {
+    if (lights[i].used)
+      continue;
+
+    lights[i].position = position;
+    lights[i].radius = radius;
+    lights[i].intensity = intensity;
+    lights[i].enabled = true;
+    lights[i].used = true;
+    stats.lights++;
+    MarkLight(i);
+    return i;
+  }
+
+  return LIGHT_MAP_NO_LIGHT;
+}
+
+void LightMap::RemoveLight(int light)
+{
+  if (light < 0 || light >= LIGHT_MAP_MAX_LIGHTS || !lights[light].used)
+    return;
+
+  MarkLight(light);
+  lights[light].used = false;
+  stats.lights--;
+}
+
+void LightMap::MoveLight(int light, Vector2 position)
+{
+  if (light < 0 || light >= LIGHT_MAP_MAX_LIGHTS || !lights[light].used)
+    return;
+  if (position.x == lights[light].position.x && position.y == lights[light].position.y)
+    return;
+
+  // the faces it lit before and the faces it lights now
+  MarkLight(light);
+  lights[light].position = position;
+  MarkLight(light);
+}
+
+void LightMap::SetLightEnabled(int light, bool enabled)
+{
+  if (light < 0 || light >= LIGHT_MAP_MAX_LIGHTS || !lights[light].used || lights[light].enabled == enabled)
+    return;
+
+  // a disabled light marks nothing, so one of these is all it takes
+  MarkLight(light);
+  lights[light].enabled = enabled;
+  MarkLight(light);
+}
+
+void LightMap::Update(unsigned int maxFaces)
+{
+  const unsigned int faceCount = FaceCount();
+  unsigned int relit = 0;
+
+  while (relit < maxFaces && pendingCount > 0)
+  {
+    if (nextFace >= faceCount)
+      nextFace = 0;
+
+    // a whole byte of unmarked faces is skipped at once
+    if ((nextFace & 7) == 0 && dirtyFaces[nextFace >> 3] == 0)
+    {
+      nextFace += 8;
+      continue;
+    }
+
+    const unsigned int face = nextFace++;
+    const uint8_t mask = 1 << (face & 7);
+    if (!(dirtyFaces[face >> 3] & mask))
+      continue;
+
+    dirtyFaces[face >> 3] &= ~mask;
+    pendingCount--;
+
+    const unsigned int shift = (face & 1) * 4;
+    faceLevels[face >> 1] = (faceLevels[face >> 1] & ~(0x0f << shift)) | (LightFace(face) << shift);
+    relit++;
+  }
+
+  stats.lastFacesRelit = relit;
+  stats.facesRelit += relit;
+}
+
+void LightMap::Bake(void)
+{
+  const unsigned int faceCount = FaceCount();
+  for (unsigned int face = 0; face < faceCount; face++)
+    MarkFace(face);
+
+  while (!IsSettled())
+    Update(LIGHT_MAP_FACES_PER_FRAME);
+}
+
+bool LightMap::IsSettled(void)
+{
+  return pendingCount == 0;
+}
+
+void LightMap::TileChanged(int x, int y)
+{
+  // every light reaching the cell may now reach more or fewer faces behind it
+  for (int i = 0; i < LIGHT_MAP_MAX_LIGHTS; i++)
+  {
+    if (!lights[i].used || !lights[i].enabled)
+      continue;
+
+    const float dx = (x + 0.5f) - (float)lights[i].position.x;
+    const float dy = (y + 0.5f) - (float)lights[i].position.y;
+    const float reach = lights[i].radius + 0.75f;
+    if (dx * dx + dy * dy <= reach * reach)
+      MarkLight(i);
+  }
+}
+
+unsigned char LightMap::GetFaceLevel(int x, int y, WallFace face)
+{
+  if (x < 0 || x >= mapWidth || y < 0 || y >= mapHeight)
+    return 0;
+
+  const unsigned int index = (y * mapWidth + x) * 4 + face;
+  if (index >= FaceCount())
+    return 0;
+
+  return ((faceLevels[index >> 1] >> ((index & 1) * 4)) & 0x0f) * LIGHT_MAP_LEVEL_STEP;
+}
+
+LightMapStats LightMap::GetStats(void)
+{
+  stats.pendingFaces = pendingCount;
+  return stats;
+}
+
+bool LightMap::IsOpen(int x, int y)
+{
+  // same cells as Raycaster::WallAtMapPosition: columns are mirrored
+  if (x < 0 || x >= mapWidth || y < 0 || y >= mapHeight)
+    return false;
+
+  return raycaster->worldMap[y * mapWidth + (mapWidth - 1 - x)] == 0;
+}
+
+unsigned int LightMap::FaceCount(void)
+{
+  const unsigned int cells = mapWidth * mapHeight;
+  return ((cells < LIGHT_MAP_MAX_MAP_CELLS) ? cells : LIGHT_MAP_MAX_MAP_CELLS) * 4;
+}
+
+void LightMap::MarkLight(int light)
+{
+  const PointLight &source = lights[light];
+  if (!source.used || !source.enabled)
+    return;
+
+  // no sample on a face is more than half a cell from its centre
+  const float reach = source.radius + 0.5f;
+  const float lightX = (float)source.position.x;
+  const float lightY = (float)source.position.y;
+  const int firstX = ((int)floorf(lightX - reach) < 0) ? 0 : (int)floorf(lightX - reach);
+  const int firstY = ((int)floorf(lightY - reach) < 0) ? 0 : (int)floorf(lightY - reach);
+  const int lastX = ((int)floorf(lightX + reach) >= mapWidth) ? mapWidth - 1 : (int)floorf(lightX + reach);
+  const int lastY = ((int)floorf(lightY + reach) >= mapHeight) ? mapHeight - 1 : (int)floorf(lightY + reach);
+  const unsigned int faceCount = FaceCount();
+
+  for (int y = firstY; y <= lastY; y++)
+  {
+    for (int x = firstX; x <= lastX; x++)
+    {
+      const unsigned int cell = y * mapWidth + x;
+      if (cell * 4 >= faceCount)
+        continue;
+      // open cells have no faces, unless a tile has just been opened and they are still lit
+      if (IsOpen(x, y) && faceLevels[cell * 2] == 0 && faceLevels[cell * 2 + 1] == 0)
+        continue;
+
+      for (int side = 0; side < 4; side++)
+      {
+        const float dx = x + startX[side] + 0.5f * alongX[side] - lightX;
+        const float dy = y + startY[side] + 0.5f * alongY[side] - lightY;
+        if (dx * dx + dy * dy <= reach * reach)
+          MarkFace(cell * 4 + side);
+      }
+    }
+  }
+}
+
+void LightMap::MarkFace(unsigned int face)
+{
+  const uint8_t mask = 1 << (face & 7);
+  if (dirtyFaces[face >> 3] & mask)
+    return;
+
+  dirtyFaces[face >> 3] |= mask;
+  pendingCount++;
+}
+
+unsigned char LightMap::LightFace(unsigned int face)
+{
+  const int side = face & 3;
+  const int x = (face >> 2) % mapWidth;
+  const int y = (face >> 2) / mapWidth;
+
+  // only a wall face with open floor in front of it can be seen
+  if (IsOpen(x, y) || !IsOpen(x + normalX[side], y + normalY[side]))
+    return 0;
+
+  float light = 0.0f;
+  for (int i = 0; i < LIGHT_MAP_MAX_LIGHTS; i++)
+  {
+    const PointLight &source = lights[i];
+    if (!source.used || !source.enabled)
+      continue;
+
+    const float lightX = (float)source.position.x;
+    const float lightY = (float)source.position.y;
+    for (int sample = 0; sample < LIGHT_MAP_SAMPLES_PER_FACE; sample++)
+    {
+      const float along = (sample + 0.5f) / LIGHT_MAP_SAMPLES_PER_FACE;
+      const float pointX = x + startX[side] + along * alongX[side];
+      const float pointY = y + startY[side] + along * alongY[side];
+      const float toLightX = lightX - pointX;
+      const float toLightY = lightY - pointY;
+      const float distance = sqrtf(toLightX * toLightX + toLightY * toLightY);
+      if (distance >= source.radius || distance <= 0.0f)
+        continue;
+
+      // lights behind the face do nothing; in front, they fade with angle and distance
+      const float facing = (toLightX * normalX[side] + toLightY * normalY[side]) / distance;
+      if (facing <= 0.0f)
+        continue;
+
+      stats.raysCast++;
+      const Vector2 target(pointX + SURFACE_OFFSET * normalX[side], pointY + SURFACE_OFFSET * normalY[side]);
+      if (!raycaster->HasLineOfSight(source.position, target))
+        continue;
+
+      light += source.intensity * facing * (1.0f - distance / source.radius) / LIGHT_MAP_SAMPLES_PER_FACE;
+    }
+  }
+
+  const int level = (int)(light * (LIGHT_MAP_FACE_LEVELS - 1) + 0.5f);
+  return (level > LIGHT_MAP_FACE_LEVELS - 1) ? LIGHT_MAP_FACE_LEVELS - 1 : level;
+}
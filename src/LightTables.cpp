@@ -0,0 +1,24 @@
+#include "LightTables.hpp"
+
+static constexpr LightTables BuildLightTables(void)
+{
+  LightTables tables = {};
+
+  for (int level = 0; level < LIGHT_LEVEL_COUNT; level++)
+    for (int texel = 0; texel < 256; texel++)
+      tables.level[level][texel] = (unsigned char)((texel * level) >> LIGHT_LEVEL_SHIFT);
+
+  return tables;
+}
+
+constexpr LightTables lightTables = BuildLightTables();
+
+unsigned char LightTables_LevelForShade(double shade)
+{
+  if (shade <= 0.0)
+    return 0;
+  if (shade >= 1.0)
+    return LIGHT_LEVEL_MAX;
+
+  return (unsigned char)(shade * LIGHT_LEVEL_MAX);
+}
@@ -1,55 +1,178 @@
 #include "MelodyPlayer.hpp"
 
-#include <Arduino.h>
+struct Track
+{
+  const Note *notes;
+  uint16_t noteCount;
+  uint8_t priority;
+  bool loop;
+};
+
+struct PlayingTrack
+{
+  Track track;
+  uint16_t position;      // next note to start
+  uint16_t ticksLeft;     // of the current note
+  bool active;
+};
+
+// single producer (MelodyPlayer_Queue) and single consumer (the tick interrupt)
+struct TrackQueue
+{
+  Track tracks[MELODY_QUEUE_SIZE];
+  volatile uint8_t head;
+  volatile uint8_t tail;
+};
 
-static int _passiveBuzzerPin;
-static int *_melody;
-static int _melodyLength;
-static int _currentMelodyPosition;
-static IntervalTimer _noteTimer;
+static MelodyOutput _output;
 
+// one queue per priority, so a full queue of music never holds up an effect
+static TrackQueue _queues[MELODY_PRIORITY_COUNT];
+static volatile bool _stopRequested;
+
+// owned by the tick interrupt
+static PlayingTrack _current;
+// tracks pre-empted in turn, the last one by _current; priorities rise up the stack, so it holds
+// one track per priority below the top at most
+static PlayingTrack _suspended[MELODY_PRIORITY_COUNT - 1];
+static uint8_t _suspendedCount;
+static volatile bool _playing;
+
+static int WaitingPriority(void);
+static void StartTrack(const Track &track);
+static void SuspendCurrent(void);
 static void NextNote(void);
 
-void MelodyPlayer_SetPassiveBuzzerPin(int passiveBuzzerPin)
+void MelodyPlayer_Init(MelodyOutput output)
 {
-  _passiveBuzzerPin = passiveBuzzerPin;
+  _output = output;
 }
 
-void MelodyPlayer_SetMelody(const int *melody, const int arraySize)
+bool MelodyPlayer_Queue(const Note *notes, uint16_t noteCount, uint8_t priority, bool loop)
 {
-  if (_melody != nullptr)
-    delete(_melody);
+  if (priority >= MELODY_PRIORITY_COUNT || noteCount == 0)
+    return false;
 
-  _melodyLength = arraySize;
-  _melody = new int[_melodyLength];
+  TrackQueue &queue = _queues[priority];
+  const uint8_t next = (queue.head + 1) & (MELODY_QUEUE_SIZE - 1);
+  if (next == queue.tail)
+    return false;
 
-  for (int i = 0; i < _melodyLength; i++)
-    *(_melody + i) = melody[i];
+  // the slot is filled before the head moves, so the interrupt never sees a half-written track
+  Track &slot = queue.tracks[queue.head];
+  slot.notes = notes;
+  slot.noteCount = noteCount;
+  slot.priority = priority;
+  slot.loop = loop;
+  // volatile only orders the head against other volatiles, so the slot stores need a fence too
+  __asm__ volatile("" ::: "memory");
+  queue.head = next;
+  return true;
 }
 
-void MelodyPlayer_Play()
+void MelodyPlayer_Stop(void)
 {
-  _currentMelodyPosition = 0;
+  _stopRequested = true;
+}
 
-  NextNote();
+bool MelodyPlayer_IsPlaying(void)
+{
+  return _playing || WaitingPriority() >= 0;
 }
 
-static void NextNote(void)
+void MelodyPlayer_Tick(void)
 {
-  if (_currentMelodyPosition + 1 < _melodyLength)
+  if (_stopRequested)
   {
-    const int note = *(_melody + _currentMelodyPosition);
-    if (note > 31)
-      tone(_passiveBuzzerPin, note);
-    else
-      noTone(_passiveBuzzerPin);
-      
-    _noteTimer.begin(NextNote, *(_melody + _currentMelodyPosition + 1) * 1000);
-    _currentMelodyPosition += 2;
+    _stopRequested = false;
+    _current.active = false;
+    _suspendedCount = 0;
+    for (int priority = 0; priority < MELODY_PRIORITY_COUNT; priority++)
+      _queues[priority].tail = _queues[priority].head;
+    _output(0);
+  }
+
+  // take the most important waiting tracks while they outrank what is playing
+  int waiting;
+  while ((waiting = WaitingPriority()) >= 0 && (!_current.active || waiting > _current.track.priority))
+  {
+    if (_current.active)
+      SuspendCurrent();
+
+    // the head is read before the slot it published
+    __asm__ volatile("" ::: "memory");
+    TrackQueue &queue = _queues[waiting];
+    StartTrack(queue.tracks[queue.tail]);
+    queue.tail = (queue.tail + 1) & (MELODY_QUEUE_SIZE - 1);
   }
-  else
+
+  if (_current.active)
   {
-    noTone(_passiveBuzzerPin);
-    _noteTimer.end();
+    if (_current.ticksLeft > 0)
+      _current.ticksLeft--;
+    if (_current.ticksLeft == 0)
+      NextNote();
   }
+
+  _playing = _current.active;
+}
+
+// highest priority with a track waiting, -1 when every queue is empty
+static int WaitingPriority(void)
+{
+  for (int priority = MELODY_PRIORITY_COUNT - 1; priority >= 0; priority--)
+  {
+    if (_queues[priority].head != _queues[priority].tail)
+      return priority;
+  }
+
+  return -1;
+}
+
+static void StartTrack(const Track &track)
+{
+  _current.track = track;
+  _current.position = 0;
+  _current.ticksLeft = 0;
+  _current.active = true;
+}
+
+static void SuspendCurrent(void)
+{
+  _suspended[_suspendedCount++] = _current;
+}
+
+static void NextNote(void)
+{
+  // a resumed track may have been cut off in its last note, so it can be at its end too
+  while (_current.position >= _current.track.noteCount)
+  {
+    if (_current.track.loop)
+    {
+      _current.position = 0;
+      break;
+    }
+
+    // track finished: the last suspended one carries on with the note after the one it was cut
+    // off in, unless a waiting track outranks it; tracks of its own priority wait behind it
+    _current.active = false;
+    const PlayingTrack *resume = (_suspendedCount > 0) ? &_suspended[_suspendedCount - 1] : nullptr;
+    if (resume && WaitingPriority() <= resume->track.priority)
+    {
+      _current = *resume;
+      _current.ticksLeft = 0;
+      _suspendedCount--;
+    }
+    else
+    {
+      _output(0);
+      return;
+    }
+  }
+
+  const Note note = _current.track.notes[_current.position];
+  _output((note.frequency > 31) ? note.frequency : 0);
+
+  _current.ticksLeft = note.duration * 1000 / MELODY_TICK_MICROSECONDS;
+  _current.position++;
 }
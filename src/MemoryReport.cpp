@@ -0,0 +1,67 @@
+#include "MemoryReport.hpp"
+
+#include <Arduino.h>
+
+#include "StaticArena.hpp"
+
+#define STACK_PAINT 0xa5a5a5a5u
+// left unpainted below the stack pointer, painting must not overwrite its own frame
+#define STACK_PAINT_MARGIN 64
+
+// from the Teensy linker script
+extern unsigned long _sdata;
+extern unsigned long _ebss;
+extern unsigned long _estack;
+extern "C" char *sbrk(int increment);
+
+static char *startupHeapEnd;
+
+static inline char *StackPointer(void)
+{
+  char *stackPointer;
+  __asm__ volatile("mov %0, sp" : "=r"(stackPointer));
+  return stackPointer;
+}
+
+static inline uint32_t *AlignUp(char *address)
+{
+  return (uint32_t *)(((uintptr_t)address + 3) & ~(uintptr_t)3);
+}
+
+void MemoryReport_PaintStack(void)
+{
+  uint32_t *word = AlignUp(sbrk(0));
+  uint32_t *top = (uint32_t *)(StackPointer() - STACK_PAINT_MARGIN);
+
+  while (word < top)
+    *word++ = STACK_PAINT;
+}
+
+void MemoryReport_MarkStartup(void)
+{
+  startupHeapEnd = sbrk(0);
+}
+
+void MemoryReport_Print(void)
+{
+  char *heapEnd = sbrk(0);
+  char *ramEnd = (char *)&_estack;
+
+  // deepest stack use: the first word above the heap the stack has overwritten
+  uint32_t *word = AlignUp(heapEnd);
+  uint32_t *stackPointer = (uint32_t *)StackPointer();
+  while (word < stackPointer && *word == STACK_PAINT)
+    word++;
+  char *stackLowWater = (char *)word;
+
+  const unsigned int staticBytes = (char *)&_ebss - (char *)&_sdata;
+  const unsigned int heapBytes = heapEnd - (char *)&_ebss;
+  const int heapGrowth = (startupHeapEnd != nullptr) ? heapEnd - startupHeapEnd : 0;
+
+  Serial.printf("ram: %u bytes total\n", (unsigned int)(ramEnd - (char *)&_sdata));
+  Serial.printf("  static data %u (arena %u of %u used, %u failed allocations)\n", staticBytes,
+    (unsigned int)StaticArena_Used(), (unsigned int)StaticArena_Capacity(), StaticArena_FailedAllocations());
+  Serial.printf("  heap %u (%d since startup)\n", heapBytes, heapGrowth);
+  Serial.printf("  stack high-water %u\n", (unsigned int)(ramEnd - stackLowWater));
+  Serial.printf("  never touched %u\n", (unsigned int)(stackLowWater - heapEnd));
+}
@@ -0,0 +1,110 @@
+#include "PixelKernels.hpp"
+
+#include <string.h>
+
+static inline uint32_t LoadWord(const unsigned char *source)
+{
+  uint32_t word;
+  memcpy(&word, source, sizeof(word));
+  return word;
+}
+
+static inline void StoreWord(unsigned char *destination, uint32_t word)
+{
+  memcpy(destination, &word, sizeof(word));
+}
+
+// Adds the pending error from the row above, 4 pixels per word, and clears it for the next row.
+// Errors are kept as separate positive and negative rows so both adds can saturate.
+static void ApplyRowErrors(unsigned char *row, unsigned char *errorAdd, unsigned char *errorSubtract, unsigned int width)
+{
+  for (unsigned int x = 0; x < width; x += 4)
+  {
+    uint32_t pixels = LoadWord(row + x);
+    pixels = PixelKernels_SaturatingAdd4(pixels, LoadWord(errorAdd + x));
+    pixels = PixelKernels_SaturatingSubtract4(pixels, LoadWord(errorSubtract + x));
+    StoreWord(row + x, pixels);
+    StoreWord(errorAdd + x, 0);
+    StoreWord(errorSubtract + x, 0);
+  }
+}
+
+static inline void AddError(unsigned char *errorRow, unsigned int x, int error)
+{
+  errorRow[x] = PixelKernels_ClampByte(errorRow[x] + error);
+}
+
+// Floyd-Steinberg along one row: 7/16 of each pixel's error goes to the right neighbour straight
+// away, 3/16, 5/16 and 1/16 are gathered into the error rows for the row below.
+static void DitherRow(unsigned char *row, unsigned char *errorAdd, unsigned char *errorSubtract, unsigned int width)
+{
+  int carry = 0;
+
+  for (unsigned int x = 0; x < width; x++)
+  {
+    const unsigned char pixelValue = PixelKernels_ClampByte(row[x] + carry);
+    row[x] = pixelValue;
+
+    unsigned char *errorRow;
+    int ditherError;
+    if (pixelValue >= 128) // lit, the pixel is brighter than shown
+    {
+      ditherError = 255 - pixelValue;
+      errorRow = errorSubtract;
+      carry = -(((ditherError << 3) - ditherError) >> 4); // 7d / 16
+    }
+    else
+    {
+      ditherError = pixelValue;
+      errorRow = errorAdd;
+      carry = ((ditherError << 3) - ditherError) >> 4;
+    }
+
+    if (ditherError == 0)
+      continue;
+
+    if (x > 0)
+      AddError(errorRow, x - 1, ((ditherError << 2) - ditherError) >> 4); // 3d / 16
+    AddError(errorRow, x, ((ditherError << 2) + ditherError) >> 4);       // 5d / 16
+    if (x + 1 < width)
+      AddError(errorRow, x + 1, ditherError >> 4);                        //  d / 16
+  }
+}
+
+// packs 8 rows into one OLED page: byte x of the page holds column x, bit n from row n
+static void PackPage(const unsigned char *rows, unsigned char *page, unsigned int width)
+{
+  const uint32_t thresholds = 0x80808080u; // 128 in every byte, brightness 50 - 100% lights a pixel
+
+  for (unsigned int x = 0; x < width; x += 4)
+  {
+    uint32_t pageBits = 0;
+    for (unsigned int bit = 0; bit < 8; bit++)
+    {
+      const uint32_t lit = PixelKernels_Threshold4(LoadWord(rows + bit * width + x), thresholds);
+      pageBits |= lit & (0x01010101u << bit);
+    }
+    StoreWord(page + x, pageBits);
+  }
+}
+
+void PixelKernels_RenderPages(unsigned char *greyscale, unsigned char *pages, unsigned int width, unsigned int height, bool dither)
+{
+  if (dither && width <= DITHER_MAX_WIDTH)
+  {
+    unsigned char errorAdd[DITHER_MAX_WIDTH];
+    unsigned char errorSubtract[DITHER_MAX_WIDTH];
+    memset(errorAdd, 0, sizeof(errorAdd));
+    memset(errorSubtract, 0, sizeof(errorSubtract));
+
+    for (unsigned int y = 0; y < height; y++)
+    {
+      unsigned char *row = greyscale + y * width;
+      ApplyRowErrors(row, errorAdd, errorSubtract, width);
+      DitherRow(row, errorAdd, errorSubtract, width);
+    }
+  }
+
+  for (unsigned int page = 0; page < (height >> 3); page++)
+    PackPage(greyscale + page * 8 * width, pages + page * width, width);
+}
@@ -0,0 +1,48 @@
+#include "ProjectionTables.hpp"
+
+#include "LightTables.hpp"
+
+static constexpr ProjectionTables BuildProjectionTables(void)
+{
+  ProjectionTables tables = {};
+
+  for (int index = 0; index < PROJECTION_DISTANCE_COUNT; index++)
+  {
+    // distance = index / (1 << PROJECTION_DISTANCE_BITS), so height / distance needs no fractions
+    const int lineHeight = (index == 0) ? 0xffff : (PROJECTION_DISPLAY_HEIGHT << PROJECTION_DISTANCE_BITS) / index;
+    tables.lineHeight[index] = (unsigned short)((lineHeight > 0xffff) ? 0xffff : lineHeight);
+
+    // full brightness up to 3 cells away, then falling off as 1 / (distance * 0.333)
+    const double distance = (double)index / (1 << PROJECTION_DISTANCE_BITS);
+    const double falloff = (distance < 3.0) ? 1.0 : distance * 0.333;
+    for (int side = 0; side < 2; side++)
+    {
+      const double shade = ((side == 0) ? 1.0 : 0.75) / falloff;
+      tables.lightLevel[side][index] = (unsigned char)((shade >= 1.0) ? LIGHT_LEVEL_MAX : shade * LIGHT_LEVEL_MAX);
+    }
+  }
+
+  // a wall lineHeight pixels tall is drawn from startPixelY to endPixelY inclusive
+  for (int lineHeight = 0; lineHeight < PROJECTION_DISPLAY_HEIGHT; lineHeight++)
+  {
+    const int startPixelY = (PROJECTION_DISPLAY_HEIGHT - lineHeight) >> 1;
+    const int endPixelY = PROJECTION_DISPLAY_HEIGHT - 1 - startPixelY;
+    tables.wallTextureStep[lineHeight] = (endPixelY > startPixelY) ? (32 << 16) / (endPixelY - startPixelY) : 0;
+  }
+
+  return tables;
+}
+
+constexpr ProjectionTables projectionTables = BuildProjectionTables();
+
+unsigned int ProjectionTables_DistanceIndex(double distance)
+{
+  if (distance <= 0.0)
+    return 0;
+
+  const double scaled = distance * (1 << PROJECTION_DISTANCE_BITS) + 0.5;
+  if (scaled >= PROJECTION_DISTANCE_COUNT - 1)
+    return PROJECTION_DISTANCE_COUNT - 1;
+
+  return (unsigned int)scaled;
+}
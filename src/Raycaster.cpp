@@ -1,9 +1,13 @@
 #include "Raycaster.hpp"
 
 #include <cmath>
-#include <string.h>
+#include <cfloat>
+#include <cstring>
 
 #include "TextureManager.hpp"
+#include "LightTables.hpp"
+#include "ProjectionTables.hpp"
+#include "LightMap.hpp"
 
 
 Raycaster::Raycaster(int mapWidth, int mapHeight, int *worldMap)
@@ -14,6 +18,19 @@ Raycaster::Raycaster(int mapWidth, int mapHeight, int *worldMap)
 
   fovInRadians = M_PI / 3.0;
   distanceToClipPlane = 1.0;
+  clipPlaneHalfWidth = distanceToClipPlane * tan(fovInRadians / 2.0);
+  floorTexture = NO_TEXTURE;
+  ceilingTexture = NO_TEXTURE;
+  segmentCoherence = false;
+  packetTraversal = false;
+  seenTracking = true;
+  lightMap = nullptr;
+  raysCast = 0;
+  seenChanges = 0;
+  ClearSeen();
+
+  for (int x = 0; x < DEPTH_BUFFER_SIZE; x++)
+    depthBuffer[x] = mapWidth + mapHeight;
 }
 
 void Raycaster::SetCameraPosition(Vector2 position)
@@ -30,189 +47,749 @@ void Raycaster::SetCameraDirection(Vector2 direction)
 
 void Raycaster::SetCameraDirection(double angleInRadians)
 {
-  cameraDirection.x = 1.0;
-  cameraDirection.y = 0.0;
-  cameraDirection.Rotate(angleInRadians);
+  SetCameraAngle(TrigTables_FromRadians(angleInRadians));
+}
+
+void Raycaster::SetCameraAngle(BinaryAngle angle)
+{
+  cameraDirection = TrigTables_Direction(angle);
   UpdateClipPlaneVector();
 }
 
 void Raycaster::SetFOVInRadians(double fovInRadians)
 {
   this->fovInRadians = fovInRadians;
+  clipPlaneHalfWidth = distanceToClipPlane * tan(fovInRadians / 2.0);
+  UpdateClipPlaneVector();
+}
+
+void Raycaster::SetFOV(BinaryAngle fov)
+{
+  fovInRadians = TrigTables_ToRadians(fov);
+  clipPlaneHalfWidth = distanceToClipPlane * TrigTables_Tan(fov >> 1);
+  UpdateClipPlaneVector();
 }
 
 void Raycaster::SetClipPlaneDistance(double distance)
 {
+  // a plane at or behind the camera has no width to keep
+  if (distance <= 0.0)
+    return;
+
+  // the clip plane keeps its angular width; worked out afresh, so no earlier distance is needed
   distanceToClipPlane = distance;
+  clipPlaneHalfWidth = distanceToClipPlane * tan(fovInRadians / 2.0);
+  UpdateClipPlaneVector();
+}
+
+void Raycaster::SetFloorTexture(int texture)
+{
+  floorTexture = texture;
+}
+
+void Raycaster::SetCeilingTexture(int texture)
+{
+  ceilingTexture = texture;
+}
+
+void Raycaster::SetSegmentCoherence(bool enabled)
+{
+  segmentCoherence = enabled;
+}
+
+void Raycaster::SetPacketTraversal(bool enabled)
+{
+  packetTraversal = enabled;
+}
+
+void Raycaster::SetLightMap(LightMap *lightMap)
+{
+  this->lightMap = lightMap;
+}
+
+Vector2 Raycaster::GetCameraPosition(void)
+{
+  return cameraPosition;
+}
+
+Vector2 Raycaster::GetCameraDirection(void)
+{
+  return cameraDirection;
+}
+
+Vector2 Raycaster::GetClipPlaneRightVector(void)
+{
+  return clipPlaneRightVector;
+}
+
+double Raycaster::GetClipPlaneDistance(void)
+{
+  return distanceToClipPlane;
+}
+
+const float* Raycaster::GetDepthBuffer(void)
+{
+  return depthBuffer;
 }
 
 void Raycaster::UpdateClipPlaneVector(void)
 {
   clipPlaneRightVector.x = cameraDirection.y;
   clipPlaneRightVector.y = -cameraDirection.x;
-  clipPlaneRightVector.Scale(distanceToClipPlane * tan(fovInRadians / 2.0));
+  clipPlaneRightVector.Scale(clipPlaneHalfWidth);
 }
 
 void Raycaster::RenderToDisplay(DisplayWrapper *display)
 {
-  const unsigned int displayWidth = display->GetWidth();
-  const unsigned int displayHeight = display->GetHeight();
-  unsigned char *displayBuffer = display->GetBuffer();
+  RenderPass pass;
+  pass.halfRateFullHeight = true;
+  pass.markSeen = seenTracking;
+  pass.fullHeightLine = false;
+  pass.fullHeightLineCode = 0;
+  pass.raysCast = 0;
+  RAYCASTER_STAT(pass.stats = RenderStats());
+
+  RenderColumns(display, 0, display->GetWidth(), pass);
+
+  // floor & ceiling fill only the pixels outside each column's wall span
+  RenderFloorAndCeiling(display, 0, display->GetWidth(), pass);
+
+  raysCast = pass.raysCast;
+#if RAYCASTER_STATS
+  renderStats = pass.stats;
+  renderStats.raysCast = pass.raysCast;
+#endif
+}
 
-  const int bufferSize = displayWidth * displayHeight;
+unsigned int Raycaster::RenderColumnRange(DisplayWrapper *display, unsigned int firstX, unsigned int endX)
+{
+  if (endX > display->GetWidth())
+    endX = display->GetWidth();
+  if (firstX >= endX)
+    return 0;
+
+  // the half-rate path writes into the next column, which may belong to another range
+  RenderPass pass;
+  pass.halfRateFullHeight = false;
+  pass.markSeen = false;
+  pass.fullHeightLine = false;
+  pass.fullHeightLineCode = 0;
+  pass.raysCast = 0;
+  RAYCASTER_STAT(pass.stats = RenderStats());
+
+  RenderColumns(display, firstX, endX, pass);
+  RenderFloorAndCeiling(display, firstX, endX, pass);
+
+  return pass.raysCast;
+}
 
-  // zero display (i.e. black floor & ceiling)
-  memset(displayBuffer, 0, bufferSize);
+void Raycaster::RenderColumns(DisplayWrapper *display, unsigned int firstX, unsigned int endX, RenderPass &pass)
+{
+  const unsigned int displayWidth = display->GetWidth();
 
-  bool fullHeightLine = false;
-  unsigned char fullHeightLineCode;
+  if (!segmentCoherence)
+  {
+    unsigned int x = firstX;
 
-  for (unsigned int x = 0; x < displayWidth; x++)
+    if (packetTraversal)
+    {
+      for (; x + RAY_PACKET_SIZE <= endX; x += RAY_PACKET_SIZE)
+      {
+        ColumnHit hits[RAY_PACKET_SIZE];
+        CastColumnPacket(x, displayWidth, hits, pass);
+        DrawColumnPacket(x, hits, display, pass);
+      }
+    }
+
+    for (; x < endX; x++)
+    {
+      ColumnHit hit;
+      CastColumn(x, displayWidth, hit, pass);
+      DrawColumn(x, hit, display, pass);
+    }
+  }
+  else
   {
-    int mapX = int(cameraPosition.x);
-    int mapY = int(cameraPosition.y);
+    // coarse pass: cast at segment edges only, each segment shares its left edge with the previous one
+    ColumnHit hits[COHERENCE_SEGMENT_WIDTH + 1];
+    CastColumn(firstX, displayWidth, hits[0], pass);
 
-    // camera space: -1.0  at left of screen, +1.0 at right
-    double cameraX = 2.0 * x / double(displayWidth) - 1;
+    for (unsigned int segmentStart = firstX; segmentStart + 1 < endX; segmentStart += COHERENCE_SEGMENT_WIDTH)
+    {
+      unsigned int segmentEnd = segmentStart + COHERENCE_SEGMENT_WIDTH;
+      if (segmentEnd > endX - 1)
+        segmentEnd = endX - 1;
+      const int last = segmentEnd - segmentStart;
 
-    // calculate ray vector: from camera position to intersecting point on clip plane
-    Vector2 ray = Vector2(clipPlaneRightVector.x, clipPlaneRightVector.y);
-    ray.Scale(cameraX);
-    Vector2 vectorToClipPlanceCentre;
-    vectorToClipPlanceCentre.CloneFrom(cameraDirection);
-    vectorToClipPlanceCentre.Scale(distanceToClipPlane);
-    ray.Add(vectorToClipPlanceCentre);
+      CastColumn(segmentEnd, displayWidth, hits[last], pass);
+      RefineSegment(hits, segmentStart, 0, last, displayWidth, pass);
 
-    double lengthOfRayToNextXBoundary;
-    double lengthOfRayToNextYBoundary;
+      for (int i = 0; i < last; i++)
+        DrawColumn(segmentStart + i, hits[i], display, pass);
 
-    double lengthOfRayToCrossOneGridWidth = std::abs(1.0 / ray.x);
-    double lengthOfRayToCrossOneGridHeight = std::abs(1.0 / ray.y);
+      hits[0] = hits[last];
+    }
+    DrawColumn(endX - 1, hits[0], display, pass);
+  }
+}
 
-    double perpendicularWallDistance; // distance to wall projected onto the camera direction vector
-    int signX;
-    int signY;
+unsigned int Raycaster::GetRaysCast(void)
+{
+  return raysCast;
+}
 
-    bool hit = false;
-    Side side;
+bool Raycaster::CastRay(Vector2 origin, Vector2 direction, float maxDistance, RayHit *hit)
+{
+  const float directionX = direction.x;
+  const float directionY = direction.y;
+  const float length = sqrtf(directionX * directionX + directionY * directionY);
+  if (length == 0.0f)
+  {
+    hit->hit = false;
+    hit->steps = 0;
+    return false;
+  }
 
-    if (ray.x < 0)
+  const float originX = origin.x;
+  const float originY = origin.y;
+  return WalkRay(originX, originY, (int)floorf(originX), (int)floorf(originY), directionX / length, directionY / length, maxDistance, hit);
+}
+
+bool Raycaster::CastSegment(Vector2 from, Vector2 to, RayHit *hit)
+{
+  Vector2 delta(to.x - from.x, to.y - from.y);
+  return CastRay(from, delta, delta.Length(), hit);
+}
+
+bool Raycaster::HasLineOfSight(Vector2 from, Vector2 to)
+{
+  RayHit hit;
+  return !CastSegment(from, to, &hit);
+}
+
+unsigned int Raycaster::CastRays(const RayQuery *queries, RayHit *hits, unsigned int count)
+{
+  unsigned int hitCount = 0;
+  float originX = 0.0f;
+  float originY = 0.0f;
+  int cellX = 0;
+  int cellY = 0;
+  bool haveOrigin = false;
+
+  for (unsigned int i = 0; i < count; i++)
+  {
+    const RayQuery &query = queries[i];
+    const float directionX = query.direction.x;
+    const float directionY = query.direction.y;
+    const float length = sqrtf(directionX * directionX + directionY * directionY);
+    if (length == 0.0f)
     {
-      signX = -1;
-      lengthOfRayToNextXBoundary = (cameraPosition.x - mapX) * lengthOfRayToCrossOneGridWidth;
-    } 
-    else
+      hits[i].hit = false;
+      hits[i].steps = 0;
+      continue;
+    }
+
+    // a run of queries from one point (a spread of shots, a sweep) finds its cell once
+    if (!haveOrigin || (float)query.origin.x != originX || (float)query.origin.y != originY)
     {
-      signX = 1;
-      lengthOfRayToNextXBoundary = (mapX + 1.0 - cameraPosition.x) * lengthOfRayToCrossOneGridWidth;
+      originX = query.origin.x;
+      originY = query.origin.y;
+      cellX = (int)floorf(originX);
+      cellY = (int)floorf(originY);
+      haveOrigin = true;
     }
-    if (ray.y < 0)
+
+    if (WalkRay(originX, originY, cellX, cellY, directionX / length, directionY / length, query.maxDistance, &hits[i]))
+      hitCount++;
+  }
+
+  return hitCount;
+}
+
+unsigned int Raycaster::CheckLineOfSight(Vector2 from, const Vector2 *targets, bool *visible, unsigned int count)
+{
+  const float originX = from.x;
+  const float originY = from.y;
+  const int cellX = (int)floorf(originX);
+  const int cellY = (int)floorf(originY);
+  unsigned int visibleCount = 0;
+  RayHit hit;
+
+  for (unsigned int i = 0; i < count; i++)
+  {
+    const float deltaX = (float)targets[i].x - originX;
+    const float deltaY = (float)targets[i].y - originY;
+    const float length = sqrtf(deltaX * deltaX + deltaY * deltaY);
+
+    // a target in the origin's own cell ends the walk before its first boundary
+    const bool seen = (length == 0.0f) || !WalkRay(originX, originY, cellX, cellY, deltaX / length, deltaY / length, length, &hit);
+    visible[i] = seen;
+    visibleCount += seen;
+  }
+
+  return visibleCount;
+}
+
+#if RAYCASTER_STATS
+const RenderStats &Raycaster::GetRenderStats(void)
+{
+  return renderStats;
+}
+
+void Raycaster::CountWalk(unsigned int x, unsigned int steps, RenderPass &pass)
+{
+  pass.stats.ddaSteps += steps;
+  if (steps > pass.stats.maxColumnDdaSteps)
+  {
+    pass.stats.maxColumnDdaSteps = steps;
+    pass.stats.maxDdaStepsColumn = x;
+  }
+}
+
+void Raycaster::CountWallPixels(unsigned int pixels, unsigned int texels, RenderPass &pass)
+{
+  pass.stats.pixelsWritten += pixels;
+  pass.stats.texelsSampled += texels;
+  if (pixels > pass.stats.maxColumnWallPixels)
+    pass.stats.maxColumnWallPixels = pixels;
+}
+#endif
+
+Vector2 Raycaster::RayForColumn(unsigned int x, unsigned int displayWidth)
+{
+  // camera space: -1.0  at left of screen, +1.0 at right
+  double cameraX = 2.0 * x / double(displayWidth) - 1;
+
+  // calculate ray vector: from camera position to intersecting point on clip plane
+  Vector2 ray = Vector2(clipPlaneRightVector.x, clipPlaneRightVector.y);
+  ray.Scale(cameraX);
+  Vector2 vectorToClipPlanceCentre;
+  vectorToClipPlanceCentre.CloneFrom(cameraDirection);
+  vectorToClipPlanceCentre.Scale(distanceToClipPlane);
+  ray.Add(vectorToClipPlanceCentre);
+
+  return ray;
+}
+
+void Raycaster::CastColumn(unsigned int x, unsigned int displayWidth, ColumnHit &columnHit, RenderPass &pass)
+{
+  int mapX = int(cameraPosition.x);
+  int mapY = int(cameraPosition.y);
+
+  const Vector2 ray = RayForColumn(x, displayWidth);
+
+  double lengthOfRayToNextXBoundary;
+  double lengthOfRayToNextYBoundary;
+
+  double lengthOfRayToCrossOneGridWidth = std::abs(1.0 / ray.x);
+  double lengthOfRayToCrossOneGridHeight = std::abs(1.0 / ray.y);
+
+  int signX;
+  int signY;
+
+  bool hit = false;
+  Side side;
+  RAYCASTER_STAT(unsigned int steps = 0);
+
+  if (ray.x < 0)
+  {
+    signX = -1;
+    lengthOfRayToNextXBoundary = (cameraPosition.x - mapX) * lengthOfRayToCrossOneGridWidth;
+  } 
+  else
+  {
+    signX = 1;
+    lengthOfRayToNextXBoundary = (mapX + 1.0 - cameraPosition.x) * lengthOfRayToCrossOneGridWidth;
+  }
+  if (ray.y < 0)
+  {
+    signY = -1;
+    lengthOfRayToNextYBoundary = (cameraPosition.y - mapY) * lengthOfRayToCrossOneGridHeight;
+  } 
+  else
+  {
+    signY = 1;
+    lengthOfRayToNextYBoundary = (mapY + 1.0 - cameraPosition.y) * lengthOfRayToCrossOneGridHeight;
+  }
+
+  while (!hit)
+  {
+    if (lengthOfRayToNextXBoundary < lengthOfRayToNextYBoundary)
     {
-      signY = -1;
-      lengthOfRayToNextYBoundary = (cameraPosition.y - mapY) * lengthOfRayToCrossOneGridHeight;
-    } 
+      lengthOfRayToNextXBoundary += lengthOfRayToCrossOneGridWidth;
+      mapX += signX;
+      side = NorthSouth;
+    }
     else
     {
-      signY = 1;
-      lengthOfRayToNextYBoundary = (mapY + 1.0 - cameraPosition.y) * lengthOfRayToCrossOneGridHeight;
+      lengthOfRayToNextYBoundary += lengthOfRayToCrossOneGridHeight;
+      mapY += signY;
+      side = EastWest;
     }
+    RAYCASTER_STAT(steps++);
+    if (WallAtMapPosition(mapX, mapY))
+      hit = true;
+  }
 
-    while (!hit)
-    {
-      if (lengthOfRayToNextXBoundary < lengthOfRayToNextYBoundary)
-      {
-        lengthOfRayToNextXBoundary += lengthOfRayToCrossOneGridWidth;
-        mapX += signX;
-        side = NorthSouth;
-      }
-      else
-      {
-        lengthOfRayToNextYBoundary += lengthOfRayToCrossOneGridHeight;
-        mapY += signY;
-        side = EastWest;
-      }
-      if (WallAtMapPosition(mapX, mapY))
-        hit = true;
-    }
+  pass.raysCast++;
+  RAYCASTER_STAT(CountWalk(x, steps, pass));
+
+  columnHit.mapX = mapX;
+  columnHit.mapY = mapY;
+  columnHit.signX = signX;
+  columnHit.signY = signY;
+  columnHit.side = side;
+  ResolveWallDistance(ray, columnHit);
+  if (pass.markSeen)
+    MarkSeen(columnHit);
+}
+
+void Raycaster::ResolveWallDistance(const Vector2 &ray, ColumnHit &columnHit)
+{
+  double perpendicularWallDistance; // distance to wall projected onto the camera direction vector
+  double textureUV_U;
+
+  // (1 - signX) >> 1)  : add 1 only if the sign is -ve
+  switch (columnHit.side)
+  {
+  case NorthSouth:
+    perpendicularWallDistance = (columnHit.mapX - cameraPosition.x + ((1 - columnHit.signX) >> 1)) / ray.x;
+    textureUV_U = cameraPosition.y + perpendicularWallDistance * ray.y;
+    break;
+  case EastWest:
+  default:
+    perpendicularWallDistance = (columnHit.mapY - cameraPosition.y + ((1 - columnHit.signY) >> 1)) / ray.y;
+    textureUV_U = cameraPosition.x + perpendicularWallDistance * ray.x;
+    break;
+  }
+  textureUV_U -= floor(textureUV_U);
 
-    double textureUV_U;
-    // (1 - signX) >> 1)  : add 1 only if the sign is -ve
-    switch (side)
+  columnHit.perpendicularWallDistance = perpendicularWallDistance;
+  columnHit.textureUV_U = textureUV_U;
+}
+
+void Raycaster::RefineSegment(ColumnHit *hits, unsigned int segmentStart, int first, int last, unsigned int displayWidth, RenderPass &pass)
+{
+  if (last - first < 2)
+    return;
+
+  const ColumnHit &a = hits[first];
+  const ColumnHit &b = hits[last];
+
+  if (a.mapX == b.mapX && a.mapY == b.mapY && a.side == b.side && a.signX == b.signX && a.signY == b.signY)
+  {
+    // both edges hit the same face: the columns between see the same plane, so 1 / distance and
+    // U / distance are linear across them. Evaluating the face plane directly per column gives the
+    // same values a full cast would (bit for bit) without walking the grid.
+    for (int i = first + 1; i < last; i++)
     {
-    case NorthSouth:
-      perpendicularWallDistance = (mapX - cameraPosition.x + ((1 - signX) >> 1)) / ray.x;
-      textureUV_U = cameraPosition.y + perpendicularWallDistance * ray.y;
-      break;
-    case EastWest:
-      perpendicularWallDistance = (mapY - cameraPosition.y + ((1 - signY) >> 1)) / ray.y;
-      textureUV_U = cameraPosition.x + perpendicularWallDistance * ray.x;
-      break;
+      hits[i] = a;
+      ResolveWallDistance(RayForColumn(segmentStart + i, displayWidth), hits[i]);
     }
-    textureUV_U -= floor(textureUV_U);
+    return;
+  }
 
-    if (perpendicularWallDistance > (mapWidth + mapHeight))
-      perpendicularWallDistance = mapWidth + mapHeight;
+  // edges disagree: cast the middle column and refine both halves
+  const int middle = (first + last) >> 1;
+  CastColumn(segmentStart + middle, displayWidth, hits[middle], pass);
+  RefineSegment(hits, segmentStart, first, middle, displayWidth, pass);
+  RefineSegment(hits, segmentStart, middle, last, displayWidth, pass);
+}
 
-    unsigned int lineHeight = (int)(displayHeight / perpendicularWallDistance);
-    int textureColumn = int(textureUV_U * 32.0); // assumes textures are 32px wide
+void Raycaster::DrawColumn(unsigned int x, const ColumnHit &hit, DisplayWrapper *display, RenderPass &pass)
+{
+  ColumnSpan span;
+  PrepareColumn(x, hit, display->GetHeight(), span, pass);
+  DrawColumnSpan(x, span, display, pass);
+}
+
+void Raycaster::PrepareColumn(unsigned int x, const ColumnHit &hit, unsigned int displayHeight, ColumnSpan &span, RenderPass &pass)
+{
+  double perpendicularWallDistance = hit.perpendicularWallDistance;
+  if (perpendicularWallDistance > (mapWidth + mapHeight))
+  {
+    perpendicularWallDistance = mapWidth + mapHeight;
+    RAYCASTER_STAT(pass.stats.clampedRays++);
+  }
+
+  if (x < DEPTH_BUFFER_SIZE)
+    depthBuffer[x] = perpendicularWallDistance;
+
+  // projection tables replace the per-column divisions when the display matches the build
+  const bool projectionTable = (displayHeight == PROJECTION_DISPLAY_HEIGHT);
+  const unsigned int distanceIndex = ProjectionTables_DistanceIndex(perpendicularWallDistance);
+
+  unsigned int lineHeight;
+  unsigned char lightLevel;
+  if (projectionTable)
+  {
+    lineHeight = projectionTables.lineHeight[distanceIndex];
+    lightLevel = projectionTables.lightLevel[hit.side == EastWest][distanceIndex];
+  }
+  else
+  {
+    lineHeight = (int)(displayHeight / perpendicularWallDistance);
 
     double shade = 1.0; // 100 + (*(worldMap + (mapY * displayWidth) + mapX) * 30);
-    if (side == EastWest) 
+    if (hit.side == EastWest)
       shade = 0.75; // darken east-west walls
 
     shade /= (perpendicularWallDistance < 3.0) ? 1.0 : perpendicularWallDistance * 0.333;
+    lightLevel = LightTables_LevelForShade(shade);
+  }
 
-    int startPixelY = (displayHeight - lineHeight);
-    if (startPixelY < 0)
-      startPixelY = 0;
-    startPixelY >>= 1;
-    int endPixelY = 63 - startPixelY;
+  if (lightMap)
+  {
+    lightLevel += lightMap->GetFaceLevel(hit.mapX, hit.mapY, FaceOf(hit));
+    if (lightLevel > LIGHT_LEVEL_MAX)
+      lightLevel = LIGHT_LEVEL_MAX;
+  }
 
-    double textureRow;
-    double textureRowStep;
-    if (lineHeight < displayHeight)
-    {
-      fullHeightLine = false;
-      textureRow = 0;
-      textureRowStep = 32.0 / (double)(endPixelY - startPixelY);
+  int textureColumn = int(hit.textureUV_U * 32.0); // assumes textures are 32px wide
 
-      for (int y = startPixelY; y <= endPixelY; y++)
-      {
-        const unsigned char texel = *(textures[WallAtMapPosition(mapX, mapY)] + ((int)(textureRow) << 5) + textureColumn);
-        textureRow += textureRowStep;
-        const int offset = (y << 7) + x; // (y >> 7) assuming displayWidth = 128 !!
-        *(displayBuffer + offset) = texel * shade;
-      }
-    }
+  // one colour map per column: each pixel write below is a single table lookup
+  const unsigned char *lightTable = lightTables.level[lightLevel];
+  const unsigned char *texture = textures[WallAtMapPosition(hit.mapX, hit.mapY)];
+
+  int startPixelY = (displayHeight - lineHeight);
+  if (startPixelY < 0)
+    startPixelY = 0;
+  startPixelY >>= 1;
+  int endPixelY = displayHeight - 1 - startPixelY;
+
+  if (x < DEPTH_BUFFER_SIZE)
+  {
+    wallTop[x] = startPixelY;
+    wallBottom[x] = endPixelY;
+  }
+
+  // 16.16 texture rows: a wall shorter than the display shows all 32 texture rows, a taller one
+  // only the middle displayHeight / lineHeight of them
+  int textureRow;
+  int textureRowStep;
+  if (lineHeight < displayHeight)
+  {
+    textureRow = 0;
+    if (projectionTable)
+      textureRowStep = projectionTables.wallTextureStep[lineHeight];
     else
+      textureRowStep = (endPixelY > startPixelY) ? (32 << 16) / (endPixelY - startPixelY) : 0;
+  }
+  else if (projectionTable)
+  {
+    // here displayHeight / lineHeight is the quantised distance itself
+    textureRow = (16 << 16) - (int)(distanceIndex << (20 - PROJECTION_DISTANCE_BITS));
+    textureRowStep = (int)((distanceIndex << (21 - PROJECTION_DISTANCE_BITS)) / PROJECTION_DISPLAY_HEIGHT);
+  }
+  else
+  {
+    const double amountVisible = ((double)displayHeight / (double)lineHeight);
+    textureRow = (int)(16.0 * (1.0 - amountVisible) * 65536.0);
+    textureRowStep = (int)(32.0 * amountVisible / displayHeight * 65536.0);
+  }
+
+  span.lineHeight = lineHeight;
+  span.startPixelY = startPixelY;
+  span.endPixelY = endPixelY;
+  span.textureColumn = textureColumn;
+  span.textureRow = textureRow;
+  span.textureRowStep = textureRowStep;
+  span.texture = texture;
+  span.lightTable = lightTable;
+}
+
+void Raycaster::DrawColumnSpan(unsigned int x, const ColumnSpan &span, DisplayWrapper *display, RenderPass &pass)
+{
+  const unsigned int displayWidth = display->GetWidth();
+  const unsigned int displayHeight = display->GetHeight();
+
+  const int startPixelY = span.startPixelY;
+  const int endPixelY = span.endPixelY;
+  const unsigned char *texture = span.texture + span.textureColumn;
+  const unsigned char *lightTable = span.lightTable;
+  int textureRow = span.textureRow;
+  const int textureRowStep = span.textureRowStep;
+
+  unsigned char *pixel = display->GetBuffer() + startPixelY * displayWidth + x;
+
+  if (span.lineHeight < displayHeight)
+  {
+    pass.fullHeightLine = false;
+    RAYCASTER_STAT(CountWallPixels(endPixelY - startPixelY + 1, endPixelY - startPixelY + 1, pass));
+
+    for (int y = startPixelY; y <= endPixelY; y++)
+    {
+      *pixel = lightTable[*(texture + ((textureRow >> 16) << 5))];
+      textureRow += textureRowStep;
+      pixel += displayWidth;
+    }
+  }
+  else
+  {
+    bool doubleColumn = false;
+    if (pass.halfRateFullHeight)
     {
-      if (fullHeightLine == false)
+      if (pass.fullHeightLine == false)
       {
-        fullHeightLine = true;
-        fullHeightLineCode = x % 2;
+        pass.fullHeightLine = true;
+        pass.fullHeightLineCode = x % 2;
       }
-      if (x % 2 == fullHeightLineCode)
+      if (x % 2 != pass.fullHeightLineCode)
       {
-        const double amountVisible = ((double)displayHeight / (double)lineHeight);
-        textureRow = 16.0 * (1.0 - amountVisible);
-        textureRowStep = amountVisible / 2.0;
-
-        for (int y = startPixelY; y <= endPixelY; y++)
-        {
-          unsigned char texel = *(textures[WallAtMapPosition(mapX, mapY)] + ((int)(textureRow) << 5) + textureColumn);
-          textureRow += textureRowStep;
-          const int offset = (y << 7) + x; // (y >> 7) assuming displayWidth = 128 !!
-          if (side == EastWest)
-            texel = (texel >> 2) + (texel >> 1);
-          *(displayBuffer + offset) = texel;
-          if (x < 127)
-            *(displayBuffer + offset + 1) = texel;
-        }
+        RAYCASTER_STAT(pass.stats.halfRateColumns++);
+        return;
       }
+      doubleColumn = (x + 1 < displayWidth);
+    }
+    RAYCASTER_STAT(CountWallPixels((endPixelY - startPixelY + 1) * (doubleColumn ? 2 : 1), endPixelY - startPixelY + 1, pass));
+
+    for (int y = startPixelY; y <= endPixelY; y++)
+    {
+      const unsigned char texel = lightTable[*(texture + ((textureRow >> 16) << 5))];
+      textureRow += textureRowStep;
+      *pixel = texel;
+      if (doubleColumn)
+        *(pixel + 1) = texel;
+      pixel += displayWidth;
     }
   }
 }
 
+void Raycaster::RenderFloorAndCeiling(DisplayWrapper *display, unsigned int firstX, unsigned int endX, RenderPass &pass)
+{
+  const unsigned int displayWidth = display->GetWidth();
+  const unsigned int displayHeight = display->GetHeight();
+  unsigned char *displayBuffer = display->GetBuffer();
+
+  const unsigned char *floorTextureData = (floorTexture == NO_TEXTURE) ? nullptr : textures[floorTexture];
+  const unsigned char *ceilingTextureData = (ceilingTexture == NO_TEXTURE) ? nullptr : textures[ceilingTexture];
+
+  // rays through the left and right screen edges
+  Vector2 vectorToClipPlaneCentre;
+  vectorToClipPlaneCentre.CloneFrom(cameraDirection);
+  vectorToClipPlaneCentre.Scale(distanceToClipPlane);
+  const double leftRayX = vectorToClipPlaneCentre.x - clipPlaneRightVector.x;
+  const double leftRayY = vectorToClipPlaneCentre.y - clipPlaneRightVector.y;
+
+  const double halfHeight = displayHeight * 0.5;
+
+  // the per-column wall spans only cover the first DEPTH_BUFFER_SIZE columns
+  if (endX > DEPTH_BUFFER_SIZE)
+    endX = DEPTH_BUFFER_SIZE;
+
+  // the floor row y and the ceiling row (displayHeight - 1 - y) are the same distance away
+  for (unsigned int y = displayHeight >> 1; y < displayHeight; y++)
+  {
+    const unsigned int ceilingY = displayHeight - 1 - y;
+
+    // one distance per scanline: a wall bottom at row y is this far away (in the same units as
+    // perpendicularWallDistance), so the floor across the whole row is too
+    const double rowDistance = halfHeight / (y + 0.5 - halfHeight);
+
+    double shade = (rowDistance < 3.0) ? 1.0 : 1.0 / (rowDistance * 0.333);
+    const unsigned char *lightTable = lightTables.level[LightTables_LevelForShade(shade)];
+
+    // 16.16 fixed point world position of the leftmost pixel and the step from one pixel to the next
+    // (stepping from firstX lands on the same values as stepping from column 0)
+    const int floorStepX = (int)(rowDistance * 2.0 * clipPlaneRightVector.x / displayWidth * 65536.0);
+    const int floorStepY = (int)(rowDistance * 2.0 * clipPlaneRightVector.y / displayWidth * 65536.0);
+    int floorX = (int)((cameraPosition.x + rowDistance * leftRayX) * 65536.0) + (int)firstX * floorStepX;
+    int floorY = (int)((cameraPosition.y + rowDistance * leftRayY) * 65536.0) + (int)firstX * floorStepY;
+
+    unsigned char *floorRow = displayBuffer + y * displayWidth;
+    unsigned char *ceilingRow = displayBuffer + ceilingY * displayWidth;
+
+    for (unsigned int x = firstX; x < endX; x++)
+    {
+      // top 5 fractional bits pick the texel within a 32 x 32 texture
+      const int texelOffset = (((floorY >> 11) & 31) << 5) + ((floorX >> 11) & 31);
+      floorX += floorStepX;
+      floorY += floorStepY;
+
+      if ((int)y > wallBottom[x])
+        *(floorRow + x) = floorTextureData ? lightTable[*(floorTextureData + texelOffset)] : 0;
+      if ((int)ceilingY < wallTop[x])
+        *(ceilingRow + x) = ceilingTextureData ? lightTable[*(ceilingTextureData + texelOffset)] : 0;
+    }
+  }
+
+#if RAYCASTER_STATS
+  // counted from the wall spans afterwards rather than pixel by pixel
+  const unsigned int floorStart = displayHeight >> 1;
+  const unsigned int ceilingEnd = displayHeight - floorStart;
+  for (unsigned int x = firstX; x < endX; x++)
+  {
+    const unsigned int floorFirst = ((unsigned int)wallBottom[x] + 1 > floorStart) ? wallBottom[x] + 1 : floorStart;
+    const unsigned int floorPixels = (floorFirst < displayHeight) ? displayHeight - floorFirst : 0;
+    const unsigned int ceilingPixels = (wallTop[x] < ceilingEnd) ? wallTop[x] : ceilingEnd;
+
+    pass.stats.pixelsWritten += floorPixels + ceilingPixels;
+    pass.stats.texelsSampled += (floorTextureData ? floorPixels : 0) + (ceilingTextureData ? ceilingPixels : 0);
+  }
+#endif
+}
+
+void Raycaster::SetSeenTracking(bool enabled)
+{
+  seenTracking = enabled;
+}
+
+void Raycaster::ClearSeen(void)
+{
+  memset(seenFaces, 0, sizeof(seenFaces));
+  seenChanges++;
+}
+
+bool Raycaster::IsFaceSeen(int x, int y, WallFace face)
+{
+  return (GetSeenFaces(x, y) >> face) & 1;
+}
+
+unsigned char Raycaster::GetSeenFaces(int x, int y)
+{
+  if (x < 0 || x >= mapWidth || y < 0 || y >= mapHeight || y * mapWidth + x >= RAYCASTER_MAX_MAP_CELLS)
+    return 0;
+
+  const unsigned int cell = y * mapWidth + x;
+  return (seenFaces[cell >> 1] >> ((cell & 1) * 4)) & 0x0f;
+}
+
+const uint8_t *Raycaster::GetSeenFaceBits(void)
+{
+  return seenFaces;
+}
+
+uint32_t Raycaster::GetSeenChanges(void)
+{
+  return seenChanges;
+}
+
+void Raycaster::MarkSeen(const ColumnHit &hit)
+{
+  // rays leaving the map stop in the cell beyond its edge, which has no bits
+  if (hit.mapX < 0 || hit.mapX >= mapWidth || hit.mapY < 0 || hit.mapY >= mapHeight)
+    return;
+  const unsigned int cell = hit.mapY * mapWidth + hit.mapX;
+  if (cell >= RAYCASTER_MAX_MAP_CELLS)
+    return;
+
+  const unsigned int bit = cell * 4 + FaceOf(hit);
+  const uint8_t mask = 1 << (bit & 7);
+  if (!(seenFaces[bit >> 3] & mask))
+  {
+    seenFaces[bit >> 3] |= mask;
+    seenChanges++;
+  }
+}
+
+WallFace Raycaster::FaceOf(const ColumnHit &hit)
+{
+  // the ray came in through the side facing back along it
+  if (hit.side == NorthSouth)
+    return (hit.signX > 0) ? FaceWest : FaceEast;
+  return (hit.signY > 0) ? FaceSouth : FaceNorth;
+}
+
 unsigned char Raycaster::WallAtMapPosition(int xPos, int yPos)
 {
   xPos = mapWidth - 1 - xPos;
@@ -222,3 +799,74 @@ unsigned char Raycaster::WallAtMapPosition(int xPos, int yPos)
   return *(worldMap + (yPos * mapWidth) + xPos);
 }
 
+// CastColumn's walk for an arbitrary unit-length ray, in float: distances come out along the ray
+// rather than projected onto the camera direction. The origin's own cell is never tested, as the
+// camera's is not.
+bool Raycaster::WalkRay(float originX, float originY, int cellX, int cellY, float directionX, float directionY, float maxDistance, RayHit *hit)
+{
+  // a ray parallel to an axis never reaches that axis' next boundary
+  float lengthOfRayToNextXBoundary = FLT_MAX;
+  float lengthOfRayToNextYBoundary = FLT_MAX;
+  float lengthOfRayToCrossOneGridWidth = 0.0f;
+  float lengthOfRayToCrossOneGridHeight = 0.0f;
+  int signX = (directionX < 0.0f) ? -1 : 1;
+  int signY = (directionY < 0.0f) ? -1 : 1;
+
+  if (directionX != 0.0f)
+  {
+    lengthOfRayToCrossOneGridWidth = fabsf(1.0f / directionX);
+    lengthOfRayToNextXBoundary = ((signX < 0) ? originX - cellX : cellX + 1.0f - originX) * lengthOfRayToCrossOneGridWidth;
+  }
+  if (directionY != 0.0f)
+  {
+    lengthOfRayToCrossOneGridHeight = fabsf(1.0f / directionY);
+    lengthOfRayToNextYBoundary = ((signY < 0) ? originY - cellY : cellY + 1.0f - originY) * lengthOfRayToCrossOneGridHeight;
+  }
+
+  unsigned int steps = 0;
+  while (true)
+  {
+    float distance;
+    RayHitSide side;
+    if (lengthOfRayToNextXBoundary < lengthOfRayToNextYBoundary)
+    {
+      distance = lengthOfRayToNextXBoundary;
+      lengthOfRayToNextXBoundary += lengthOfRayToCrossOneGridWidth;
+      cellX += signX;
+      side = RayHitNorthSouth;
+    }
+    else
+    {
+      distance = lengthOfRayToNextYBoundary;
+      lengthOfRayToNextYBoundary += lengthOfRayToCrossOneGridHeight;
+      cellY += signY;
+      side = RayHitEastWest;
+    }
+    if (distance > maxDistance)
+      break;
+
+    // outside the map reads as wall, so every walk ends at the edge at the latest
+    steps++;
+    const unsigned char wall = WallAtMapPosition(cellX, cellY);
+    if (wall)
+    {
+      float textureU = (side == RayHitNorthSouth) ? originY + distance * directionY : originX + distance * directionX;
+      textureU -= floorf(textureU);
+
+      hit->hit = true;
+      hit->cellX = cellX;
+      hit->cellY = cellY;
+      hit->side = side;
+      hit->wall = wall;
+      hit->distance = distance;
+      hit->textureU = textureU;
+      hit->steps = steps;
+      return true;
+    }
+  }
+
+  hit->hit = false;
+  hit->steps = steps;
+  return false;
+}
+
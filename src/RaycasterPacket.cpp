@@ -0,0 +1,336 @@
+#include "Raycaster.hpp"
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+
+#include <emmintrin.h>
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+// Lanes are doubles so that every addition and comparison matches the scalar walk bit for bit:
+// a packet of four rays is one AVX register, or a pair of SSE2 registers.
+#if defined(__AVX__)
+
+typedef __m256d PacketDouble;
+
+static inline PacketDouble Packet_Load(const double *values) { return _mm256_loadu_pd(values); }
+static inline PacketDouble Packet_Fill(double value) { return _mm256_set1_pd(value); }
+static inline PacketDouble Packet_Add(PacketDouble a, PacketDouble b) { return _mm256_add_pd(a, b); }
+static inline PacketDouble Packet_Div(PacketDouble a, PacketDouble b) { return _mm256_div_pd(a, b); }
+static inline PacketDouble Packet_Mul(PacketDouble a, PacketDouble b) { return _mm256_mul_pd(a, b); }
+static inline PacketDouble Packet_Abs(PacketDouble a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+static inline PacketDouble Packet_Less(PacketDouble a, PacketDouble b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+static inline PacketDouble Packet_And(PacketDouble a, PacketDouble b) { return _mm256_and_pd(a, b); }
+static inline PacketDouble Packet_AndNot(PacketDouble a, PacketDouble b) { return _mm256_andnot_pd(a, b); }
+static inline PacketDouble Packet_Select(PacketDouble mask, PacketDouble a, PacketDouble b) { return _mm256_blendv_pd(b, a, mask); }
+static inline int Packet_Bits(PacketDouble mask) { return _mm256_movemask_pd(mask); }
+
+// 64-bit lane masks narrowed to 32-bit lanes for the integer map coordinates
+static inline __m128i Packet_IntMask(PacketDouble mask)
+{
+  const __m128 low = _mm_castpd_ps(_mm256_castpd256_pd128(mask));
+  const __m128 high = _mm_castpd_ps(_mm256_extractf128_pd(mask, 1));
+  return _mm_castps_si128(_mm_shuffle_ps(low, high, _MM_SHUFFLE(2, 0, 2, 0)));
+}
+
+static inline PacketDouble Packet_FromBits(int bits)
+{
+  return _mm256_castsi256_pd(_mm256_set_epi64x(-((bits >> 3) & 1), -((bits >> 2) & 1), -((bits >> 1) & 1), -(bits & 1)));
+}
+
+#else
+
+struct PacketDouble
+{
+  __m128d low;
+  __m128d high;
+};
+
+static inline PacketDouble Packet_Make(__m128d low, __m128d high) { PacketDouble p; p.low = low; p.high = high; return p; }
+static inline PacketDouble Packet_Load(const double *values) { return Packet_Make(_mm_loadu_pd(values), _mm_loadu_pd(values + 2)); }
+static inline PacketDouble Packet_Fill(double value) { return Packet_Make(_mm_set1_pd(value), _mm_set1_pd(value)); }
+static inline PacketDouble Packet_Add(PacketDouble a, PacketDouble b) { return Packet_Make(_mm_add_pd(a.low, b.low), _mm_add_pd(a.high, b.high)); }
+static inline PacketDouble Packet_Div(PacketDouble a, PacketDouble b) { return Packet_Make(_mm_div_pd(a.low, b.low), _mm_div_pd(a.high, b.high)); }
+static inline PacketDouble Packet_Mul(PacketDouble a, PacketDouble b) { return Packet_Make(_mm_mul_pd(a.low, b.low), _mm_mul_pd(a.high, b.high)); }
+static inline PacketDouble Packet_And(PacketDouble a, PacketDouble b) { return Packet_Make(_mm_and_pd(a.low, b.low), _mm_and_pd(a.high, b.high)); }
+static inline PacketDouble Packet_AndNot(PacketDouble a, PacketDouble b) { return Packet_Make(_mm_andnot_pd(a.low, b.low), _mm_andnot_pd(a.high, b.high)); }
+static inline PacketDouble Packet_Less(PacketDouble a, PacketDouble b) { return Packet_Make(_mm_cmplt_pd(a.low, b.low), _mm_cmplt_pd(a.high, b.high)); }
+static inline int Packet_Bits(PacketDouble mask) { return _mm_movemask_pd(mask.low) | (_mm_movemask_pd(mask.high) << 2); }
+
+static inline PacketDouble Packet_Abs(PacketDouble a)
+{
+  return Packet_AndNot(Packet_Fill(-0.0), a);
+}
+
+static inline PacketDouble Packet_Select(PacketDouble mask, PacketDouble a, PacketDouble b)
+{
+  return Packet_Make(_mm_or_pd(_mm_and_pd(mask.low, a.low), _mm_andnot_pd(mask.low, b.low)),
+                     _mm_or_pd(_mm_and_pd(mask.high, a.high), _mm_andnot_pd(mask.high, b.high)));
+}
+
+// 64-bit lane masks narrowed to 32-bit lanes for the integer map coordinates
+static inline __m128i Packet_IntMask(PacketDouble mask)
+{
+  return _mm_castps_si128(_mm_shuffle_ps(_mm_castpd_ps(mask.low), _mm_castpd_ps(mask.high), _MM_SHUFFLE(2, 0, 2, 0)));
+}
+
+static inline PacketDouble Packet_FromBits(int bits)
+{
+  return Packet_Make(_mm_castsi128_pd(_mm_set_epi64x(-((bits >> 1) & 1), -(bits & 1))),
+                     _mm_castsi128_pd(_mm_set_epi64x(-((bits >> 3) & 1), -((bits >> 2) & 1))));
+}
+
+#endif
+
+#define ALL_LANES ((1 << RAY_PACKET_SIZE) - 1)
+
+void Raycaster::CastColumnPacket(unsigned int firstX, unsigned int displayWidth, ColumnHit *hits, RenderPass &pass)
+{
+  // cell offsets below use a 16-bit lane multiply
+  if (mapWidth * mapHeight > 65536)
+  {
+    for (int lane = 0; lane < RAY_PACKET_SIZE; lane++)
+      CastColumn(firstX + lane, displayWidth, hits[lane], pass);
+    return;
+  }
+
+  Vector2 rays[RAY_PACKET_SIZE];
+  double rayX[RAY_PACKET_SIZE];
+  double rayY[RAY_PACKET_SIZE];
+
+  for (int lane = 0; lane < RAY_PACKET_SIZE; lane++)
+  {
+    rays[lane] = RayForColumn(firstX + lane, displayWidth);
+    rayX[lane] = rays[lane].x;
+    rayY[lane] = rays[lane].y;
+  }
+
+  // every ray starts in the camera's cell
+  const int startMapX = int(cameraPosition.x);
+  const int startMapY = int(cameraPosition.y);
+
+  const PacketDouble zero = Packet_Fill(0.0);
+  const PacketDouble one = Packet_Fill(1.0);
+
+  const PacketDouble packetRayX = Packet_Load(rayX);
+  const PacketDouble packetRayY = Packet_Load(rayY);
+
+  const PacketDouble lengthOfRayToCrossOneGridWidth = Packet_Abs(Packet_Div(one, packetRayX));
+  const PacketDouble lengthOfRayToCrossOneGridHeight = Packet_Abs(Packet_Div(one, packetRayY));
+
+  const PacketDouble negativeX = Packet_Less(packetRayX, zero);
+  const PacketDouble negativeY = Packet_Less(packetRayY, zero);
+
+  PacketDouble lengthOfRayToNextXBoundary = Packet_Select(negativeX,
+    Packet_Mul(Packet_Fill(cameraPosition.x - startMapX), lengthOfRayToCrossOneGridWidth),
+    Packet_Mul(Packet_Fill(startMapX + 1.0 - cameraPosition.x), lengthOfRayToCrossOneGridWidth));
+  PacketDouble lengthOfRayToNextYBoundary = Packet_Select(negativeY,
+    Packet_Mul(Packet_Fill(cameraPosition.y - startMapY), lengthOfRayToCrossOneGridHeight),
+    Packet_Mul(Packet_Fill(startMapY + 1.0 - cameraPosition.y), lengthOfRayToCrossOneGridHeight));
+
+  __m128i mapX = _mm_set1_epi32(startMapX);
+  __m128i mapY = _mm_set1_epi32(startMapY);
+  const __m128i signX = _mm_or_si128(Packet_IntMask(negativeX), _mm_set1_epi32(1)); // -1 or +1
+  const __m128i signY = _mm_or_si128(Packet_IntMask(negativeY), _mm_set1_epi32(1));
+
+  // WallAtMapPosition, four lanes at a time: mirrored column, row-major offset and bounds
+  const __m128i zeroLanes = _mm_setzero_si128();
+  const __m128i lastColumn = _mm_set1_epi32(mapWidth - 1);
+  const __m128i lastRow = _mm_set1_epi32(mapHeight - 1);
+  const __m128i mapWidthLanes = _mm_set1_epi32(mapWidth);
+
+  PacketDouble active = Packet_FromBits(ALL_LANES);
+  int activeLanes = ALL_LANES;
+  int northSouthLanes = 0; // lanes whose last step crossed an x boundary
+  RAYCASTER_STAT(unsigned int laneSteps[RAY_PACKET_SIZE] = {});
+
+  while (activeLanes)
+  {
+    // masked step: each active lane advances along whichever boundary is nearer, finished lanes hold still
+    const PacketDouble nearerX = Packet_Less(lengthOfRayToNextXBoundary, lengthOfRayToNextYBoundary);
+    const PacketDouble stepX = Packet_And(nearerX, active);
+    const PacketDouble stepY = Packet_AndNot(nearerX, active);
+
+    lengthOfRayToNextXBoundary = Packet_Select(stepX, Packet_Add(lengthOfRayToNextXBoundary, lengthOfRayToCrossOneGridWidth), lengthOfRayToNextXBoundary);
+    lengthOfRayToNextYBoundary = Packet_Select(stepY, Packet_Add(lengthOfRayToNextYBoundary, lengthOfRayToCrossOneGridHeight), lengthOfRayToNextYBoundary);
+    mapX = _mm_add_epi32(mapX, _mm_and_si128(Packet_IntMask(stepX), signX));
+    mapY = _mm_add_epi32(mapY, _mm_and_si128(Packet_IntMask(stepY), signY));
+
+    northSouthLanes = (northSouthLanes & ~activeLanes) | Packet_Bits(stepX);
+#if RAYCASTER_STATS
+    for (int lane = 0; lane < RAY_PACKET_SIZE; lane++)
+      laneSteps[lane] += (activeLanes >> lane) & 1;
+#endif
+
+    const __m128i column = _mm_sub_epi32(lastColumn, mapX);
+    const __m128i outside = _mm_or_si128(
+      _mm_or_si128(_mm_cmpgt_epi32(zeroLanes, column), _mm_cmpgt_epi32(column, lastColumn)),
+      _mm_or_si128(_mm_cmpgt_epi32(zeroLanes, mapY), _mm_cmpgt_epi32(mapY, lastRow)));
+
+    // outside lanes read cell 0 instead and count as a hit, like WallAtMapPosition
+    const __m128i offset = _mm_andnot_si128(outside, _mm_add_epi32(_mm_mullo_epi16(mapY, mapWidthLanes), column));
+    const __m128i cells = _mm_set_epi32(
+      *(worldMap + _mm_cvtsi128_si32(_mm_shuffle_epi32(offset, 3))),
+      *(worldMap + _mm_cvtsi128_si32(_mm_shuffle_epi32(offset, 2))),
+      *(worldMap + _mm_cvtsi128_si32(_mm_shuffle_epi32(offset, 1))),
+      *(worldMap + _mm_cvtsi128_si32(offset)));
+    const __m128i wall = _mm_or_si128(outside, _mm_xor_si128(_mm_cmpeq_epi32(cells, zeroLanes), _mm_set1_epi32(-1)));
+    const int hitLanes = _mm_movemask_ps(_mm_castsi128_ps(wall)) & activeLanes;
+
+    if (hitLanes)
+    {
+      activeLanes &= ~hitLanes;
+      active = Packet_FromBits(activeLanes);
+    }
+  }
+
+  int laneMapX[RAY_PACKET_SIZE];
+  int laneMapY[RAY_PACKET_SIZE];
+  _mm_storeu_si128((__m128i *)laneMapX, mapX);
+  _mm_storeu_si128((__m128i *)laneMapY, mapY);
+  const int negativeXLanes = Packet_Bits(negativeX);
+  const int negativeYLanes = Packet_Bits(negativeY);
+
+  for (int lane = 0; lane < RAY_PACKET_SIZE; lane++)
+  {
+    hits[lane].mapX = laneMapX[lane];
+    hits[lane].mapY = laneMapY[lane];
+    hits[lane].signX = (negativeXLanes & (1 << lane)) ? -1 : 1;
+    hits[lane].signY = (negativeYLanes & (1 << lane)) ? -1 : 1;
+    hits[lane].side = (northSouthLanes & (1 << lane)) ? NorthSouth : EastWest;
+    ResolveWallDistance(rays[lane], hits[lane]);
+    if (pass.markSeen)
+      MarkSeen(hits[lane]);
+    RAYCASTER_STAT(CountWalk(firstX + lane, laneSteps[lane], pass));
+  }
+
+  pass.raysCast += RAY_PACKET_SIZE;
+}
+
+void Raycaster::DrawColumnPacket(unsigned int firstX, const ColumnHit *hits, DisplayWrapper *display, RenderPass &pass)
+{
+  const unsigned int displayWidth = display->GetWidth();
+  const unsigned int displayHeight = display->GetHeight();
+  unsigned char *displayBuffer = display->GetBuffer();
+
+  ColumnSpan spans[RAY_PACKET_SIZE];
+  bool anyFullHeight = false;
+
+  for (int lane = 0; lane < RAY_PACKET_SIZE; lane++)
+  {
+    PrepareColumn(firstX + lane, hits[lane], displayHeight, spans[lane], pass);
+    if (spans[lane].lineHeight >= displayHeight)
+      anyFullHeight = true;
+  }
+
+  // the half-rate full height path depends on the previous column, so it stays scalar
+  if (anyFullHeight)
+  {
+    for (int lane = 0; lane < RAY_PACKET_SIZE; lane++)
+      DrawColumnSpan(firstX + lane, spans[lane], display, pass);
+    return;
+  }
+  pass.fullHeightLine = false;
+#if RAYCASTER_STATS
+  for (int lane = 0; lane < RAY_PACKET_SIZE; lane++)
+    CountWallPixels(spans[lane].endPixelY - spans[lane].startPixelY + 1, spans[lane].endPixelY - spans[lane].startPixelY + 1, pass);
+#endif
+
+  // vectorised texture fetch across the four adjacent columns. Each lane steps its 16.16 texture
+  // row exactly as DrawColumnSpan does; lanes draw their own top rows alone until every lane is inside
+  // its wall span, then the rows shared by all four are fetched together and stored as one word.
+  int sharedFirstY = spans[0].startPixelY;
+  int sharedLastY = spans[0].endPixelY;
+  for (int lane = 1; lane < RAY_PACKET_SIZE; lane++)
+  {
+    if (spans[lane].startPixelY > sharedFirstY)
+      sharedFirstY = spans[lane].startPixelY;
+    if (spans[lane].endPixelY < sharedLastY)
+      sharedLastY = spans[lane].endPixelY;
+  }
+
+  int textureRow[RAY_PACKET_SIZE];
+  int textureRowStep[RAY_PACKET_SIZE];
+  int textureColumn[RAY_PACKET_SIZE];
+
+  for (int lane = 0; lane < RAY_PACKET_SIZE; lane++)
+  {
+    const ColumnSpan &span = spans[lane];
+    unsigned char *column = displayBuffer + firstX + lane;
+
+    textureRow[lane] = span.textureRow;
+    textureRowStep[lane] = span.textureRowStep;
+    textureColumn[lane] = span.textureColumn;
+
+    for (int y = span.startPixelY; y < sharedFirstY; y++)
+    {
+      *(column + y * displayWidth) = span.lightTable[*(span.texture + ((textureRow[lane] >> 16) << 5) + span.textureColumn)];
+      textureRow[lane] += textureRowStep[lane];
+    }
+  }
+
+  __m128i packetTextureRow = _mm_loadu_si128((const __m128i *)textureRow);
+  const __m128i packetTextureRowStep = _mm_loadu_si128((const __m128i *)textureRowStep);
+  const __m128i packetTextureColumn = _mm_loadu_si128((const __m128i *)textureColumn);
+
+  // per-lane texture and colour map pointers (the column offsets are already in the packet)
+  const unsigned char *texture0 = spans[0].texture;
+  const unsigned char *texture1 = spans[1].texture;
+  const unsigned char *texture2 = spans[2].texture;
+  const unsigned char *texture3 = spans[3].texture;
+  const unsigned char *lightTable0 = spans[0].lightTable;
+  const unsigned char *lightTable1 = spans[1].lightTable;
+  const unsigned char *lightTable2 = spans[2].lightTable;
+  const unsigned char *lightTable3 = spans[3].lightTable;
+  unsigned char *destination = displayBuffer + sharedFirstY * displayWidth + firstX;
+
+  for (int y = sharedFirstY; y <= sharedLastY; y++)
+  {
+    const __m128i texelOffset = _mm_add_epi32(_mm_slli_epi32(_mm_srai_epi32(packetTextureRow, 16), 5), packetTextureColumn);
+    packetTextureRow = _mm_add_epi32(packetTextureRow, packetTextureRowStep);
+
+    // texture reads stay scalar (no byte gather); the four shaded texels are assembled in a
+    // register and written as one word (little-endian: lane 0 is the leftmost pixel)
+    const uint32_t texels = (uint32_t)lightTable0[*(texture0 + _mm_cvtsi128_si32(texelOffset))]
+      | ((uint32_t)lightTable1[*(texture1 + _mm_cvtsi128_si32(_mm_shuffle_epi32(texelOffset, 1)))] << 8)
+      | ((uint32_t)lightTable2[*(texture2 + _mm_cvtsi128_si32(_mm_shuffle_epi32(texelOffset, 2)))] << 16)
+      | ((uint32_t)lightTable3[*(texture3 + _mm_cvtsi128_si32(_mm_shuffle_epi32(texelOffset, 3)))] << 24);
+    memcpy(destination, &texels, sizeof(texels));
+    destination += displayWidth;
+  }
+
+  _mm_storeu_si128((__m128i *)textureRow, packetTextureRow);
+
+  for (int lane = 0; lane < RAY_PACKET_SIZE; lane++)
+  {
+    const ColumnSpan &span = spans[lane];
+    unsigned char *column = displayBuffer + firstX + lane;
+
+    for (int y = sharedLastY + 1; y <= span.endPixelY; y++)
+    {
+      *(column + y * displayWidth) = span.lightTable[*(span.texture + ((textureRow[lane] >> 16) << 5) + span.textureColumn)];
+      textureRow[lane] += textureRowStep[lane];
+    }
+  }
+}
+
+#else
+
+// scalar fallback: the same walks and column draws, one lane at a time
+
+void Raycaster::CastColumnPacket(unsigned int firstX, unsigned int displayWidth, ColumnHit *hits, RenderPass &pass)
+{
+  for (int lane = 0; lane < RAY_PACKET_SIZE; lane++)
+    CastColumn(firstX + lane, displayWidth, hits[lane], pass);
+}
+
+void Raycaster::DrawColumnPacket(unsigned int firstX, const ColumnHit *hits, DisplayWrapper *display, RenderPass &pass)
+{
+  for (int lane = 0; lane < RAY_PACKET_SIZE; lane++)
+    DrawColumn(firstX + lane, hits[lane], display, pass);
+}
+
+#endif
@@ -0,0 +1,181 @@
+#include "Scheduler.hpp"
+
+struct Task
+{
+  SchedulerTask function;
+  void *context;
+  uint32_t nextDue;
+  uint32_t period;
+  uint32_t budget;
+  uint8_t priority;
+  bool periodic;
+  bool active;
+  uint32_t lastFrame; // background tasks run at most once a frame
+  TaskStats stats;
+};
+
+static Task tasks[SCHEDULER_MAX_TASKS];
+static SchedulerClock schedulerClock;
+static SchedulerStats schedulerStats;
+
+// clock comparisons survive the 32-bit wrap as long as the times are within 35 minutes
+static inline bool Reached(uint32_t now, uint32_t time)
+{
+  return (int32_t)(now - time) >= 0;
+}
+
+static int AddTask(const char *name, SchedulerTask function, void *context, uint32_t delay, uint32_t period,
+  uint32_t budget, uint8_t priority, bool periodic);
+static void RunTask(Task &task);
+
+void Scheduler_Init(SchedulerClock clock)
+{
+  schedulerClock = clock;
+  for (unsigned int i = 0; i < SCHEDULER_MAX_TASKS; i++)
+    tasks[i].active = false;
+  schedulerStats = SchedulerStats();
+}
+
+int Scheduler_AddPeriodic(const char *name, SchedulerTask task, void *context, uint32_t periodMicroseconds,
+  uint32_t budgetMicroseconds, uint8_t priority)
+{
+  return AddTask(name, task, context, 0, periodMicroseconds, budgetMicroseconds, priority, true);
+}
+
+int Scheduler_Defer(const char *name, SchedulerTask task, void *context, uint32_t delayMicroseconds,
+  uint32_t budgetMicroseconds, uint8_t priority)
+{
+  return AddTask(name, task, context, delayMicroseconds, 0, budgetMicroseconds, priority, false);
+}
+
+void Scheduler_Cancel(int taskId)
+{
+  if (taskId >= 0 && taskId < SCHEDULER_MAX_TASKS)
+    tasks[taskId].active = false;
+}
+
+uint32_t Scheduler_RunFrame(uint32_t frameMicroseconds)
+{
+  const uint32_t frameStart = schedulerClock();
+  const uint32_t deadline = frameStart + frameMicroseconds;
+
+  for (unsigned int i = 0; i < SCHEDULER_MAX_TASKS; i++)
+  {
+    Task &task = tasks[i];
+    if (task.active && task.priority == SCHEDULER_PRIORITY_FRAME && Reached(frameStart, task.nextDue))
+      RunTask(task);
+  }
+
+  // background work in the slack: the longest-waiting due task that still fits goes next
+  for (;;)
+  {
+    const uint32_t time = schedulerClock();
+    Task *next = nullptr;
+
+    for (unsigned int i = 0; i < SCHEDULER_MAX_TASKS; i++)
+    {
+      Task &task = tasks[i];
+      if (!task.active || task.priority != SCHEDULER_PRIORITY_BACKGROUND || !Reached(time, task.nextDue))
+        continue;
+      if (task.lastFrame == schedulerStats.frames || !Reached(deadline, time + task.budget))
+        continue;
+      if (next == nullptr || (int32_t)(task.nextDue - next->nextDue) < 0)
+        next = &task;
+    }
+
+    if (next == nullptr)
+      break;
+    RunTask(*next);
+  }
+
+  // whatever was due and left waiting is deferred to a later frame
+  const uint32_t frameEnd = schedulerClock();
+  for (unsigned int i = 0; i < SCHEDULER_MAX_TASKS; i++)
+  {
+    Task &task = tasks[i];
+    if (task.active && task.priority == SCHEDULER_PRIORITY_BACKGROUND && task.lastFrame != schedulerStats.frames
+        && Reached(frameEnd, task.nextDue))
+      task.stats.deferrals++;
+  }
+
+  schedulerStats.frames++;
+  if (Reached(deadline, frameEnd))
+  {
+    schedulerStats.lastSlackMicroseconds = deadline - frameEnd;
+  }
+  else
+  {
+    schedulerStats.frameOverruns++;
+    schedulerStats.lastSlackMicroseconds = 0;
+  }
+
+  return schedulerStats.lastSlackMicroseconds;
+}
+
+bool Scheduler_GetTaskStats(int taskId, TaskStats *stats)
+{
+  if (taskId < 0 || taskId >= SCHEDULER_MAX_TASKS || tasks[taskId].stats.name == nullptr)
+    return false;
+
+  *stats = tasks[taskId].stats;
+  return true;
+}
+
+SchedulerStats Scheduler_GetStats(void)
+{
+  return schedulerStats;
+}
+
+static int AddTask(const char *name, SchedulerTask function, void *context, uint32_t delay, uint32_t period,
+  uint32_t budget, uint8_t priority, bool periodic)
+{
+  for (int i = 0; i < SCHEDULER_MAX_TASKS; i++)
+  {
+    Task &task = tasks[i];
+    if (task.active)
+      continue;
+
+    task.function = function;
+    task.context = context;
+    task.nextDue = schedulerClock() + delay;
+    task.period = period;
+    task.budget = budget;
+    task.priority = priority;
+    task.periodic = periodic;
+    task.stats = TaskStats();
+    task.stats.name = name;
+    task.lastFrame = schedulerStats.frames - 1;
+    task.active = true;
+    return i;
+  }
+
+  return -1;
+}
+
+static void RunTask(Task &task)
+{
+  // periodic tasks keep their phase, but a task that has fallen a whole period behind
+  // starts again from now rather than running back to back to catch up
+  const uint32_t start = schedulerClock();
+  if (task.periodic)
+  {
+    task.nextDue += task.period;
+    if (Reached(start, task.nextDue))
+      task.nextDue = start + task.period;
+  }
+  task.lastFrame = schedulerStats.frames;
+
+  task.function(task.context);
+
+  const uint32_t elapsed = schedulerClock() - start;
+  task.stats.runs++;
+  task.stats.lastMicroseconds = elapsed;
+  if (elapsed > task.stats.worstMicroseconds)
+    task.stats.worstMicroseconds = elapsed;
+  if (elapsed > task.budget)
+    task.stats.overruns++;
+
+  // one-shot slots are freed only now, so a task that defers itself again gets a fresh slot
+  if (!task.periodic)
+    task.active = false;
+}
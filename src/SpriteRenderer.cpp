@@ -0,0 +1,196 @@
+#include "SpriteRenderer.hpp"
+
+#include <math.h>
+
+#include "SpriteTextures.hpp"
+#include "LightTables.hpp"
+
+#define SPRITE_TEXTURE_COUNT 2
+#define SPRITE_NEAR_PLANE 0.2f
+#define SPRITE_HALF_WIDTH 0.5f // world units, sprites are one map cell wide
+
+SpriteRenderer::SpriteRenderer(void)
+{
+  Clear();
+}
+
+int SpriteRenderer::AddSprite(Vector2 position, unsigned char texture)
+{
+  if (texture >= SPRITE_TEXTURE_COUNT)
+    return -1;
+
+  for (int i = 0; i < MAX_SPRITES; i++)
+  {
+    if (!sprites[i].active)
+    {
+      sprites[i].position = position;
+      sprites[i].texture = texture;
+      sprites[i].active = true;
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+void SpriteRenderer::RemoveSprite(int handle)
+{
+  if (handle < 0 || handle >= MAX_SPRITES)
+    return;
+
+  sprites[handle].active = false;
+}
+
+void SpriteRenderer::SetSpritePosition(int handle, Vector2 position)
+{
+  if (handle < 0 || handle >= MAX_SPRITES)
+    return;
+
+  sprites[handle].position = position;
+}
+
+void SpriteRenderer::Clear(void)
+{
+  for (int i = 0; i < MAX_SPRITES; i++)
+    sprites[i].active = false;
+
+  visibleCount = 0;
+  stats = SpriteStats();
+}
+
+SpriteStats SpriteRenderer::GetStats(void)
+{
+  return stats;
+}
+
+void SpriteRenderer::RenderToDisplay(Raycaster *raycaster, DisplayWrapper *display)
+{
+  const Vector2 cameraPosition = raycaster->GetCameraPosition();
+  const Vector2 cameraDirection = raycaster->GetCameraDirection();
+  Vector2 clipPlaneRightVector = raycaster->GetClipPlaneRightVector();
+  const float distanceToClipPlane = raycaster->GetClipPlaneDistance();
+
+  const float planeLengthSquared = clipPlaneRightVector.SquareLength();
+  const float planeLength = sqrtf(planeLengthSquared);
+  const float tanHalfFOV = planeLength / distanceToClipPlane;
+  const float halfWidth = display->GetWidth() * 0.5f;
+
+  visibleCount = 0;
+  stats = SpriteStats();
+
+  for (int i = 0; i < MAX_SPRITES; i++)
+  {
+    if (!sprites[i].active)
+      continue;
+
+    const float relativeX = sprites[i].position.x - cameraPosition.x;
+    const float relativeY = sprites[i].position.y - cameraPosition.y;
+
+    // camera space: forward along the view direction, lateral along the clip plane (scaled by its length)
+    const float forward = relativeX * cameraDirection.x + relativeY * cameraDirection.y;
+    const float lateralScaled = relativeX * clipPlaneRightVector.x + relativeY * clipPlaneRightVector.y;
+
+    // cheap FOV test before any division: |lateral| - halfWidth < forward * tan(fov / 2)
+    if (forward < SPRITE_NEAR_PLANE || fabsf(lateralScaled) - SPRITE_HALF_WIDTH * planeLength >= forward * tanHalfFOV * planeLength)
+    {
+      stats.culled++;
+      continue;
+    }
+
+    // depth matches the raycaster: distance along the ray measured in clip plane distances
+    const float depth = forward / distanceToClipPlane;
+    const float cameraX = lateralScaled / (depth * planeLengthSquared);
+    InsertVisible(depth, (cameraX + 1.0f) * halfWidth, i);
+  }
+
+  // world units to pixels horizontally at depth 1, so sprites keep the same aspect as walls
+  const float pixelsPerUnitWide = halfWidth / planeLength;
+  const float *depthBuffer = raycaster->GetDepthBuffer();
+
+  // painter's order: farthest first
+  for (int i = visibleCount - 1; i >= 0; i--)
+    DrawSprite(visibleSprites[i], pixelsPerUnitWide, depthBuffer, display);
+
+  stats.drawn = visibleCount;
+}
+
+void SpriteRenderer::InsertVisible(float depth, float screenX, unsigned char index)
+{
+  // visible list is kept sorted nearest first; when full the farthest sprite is dropped
+  int position = visibleCount;
+  if (visibleCount == MAX_VISIBLE_SPRITES)
+  {
+    stats.overBudget++;
+    if (depth >= visibleSprites[MAX_VISIBLE_SPRITES - 1].depth)
+      return;
+    position--;
+  }
+  else
+    visibleCount++;
+
+  while (position > 0 && visibleSprites[position - 1].depth > depth)
+  {
+    visibleSprites[position] = visibleSprites[position - 1];
+    position--;
+  }
+
+  visibleSprites[position].depth = depth;
+  visibleSprites[position].screenX = screenX;
+  visibleSprites[position].index = index;
+}
+
+void SpriteRenderer::DrawSprite(const VisibleSprite &visible, float pixelsPerUnitWide, const float *depthBuffer, DisplayWrapper *display)
+{
+  const int displayWidth = display->GetWidth();
+  const int displayHeight = display->GetHeight();
+  unsigned char *displayBuffer = display->GetBuffer();
+
+  const int spriteHeight = (int)(displayHeight / visible.depth);
+  const int spriteWidth = (int)(pixelsPerUnitWide / visible.depth);
+  if (spriteHeight <= 0 || spriteWidth <= 0)
+    return;
+
+  const int left = (int)(visible.screenX) - (spriteWidth >> 1);
+  const int top = (displayHeight - spriteHeight) >> 1;
+
+  int startX = left < 0 ? 0 : left;
+  int endX = left + spriteWidth;
+  if (endX > displayWidth)
+    endX = displayWidth;
+  if (endX > DEPTH_BUFFER_SIZE)
+    endX = DEPTH_BUFFER_SIZE;
+
+  int startY = top < 0 ? 0 : top;
+  int endY = top + spriteHeight;
+  if (endY > displayHeight)
+    endY = displayHeight;
+
+  // 16.16 fixed point texture stepping, assumes sprite textures are 32 x 32
+  const int textureColumnStep = (32 << 16) / spriteWidth;
+  const int textureRowStep = (32 << 16) / spriteHeight;
+  const int firstTextureRow = (startY - top) * textureRowStep;
+
+  double shade = (visible.depth < 3.0f) ? 1.0 : 1.0 / (visible.depth * 0.333);
+  const unsigned char *lightTable = lightTables.level[LightTables_LevelForShade(shade)];
+  const unsigned char *texture = spriteTextures[sprites[visible.index].texture];
+
+  for (int x = startX; x < endX; x++)
+  {
+    // z-buffer rejection: a wall in this column is nearer than the sprite
+    if (visible.depth >= depthBuffer[x])
+      continue;
+
+    const int textureColumn = ((x - left) * textureColumnStep) >> 16;
+    int textureRow = firstTextureRow;
+
+    for (int y = startY; y < endY; y++)
+    {
+      const unsigned char texel = *(texture + ((textureRow >> 16) << 5) + textureColumn);
+      textureRow += textureRowStep;
+      if (texel == 0) // transparent
+        continue;
+
+      *(displayBuffer + y * displayWidth + x) = lightTable[texel];
+    }
+  }
+}
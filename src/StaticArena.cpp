@@ -0,0 +1,41 @@
+#include "StaticArena.hpp"
+
+alignas(8) static unsigned char arena[STATIC_ARENA_SIZE];
+static size_t arenaUsed;
+static bool arenaSealed;
+static unsigned int failedAllocations;
+
+void *StaticArena_Allocate(size_t size, size_t alignment)
+{
+  // alignment is a power of two
+  const size_t start = (arenaUsed + alignment - 1) & ~(alignment - 1);
+
+  if (arenaSealed || start + size > STATIC_ARENA_SIZE)
+  {
+    failedAllocations++;
+    return nullptr;
+  }
+
+  arenaUsed = start + size;
+  return arena + start;
+}
+
+void StaticArena_Seal(void)
+{
+  arenaSealed = true;
+}
+
+size_t StaticArena_Used(void)
+{
+  return arenaUsed;
+}
+
+size_t StaticArena_Capacity(void)
+{
+  return STATIC_ARENA_SIZE;
+}
+
+unsigned int StaticArena_FailedAllocations(void)
+{
+  return failedAllocations;
+}
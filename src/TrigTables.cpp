@@ -0,0 +1,78 @@
+#include "TrigTables.hpp"
+
+#include <math.h>
+
+// Taylor series about 0, enough terms for double precision over [0, pi / 2]
+static constexpr double ConstexprSin(double x)
+{
+  double term = x;
+  double sum = x;
+
+  for (int n = 1; n < 12; n++)
+  {
+    term *= -x * x / ((2 * n) * (2 * n + 1));
+    sum += term;
+  }
+
+  return sum;
+}
+
+static constexpr TrigTables BuildTrigTables(void)
+{
+  TrigTables tables = {};
+
+  for (int i = 0; i <= TRIG_TABLE_QUARTER; i++)
+    tables.quarterSine[i] = (float)ConstexprSin(i * (M_PI / 2.0) / TRIG_TABLE_QUARTER);
+
+  return tables;
+}
+
+constexpr TrigTables trigTables = BuildTrigTables();
+
+float TrigTables_Sin(BinaryAngle angle)
+{
+  // round to the nearest table step, then fold into the first quadrant
+  const unsigned int step = ((angle + (1 << (BINARY_ANGLE_BITS - TRIG_TABLE_BITS - 1))) & 0xffff) >> (BINARY_ANGLE_BITS - TRIG_TABLE_BITS);
+  const unsigned int index = step & (TRIG_TABLE_QUARTER - 1);
+
+  switch (step >> (TRIG_TABLE_BITS - 2))
+  {
+  case 0:
+    return trigTables.quarterSine[index];
+  case 1:
+    return trigTables.quarterSine[TRIG_TABLE_QUARTER - index];
+  case 2:
+    return -trigTables.quarterSine[index];
+  case 3:
+  default:
+    return -trigTables.quarterSine[TRIG_TABLE_QUARTER - index];
+  }
+}
+
+float TrigTables_Cos(BinaryAngle angle)
+{
+  return TrigTables_Sin((BinaryAngle)(angle + BINARY_ANGLE_QUARTER_TURN));
+}
+
+float TrigTables_Tan(BinaryAngle angle)
+{
+  return TrigTables_Sin(angle) / TrigTables_Cos(angle);
+}
+
+Vector2 TrigTables_Direction(BinaryAngle angle)
+{
+  return Vector2(TrigTables_Cos(angle), TrigTables_Sin(angle));
+}
+
+BinaryAngle TrigTables_FromRadians(double radians)
+{
+  // nearest binary angle, any number of turns (or negative) wraps round
+  double turns = radians * (1.0 / (2.0 * M_PI));
+  turns -= floor(turns);
+  return (BinaryAngle)(lround(turns * (1 << BINARY_ANGLE_BITS)) & 0xffff);
+}
+
+double TrigTables_ToRadians(BinaryAngle angle)
+{
+  return angle * (2.0 * M_PI / (1 << BINARY_ANGLE_BITS));
+}
@@ -0,0 +1,414 @@
+#include "VisibilitySet.hpp"
+
+#include <math.h>
+#include <string.h>
+
+// sample points keep this far from the cell edges, so rays do not run along the walls
+#define SAMPLE_INSET 0.015625
+
+static bool GetBit(const uint8_t *bits, uint32_t bit)
+{
+  return (bits[bit >> 3] >> (bit & 7)) & 1;
+}
+
+static void SetBit(uint8_t *bits, uint32_t bit, bool value)
+{
+  if (value)
+    bits[bit >> 3] |= 1 << (bit & 7);
+  else
+    bits[bit >> 3] &= ~(1 << (bit & 7));
+}
+
+static unsigned int CountBits(const uint8_t *bits, uint32_t count)
+{
+  unsigned int set = 0;
+  for (uint32_t bit = 0; bit < count; bit++)
+    set += GetBit(bits, bit);
+  return set;
+}
+
+// pair (a, b) with a <= b is bit b * (b + 1) / 2 + a: each cell's pairs with the cells before it
+// follow the previous cell's, so adding or removing a cell moves every later pair the same way
+static uint32_t PairBit(unsigned int a, unsigned int b)
+{
+  if (a > b)
+  {
+    const unsigned int swap = a;
+    a = b;
+    b = swap;
+  }
+  return (uint32_t)b * (b + 1) / 2 + a;
+}
+
+static double SampleOffset(unsigned int sample)
+{
+  if (VISIBILITY_SAMPLES_PER_AXIS == 1)
+    return 0.5;
+
+  return SAMPLE_INSET + (1.0 - 2.0 * SAMPLE_INSET) * sample / (VISIBILITY_SAMPLES_PER_AXIS - 1);
+}
+
+VisibilitySet::VisibilitySet(Raycaster *raycaster)
+{
+  this->raycaster = raycaster;
+  mapWidth = raycaster->mapWidth;
+  mapHeight = raycaster->mapHeight;
+  pairsTested = 0;
+  raysCast = 0;
+  Invalidate();
+}
+
+void VisibilitySet::Invalidate(void)
+{
+  IndexCells();
+  memset(pairs, 0, sizeof(pairs));
+  memset(pending, 0, sizeof(pending));
+  memset(region, 0, sizeof(region));
+  memset(wholeRow, 0, sizeof(wholeRow));
+  memset(opened, 0, sizeof(opened));
+  for (unsigned int i = 0; i < openCount; i++)
+  {
+    SetBit(pending, i, true);
+    SetBit(region, i, true);
+    SetBit(wholeRow, i, true);
+  }
+  pendingCount = openCount;
+  currentCell = -1;
+  nextPartner = 0;
+}
+
+void VisibilitySet::Update(unsigned int maxPairs)
+{
+  unsigned int tested = 0;
+
+  while (tested < maxPairs && pendingCount > 0)
+  {
+    if (currentCell < 0)
+    {
+      // newly opened cells go first, since what they can see decides what else is retested
+      currentCell = 0;
+      while (currentCell < (int)openCount && !GetBit(opened, currentCell))
+        currentCell++;
+      if (currentCell == (int)openCount)
+      {
+        currentCell = 0;
+        while (!GetBit(pending, currentCell))
+          currentCell++;
+      }
+      nextPartner = 0;
+    }
+
+    const unsigned int cell = currentCell;
+    if (nextPartner >= openCount)
+    {
+      SetBit(pending, cell, false);
+      SetBit(wholeRow, cell, false);
+      currentCell = -1;
+      pendingCount--;
+      if (GetBit(opened, cell))
+      {
+        // every pair that can now see through the cell has both ends in its row
+        SetBit(opened, cell, false);
+        for (unsigned int i = 0; i < openCount; i++)
+        {
+          if (i != cell && GetPair(cell, i))
+            MarkCell(i);
+        }
+        pendingCount = CountBits(pending, openCount);
+      }
+      if (pendingCount == 0)
+        memset(region, 0, sizeof(region));
+      continue;
+    }
+
+    // pairs with other pending cells are left to whichever of the two comes last
+    const unsigned int partner = nextPartner++;
+    if (partner != cell && GetBit(pending, partner))
+      continue;
+    if (!GetBit(region, partner) && !GetBit(wholeRow, cell))
+      continue;
+
+    SetPair(cell, partner, TestPair(cell, partner));
+    tested++;
+  }
+}
+
+void VisibilitySet::Build(void)
+{
+  Invalidate();
+  while (pendingCount > 0)
+    Update(VISIBILITY_PAIRS_PER_FRAME);
+}
+
+bool VisibilitySet::IsComplete(void)
+{
+  return pendingCount == 0;
+}
+
+void VisibilitySet::TileChanged(int x, int y)
+{
+  if (x < 0 || x >= mapWidth || y < 0 || y >= mapHeight)
+    return;
+  if (overflowed)
+  {
+    // the open cells may fit again
+    Invalidate();
+    return;
+  }
+
+  const uint16_t cell = y * mapWidth + x;
+  const bool wasOpen = (openIndex[cell] != VISIBILITY_NOT_OPEN);
+  const bool isOpen = IsOpen(x, y);
+
+  // any pair of cells whose rays cross the tile can see it, or an open cell around it that the
+  // rays come through: those rows are what gets retested. They are gathered first, so marking one
+  // row pending does not make the next look unfinished
+  uint8_t affected[VISIBILITY_CELL_BYTES];
+  memset(affected, 0, sizeof(affected));
+  for (int ny = y - 1; ny <= y + 1; ny++)
+  {
+    for (int nx = x - 1; nx <= x + 1; nx++)
+    {
+      if (nx >= 0 && nx < mapWidth && ny >= 0 && ny < mapHeight && openIndex[ny * mapWidth + nx] != VISIBILITY_NOT_OPEN)
+        MarkRow(openIndex[ny * mapWidth + nx], affected);
+    }
+  }
+  for (unsigned int i = 0; i < openCount; i++)
+  {
+    if (GetBit(affected, i))
+      MarkCell(i);
+  }
+
+  if (wasOpen && !isOpen)
+  {
+    RemoveCell(openIndex[cell]);
+  }
+  else if (!wasOpen && isOpen)
+  {
+    if (openCount == VISIBILITY_MAX_OPEN_CELLS)
+    {
+      Invalidate();
+      return;
+    }
+
+    unsigned int index = 0;
+    while (index < openCount && openCells[index] < cell)
+      index++;
+    InsertCell(index, cell);
+    // the cells a newly opened cell turns out to see are retested after it
+    SetBit(opened, index, true);
+  }
+
+  // the tile and the cells around it are retested against every cell: rays that only just pass
+  // the tile's corners start or end there
+  for (int ny = y - 1; ny <= y + 1; ny++)
+  {
+    for (int nx = x - 1; nx <= x + 1; nx++)
+    {
+      if (nx >= 0 && nx < mapWidth && ny >= 0 && ny < mapHeight && openIndex[ny * mapWidth + nx] != VISIBILITY_NOT_OPEN)
+      {
+        MarkCell(openIndex[ny * mapWidth + nx]);
+        SetBit(wholeRow, openIndex[ny * mapWidth + nx], true);
+      }
+    }
+  }
+
+  pendingCount = CountBits(pending, openCount);
+  currentCell = -1;
+  nextPartner = 0;
+}
+
+bool VisibilitySet::IsPotentiallyVisible(int fromX, int fromY, int toX, int toY)
+{
+  if (overflowed || fromX < 0 || fromX >= mapWidth || fromY < 0 || fromY >= mapHeight ||
+    toX < 0 || toX >= mapWidth || toY < 0 || toY >= mapHeight)
+    return true;
+
+  const unsigned int from = openIndex[fromY * mapWidth + fromX];
+  const unsigned int to = openIndex[toY * mapWidth + toX];
+  if (from == VISIBILITY_NOT_OPEN || to == VISIBILITY_NOT_OPEN)
+    return true;
+  if (GetBit(pending, from) || GetBit(pending, to))
+    return true;
+
+  return GetPair(from, to);
+}
+
+bool VisibilitySet::IsPotentiallyVisible(Vector2 from, Vector2 to)
+{
+  return IsPotentiallyVisible((int)floor(from.x), (int)floor(from.y), (int)floor(to.x), (int)floor(to.y));
+}
+
+VisibilityStats VisibilitySet::GetStats(void)
+{
+  VisibilityStats stats;
+  stats.openCells = openCount;
+  stats.pendingCells = pendingCount;
+  stats.visiblePairs = 0;
+  for (unsigned int a = 0; a < openCount; a++)
+  {
+    for (unsigned int b = a + 1; b < openCount; b++)
+      stats.visiblePairs += GetPair(a, b);
+  }
+  stats.pairsTested = pairsTested;
+  stats.raysCast = raysCast;
+  stats.bytes = sizeof(VisibilitySet);
+  return stats;
+}
+
+bool VisibilitySet::IsOpen(int x, int y)
+{
+  // same cells as Raycaster::WallAtMapPosition: columns are mirrored
+  if (x < 0 || x >= mapWidth || y < 0 || y >= mapHeight)
+    return false;
+
+  return raycaster->worldMap[y * mapWidth + (mapWidth - 1 - x)] == 0;
+}
+
+void VisibilitySet::IndexCells(void)
+{
+  openCount = 0;
+  overflowed = (mapWidth * mapHeight > VISIBILITY_MAX_MAP_CELLS);
+  if (overflowed)
+    return;
+
+  for (int cell = 0; cell < mapWidth * mapHeight; cell++)
+  {
+    openIndex[cell] = VISIBILITY_NOT_OPEN;
+    if (!IsOpen(cell % mapWidth, cell / mapWidth))
+      continue;
+    if (openCount == VISIBILITY_MAX_OPEN_CELLS)
+    {
+      overflowed = true;
+      openCount = 0;
+      return;
+    }
+    openCells[openCount] = cell;
+    openIndex[cell] = openCount++;
+  }
+}
+
+void VisibilitySet::InsertCell(unsigned int index, uint16_t cell)
+{
+  const unsigned int count = openCount + 1;
+
+  // every pair moves up to its new bit, last first so nothing is overwritten before it is moved;
+  // the new cell's own pairs start clear
+  for (int b = count - 1; b >= 0; b--)
+  {
+    for (int a = b; a >= 0; a--)
+    {
+      bool visible = false;
+      if ((unsigned int)a != index && (unsigned int)b != index)
+        visible = GetBit(pairs, PairBit(a - ((unsigned int)a > index), b - ((unsigned int)b > index)));
+      SetBit(pairs, PairBit(a, b), visible);
+    }
+  }
+
+  for (unsigned int i = count - 1; i > index; i--)
+  {
+    SetBit(pending, i, GetBit(pending, i - 1));
+    SetBit(region, i, GetBit(region, i - 1));
+    SetBit(wholeRow, i, GetBit(wholeRow, i - 1));
+    SetBit(opened, i, GetBit(opened, i - 1));
+    openCells[i] = openCells[i - 1];
+    openIndex[openCells[i]] = i;
+  }
+  SetBit(pending, index, false);
+  SetBit(region, index, false);
+  SetBit(wholeRow, index, false);
+  SetBit(opened, index, false);
+  openCells[index] = cell;
+  openIndex[cell] = index;
+  openCount = count;
+}
+
+void VisibilitySet::RemoveCell(unsigned int index)
+{
+  const unsigned int count = openCount - 1;
+
+  // the reverse of InsertCell: every pair moves down, first first
+  for (unsigned int b = 0; b < count; b++)
+  {
+    for (unsigned int a = 0; a <= b; a++)
+      SetBit(pairs, PairBit(a, b), GetBit(pairs, PairBit(a + (a >= index), b + (b >= index))));
+  }
+
+  openIndex[openCells[index]] = VISIBILITY_NOT_OPEN;
+  for (unsigned int i = index; i < count; i++)
+  {
+    SetBit(pending, i, GetBit(pending, i + 1));
+    SetBit(region, i, GetBit(region, i + 1));
+    SetBit(wholeRow, i, GetBit(wholeRow, i + 1));
+    SetBit(opened, i, GetBit(opened, i + 1));
+    openCells[i] = openCells[i + 1];
+    openIndex[openCells[i]] = i;
+  }
+  SetBit(pending, count, false);
+  SetBit(region, count, false);
+  SetBit(wholeRow, count, false);
+  SetBit(opened, count, false);
+  openCount = count;
+}
+
+void VisibilitySet::MarkRow(unsigned int index, uint8_t *cells)
+{
+  // a row still being tested is incomplete, so every cell counts
+  const bool everything = GetBit(pending, index);
+  for (unsigned int i = 0; i < openCount; i++)
+  {
+    if (everything || GetPair(index, i))
+      SetBit(cells, i, true);
+  }
+}
+
+void VisibilitySet::MarkCell(unsigned int index)
+{
+  SetBit(pending, index, true);
+  SetBit(region, index, true);
+}
+
+bool VisibilitySet::GetPair(unsigned int a, unsigned int b)
+{
+  return GetBit(pairs, PairBit(a, b));
+}
+
+void VisibilitySet::SetPair(unsigned int a, unsigned int b, bool visible)
+{
+  SetBit(pairs, PairBit(a, b), visible);
+}
+
+bool VisibilitySet::TestPair(unsigned int a, unsigned int b)
+{
+  pairsTested++;
+  if (a == b)
+    return true;
+
+  // rays that graze a corner can get through one way and not the other, so a pair is always cast
+  // the same way round, whichever of its cells is being retested
+  if (a > b)
+  {
+    const unsigned int swap = a;
+    a = b;
+    b = swap;
+  }
+
+  const int ax = openCells[a] % mapWidth;
+  const int ay = openCells[a] / mapWidth;
+  const int bx = openCells[b] % mapWidth;
+  const int by = openCells[b] / mapWidth;
+
+  for (unsigned int fromSample = 0; fromSample < VISIBILITY_SAMPLES_PER_AXIS * VISIBILITY_SAMPLES_PER_AXIS; fromSample++)
+  {
+    const Vector2 from(ax + SampleOffset(fromSample % VISIBILITY_SAMPLES_PER_AXIS), ay + SampleOffset(fromSample / VISIBILITY_SAMPLES_PER_AXIS));
+    for (unsigned int toSample = 0; toSample < VISIBILITY_SAMPLES_PER_AXIS * VISIBILITY_SAMPLES_PER_AXIS; toSample++)
+    {
+      const Vector2 to(bx + SampleOffset(toSample % VISIBILITY_SAMPLES_PER_AXIS), by + SampleOffset(toSample / VISIBILITY_SAMPLES_PER_AXIS));
+      raysCast++;
+      if (raycaster->HasLineOfSight(from, to))
+        return true;
+    }
+  }
+
+  return false;
+}
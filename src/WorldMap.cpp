@@ -0,0 +1,29 @@
+#include "WorldMap.hpp"
+
+int worldMap[MAP_HEIGHT][MAP_WIDTH] =
+{
+  {4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 8, 8, 8, 8, 8, 8, 8, 8},
+  {4, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 8, 0, 0, 0, 0, 0, 0, 8},
+  {4, 0,13, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 8},
+  {4, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 8},
+  {4, 0,10, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 8, 0, 0, 0, 0, 0, 0, 8},
+  {4, 0, 4, 0, 0, 0, 0,13,13,13,13,13,13,13,13,13, 8, 8, 0, 8, 8, 8, 8, 8},
+  {4, 0,13, 0, 0, 0, 0,13, 0,13, 0,13, 0,13, 0,13, 8, 0, 0, 0, 8, 8, 8, 8},
+  {4, 0, 9, 0, 0, 0, 0,13, 0, 0, 0, 0, 0, 0, 0,13, 8, 0, 0, 0, 0, 0, 0,14},
+  {4, 0, 8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 8, 8, 8, 8},
+  {4, 0,14, 0, 0, 0, 0,13, 0, 0, 0, 0, 0, 0, 0,13, 8, 0, 0, 0, 0, 0, 0,14},
+  {4, 0, 0, 0, 0, 0, 0,13, 0, 0, 0, 0, 0, 0, 0,13, 8, 0, 0, 0, 8, 8, 8, 8},
+  {4, 0, 0, 0, 0, 0, 0,13,13,13,13, 0,13,13,13,13, 8, 8, 8, 8, 8, 8, 8, 8},
+  {9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 0, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9},
+  {9, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 4},
+  {9, 9, 9, 9, 9, 9, 0, 9, 9, 9, 9, 0, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9},
+  {4, 4, 4, 4, 4, 4, 0, 4, 4, 4, 9, 0, 9, 3, 3, 3, 3, 3, 3, 3,10,10,10, 3},
+  {4, 0, 0, 0, 0, 0, 0, 0, 0, 4, 9, 0, 9, 3, 0, 0, 0, 0, 0, 3, 0, 0, 0, 3},
+  {4, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 9, 3, 0, 0,13, 0, 0, 3, 0, 0, 0, 3},
+  {4, 0, 0, 0, 0, 0, 0, 0, 0, 4, 9, 0, 9, 3, 0, 0, 0, 0, 0, 3, 3, 0, 3, 3},
+  {4, 0, 9, 0, 9, 0, 0, 0, 0, 4, 9, 0, 0, 0, 0, 0,13, 0, 0, 0, 0, 0, 0, 3},
+  {4, 0, 0,13, 0, 0, 0, 0, 0, 4, 9, 0, 9, 3, 0, 0, 0, 0, 0, 3, 3, 0, 3, 3},
+  {4, 0, 9, 0, 9, 0, 0, 0, 0, 4, 9, 0, 9, 3, 0, 0,13, 0, 0, 3, 0, 0, 0, 3},
+  {4, 0, 0, 0, 0, 0, 0, 0, 0, 4, 9, 0, 9, 3, 0, 0, 0, 0, 0, 3, 0, 0, 0, 3},
+  {4, 4, 4, 4, 4, 4, 4, 4, 4, 4,13,13,13, 3, 3, 3, 3, 3, 3, 3,10,10,10, 3}
+};
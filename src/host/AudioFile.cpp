@@ -0,0 +1,49 @@
+#include "AudioFile.hpp"
+
+#include <stdio.h>
+
+// WAV fields are little-endian whatever the host
+static void Put16(unsigned char *bytes, unsigned int value)
+{
+  bytes[0] = value & 0xff;
+  bytes[1] = (value >> 8) & 0xff;
+}
+
+static void Put32(unsigned char *bytes, unsigned int value)
+{
+  Put16(bytes, value & 0xffff);
+  Put16(bytes + 2, value >> 16);
+}
+
+bool AudioFile_WriteWAV(const char *path, const int16_t *samples, unsigned int sampleCount, unsigned int sampleRate)
+{
+  FILE *file = fopen(path, "wb");
+  if (file == nullptr)
+    return false;
+
+  const unsigned int dataBytes = sampleCount * 2;
+  unsigned char header[44] = { 'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'A', 'V', 'E', 'f', 'm', 't', ' ' };
+  Put32(header + 4, 36 + dataBytes);
+  Put32(header + 16, 16);             // fmt chunk size
+  Put16(header + 20, 1);              // PCM
+  Put16(header + 22, 1);              // mono
+  Put32(header + 24, sampleRate);
+  Put32(header + 28, sampleRate * 2); // bytes per second
+  Put16(header + 32, 2);              // bytes per frame
+  Put16(header + 34, 16);             // bits per sample
+  header[36] = 'd';
+  header[37] = 'a';
+  header[38] = 't';
+  header[39] = 'a';
+  Put32(header + 40, dataBytes);
+
+  bool written = fwrite(header, 1, sizeof(header), file) == sizeof(header);
+  unsigned char sample[2];
+  for (unsigned int i = 0; written && i < sampleCount; i++)
+  {
+    Put16(sample, (uint16_t)samples[i]);
+    written = fwrite(sample, 1, 2, file) == 2;
+  }
+
+  return (fclose(file) == 0) && written;
+}
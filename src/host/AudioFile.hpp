@@ -0,0 +1,9 @@
+#ifndef AUDIO_FILE_HPP
+#define AUDIO_FILE_HPP
+
+#include <stdint.h>
+
+// mono 16-bit PCM WAV
+bool AudioFile_WriteWAV(const char *path, const int16_t *samples, unsigned int sampleCount, unsigned int sampleRate);
+
+#endif
\ No newline at end of file
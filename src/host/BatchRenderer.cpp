@@ -0,0 +1,60 @@
+#include "BatchRenderer.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+static void RenderPoses(Raycaster raycaster, const CameraPose *poses, DisplayWrapper **displays, unsigned int count, std::atomic<unsigned int> *nextPose)
+{
+  // raycaster is this worker's own copy
+  unsigned int pose;
+  while ((pose = nextPose->fetch_add(1, std::memory_order_relaxed)) < count)
+  {
+    raycaster.SetCameraPosition(poses[pose].position);
+    raycaster.SetCameraDirection(poses[pose].direction);
+    displays[pose]->Clear();
+    raycaster.RenderToDisplay(displays[pose]);
+  }
+}
+
+BatchRenderer::BatchRenderer(unsigned int threadCount)
+{
+  if (threadCount < 1)
+    threadCount = 1;
+
+  this->threadCount = threadCount;
+  stats = BatchRenderStats();
+}
+
+unsigned int BatchRenderer::GetThreadCount(void)
+{
+  return threadCount;
+}
+
+BatchRenderStats BatchRenderer::GetStats(void)
+{
+  return stats;
+}
+
+void BatchRenderer::Render(const Raycaster &prototype, const CameraPose *poses, DisplayWrapper **displays, unsigned int count)
+{
+  const unsigned int workers = (count < threadCount) ? count : threadCount;
+  std::atomic<unsigned int> nextPose(0);
+  std::vector<std::thread> threads;
+
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  // the calling thread works too
+  for (unsigned int worker = 1; worker < workers; worker++)
+    threads.push_back(std::thread(RenderPoses, prototype, poses, displays, count, &nextPose));
+  RenderPoses(prototype, poses, displays, count, &nextPose);
+
+  for (unsigned int i = 0; i < threads.size(); i++)
+    threads[i].join();
+
+  stats.frames = count;
+  stats.threads = (workers > 0) ? workers : 1;
+  stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  stats.framesPerSecondPerCore = (stats.seconds > 0.0) ? count / stats.seconds / stats.threads : 0.0;
+}
@@ -0,0 +1,41 @@
+#ifndef BATCH_RENDERER_HPP
+#define BATCH_RENDERER_HPP
+
+#include "Vector2.hpp"
+#include "Raycaster.hpp"
+#include "DisplayWrapper.hpp"
+
+struct CameraPose
+{
+  Vector2 position;
+  Vector2 direction;
+};
+
+struct BatchRenderStats
+{
+  unsigned int frames;
+  unsigned int threads;
+  double seconds;
+  double framesPerSecondPerCore;
+};
+
+// Renders many independent views at once for offline work (thumbnails, coverage checks,
+// regression images). Each worker thread gets its own copy of the prototype raycaster as scratch
+// state (camera, depth buffer, wall spans); the map and textures stay shared and read-only.
+// Workers pull the next pose from a shared counter, so cheap and expensive views balance out.
+class BatchRenderer
+{
+public:
+  BatchRenderer(unsigned int threadCount);
+
+  // renders poses[i] into displays[i] for every i < count, using prototype's map and settings
+  void Render(const Raycaster &prototype, const CameraPose *poses, DisplayWrapper **displays, unsigned int count);
+  unsigned int GetThreadCount(void);
+  BatchRenderStats GetStats(void);
+
+private:
+  unsigned int threadCount;
+  BatchRenderStats stats;
+};
+
+#endif
\ No newline at end of file
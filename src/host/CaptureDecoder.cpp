@@ -0,0 +1,139 @@
+#include "CaptureDecoder.hpp"
+
+#include <stddef.h>
+#include <string.h>
+#include <algorithm>
+
+static uint32_t Get16(const unsigned char *bytes)
+{
+  return bytes[0] | (bytes[1] << 8);
+}
+
+static uint32_t Get32(const unsigned char *bytes)
+{
+  return Get16(bytes) | (Get16(bytes + 2) << 16);
+}
+
+CaptureDecodeStats CaptureDecoder_Decode(const std::vector<unsigned char> &stream, std::vector<CapturedFrame> &frames)
+{
+  CaptureDecodeStats stats = {};
+  CapturedFrame frame;
+  bool inFrame = false;
+  unsigned int decodedBytes = 0;
+  std::vector<unsigned char> previousPages;
+
+  size_t i = 0;
+  while (i < stream.size())
+  {
+    if (stream[i] != FRAME_CAPTURE_SYNC || i + 1 >= stream.size())
+    {
+      stats.skippedBytes++;
+      i++;
+      continue;
+    }
+
+    const unsigned char type = stream[i + 1];
+    const size_t remaining = stream.size() - i;
+
+    if (type == FRAME_CAPTURE_FRAME && remaining >= FRAME_CAPTURE_FRAME_PACKET_SIZE)
+    {
+      if (inFrame)
+        stats.incompleteFrames++;
+
+      const unsigned char *packet = &stream[i];
+      frame.number = Get32(packet + 2);
+      frame.milliseconds = Get32(packet + 6);
+      frame.frameMicroseconds = Get32(packet + 10);
+      frame.format = (CaptureFormat)packet[14];
+      const unsigned char delta = packet[15];
+      frame.width = Get16(packet + 16);
+      frame.height = Get16(packet + 18);
+      frame.encodedBytes = FRAME_CAPTURE_FRAME_PACKET_SIZE;
+      frame.checksumMatches = false;
+      frame.data.assign((frame.format == CaptureGreyscale) ? frame.width * frame.height : frame.width * frame.height / 8, 0);
+      // the delta kind rides along in the header until the frame is complete
+      frame.data.push_back((unsigned char)delta);
+      decodedBytes = 0;
+      inFrame = true;
+      i += FRAME_CAPTURE_FRAME_PACKET_SIZE;
+    }
+    else if (type == FRAME_CAPTURE_DATA && remaining >= 4 && remaining >= 4 + Get16(&stream[i + 2]))
+    {
+      const unsigned int length = Get16(&stream[i + 2]);
+      if (inFrame)
+      {
+        const unsigned int size = frame.data.size() - 1;
+        if (frame.data.back() & FRAME_CAPTURE_STORED)
+        {
+          const unsigned int copied = std::min(length, size - decodedBytes);
+          memcpy(&frame.data[decodedBytes], &stream[i + 4], copied);
+          decodedBytes += copied;
+        }
+        else
+          decodedBytes += FrameCapture_UnpackBits(&stream[i + 4], length, &frame.data[decodedBytes], size - decodedBytes);
+        frame.encodedBytes += 4 + length;
+      }
+      i += 4 + length;
+    }
+    else if (type == FRAME_CAPTURE_END && remaining >= FRAME_CAPTURE_END_PACKET_SIZE)
+    {
+      const uint32_t checksum = Get32(&stream[i + 2]);
+      i += FRAME_CAPTURE_END_PACKET_SIZE;
+      if (!inFrame)
+        continue;
+      inFrame = false;
+
+      const CaptureDelta delta = (CaptureDelta)(frame.data.back() & ~FRAME_CAPTURE_STORED);
+      frame.data.pop_back();
+      frame.encodedBytes += FRAME_CAPTURE_END_PACKET_SIZE;
+      if (decodedBytes != frame.data.size())
+      {
+        stats.incompleteFrames++;
+        continue;
+      }
+
+      if (delta == DeltaRowAbove)
+      {
+        for (size_t p = frame.width; p < frame.data.size(); p++)
+          frame.data[p] ^= frame.data[p - frame.width];
+      }
+      else if (delta == DeltaPreviousFrame)
+      {
+        if (previousPages.size() != frame.data.size())
+          continue;
+        for (size_t p = 0; p < frame.data.size(); p++)
+          frame.data[p] ^= previousPages[p];
+      }
+
+      frame.checksumMatches = FrameCapture_Checksum(&frame.data[0], frame.data.size()) == checksum;
+      if (frame.format == CapturePages)
+        previousPages = frame.checksumMatches ? frame.data : std::vector<unsigned char>();
+      frames.push_back(frame);
+    }
+    else
+    {
+      // a sync byte inside text, or a packet cut off by the end of the stream
+      stats.skippedBytes++;
+      i++;
+    }
+  }
+
+  if (inFrame)
+    stats.incompleteFrames++;
+
+  return stats;
+}
+
+std::vector<unsigned char> CaptureDecoder_ToGreyscale(const CapturedFrame &frame)
+{
+  if (frame.format == CaptureGreyscale)
+    return frame.data;
+
+  std::vector<unsigned char> pixels(frame.width * frame.height);
+  for (unsigned int y = 0; y < frame.height; y++)
+  {
+    for (unsigned int x = 0; x < frame.width; x++)
+      pixels[y * frame.width + x] = ((frame.data[(y >> 3) * frame.width + x] >> (y & 7)) & 1) ? 255 : 0;
+  }
+  return pixels;
+}
@@ -0,0 +1,35 @@
+#ifndef CAPTURE_DECODER_HPP
+#define CAPTURE_DECODER_HPP
+
+#include <stdint.h>
+#include <vector>
+
+#include "FrameCapture.hpp"
+
+struct CapturedFrame
+{
+  uint32_t number;
+  uint32_t milliseconds;
+  uint32_t frameMicroseconds; // what the frame cost on the device
+  CaptureFormat format;
+  unsigned int width;
+  unsigned int height;
+  unsigned int encodedBytes;  // packet bytes on the wire, headers included
+  bool checksumMatches;
+  std::vector<unsigned char> data; // greyscale pixels or OLED pages, as captured
+};
+
+struct CaptureDecodeStats
+{
+  unsigned int skippedBytes;     // text and anything else between packets
+  unsigned int incompleteFrames; // cut short by a new frame or the end of the stream
+};
+
+// Reassembles every complete frame in a capture stream, undoing the delta coding. Page frames
+// sent as deltas after a lost frame are dropped until the next keyframe.
+CaptureDecodeStats CaptureDecoder_Decode(const std::vector<unsigned char> &stream, std::vector<CapturedFrame> &frames);
+
+// row-major 8-bit pixels for either format: page bits become 0 or 255
+std::vector<unsigned char> CaptureDecoder_ToGreyscale(const CapturedFrame &frame);
+
+#endif
\ No newline at end of file
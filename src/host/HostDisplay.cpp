@@ -0,0 +1,91 @@
+#include "DisplayWrapper.hpp"
+
+#include <string.h>
+
+#include "PixelKernels.hpp"
+#include "SharedFrameRing.hpp"
+
+// host backend for DisplayWrapper: the greyscale frame stays in memory for the host tools,
+// there is no OLED to present to
+
+DisplayWrapper::DisplayWrapper(void)
+  : DisplayWrapper(DISPLAY_WIDTH, DISPLAY_HEIGHT)
+{
+}
+
+DisplayWrapper::DisplayWrapper(unsigned int width, unsigned int height)
+{
+  this->width = width;
+  this->height = height;
+  bufferSize = width * height;
+  displayBuffer = new unsigned char[bufferSize];
+  // stands in for the u8g2 frame buffer, one bit per pixel
+  pageBuffer = new unsigned char[bufferSize >> 3];
+  memset(pageBuffer, 0, bufferSize >> 3);
+  sharedFrames = nullptr;
+  Clear();
+}
+
+DisplayWrapper::DisplayWrapper(SharedFrameRing *ring)
+{
+  width = ring->GetWidth();
+  height = ring->GetHeight();
+  bufferSize = width * height;
+  displayBuffer = nullptr;
+  pageBuffer = nullptr;
+  sharedFrames = ring;
+  Clear();
+}
+
+DisplayWrapper::~DisplayWrapper(void)
+{
+  if (sharedFrames)
+    return;
+  delete[] displayBuffer;
+  delete[] pageBuffer;
+}
+
+unsigned char* DisplayWrapper::GetBuffer(void)
+{
+  return displayBuffer;
+}
+
+void DisplayWrapper::Clear(void)
+{
+  // every frame starts with a Clear, so this is where the next shared slot is taken
+  if (sharedFrames)
+    sharedFrames->BeginFrame(&displayBuffer, &pageBuffer);
+  memset(displayBuffer, 0, bufferSize);
+}
+
+unsigned int DisplayWrapper::GetWidth(void)
+{
+  return width;
+}
+
+unsigned int DisplayWrapper::GetHeight(void)
+{
+  return height;
+}
+
+unsigned char* DisplayWrapper::GetPageBuffer(void)
+{
+  return pageBuffer;
+}
+
+void DisplayWrapper::Render(bool dither)
+{
+  PreparePages(dither);
+  SendPages();
+}
+
+void DisplayWrapper::PreparePages(bool dither)
+{
+  PixelKernels_RenderPages(displayBuffer, pageBuffer, width, height, dither);
+}
+
+void DisplayWrapper::SendPages(void)
+{
+  if (sharedFrames)
+    sharedFrames->Publish();
+}
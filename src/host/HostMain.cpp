@@ -0,0 +1,2460 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "DisplayWrapper.hpp"
+#include "Vector2.hpp"
+#include "Raycaster.hpp"
+#include "WorldMap.hpp"
+#include "ImageFile.hpp"
+#include "PixelKernels.hpp"
+#include "ParallelRenderer.hpp"
+#include "BatchRenderer.hpp"
+#include "AudioMixer.hpp"
+#include "AudioFile.hpp"
+#include "Scheduler.hpp"
+#include "FramePacer.hpp"
+#include "FrameCapture.hpp"
+#include "CaptureDecoder.hpp"
+#include "SpriteRenderer.hpp"
+#include "TrigTables.hpp"
+#include "SharedFrameRing.hpp"
+#include "EntityStore.hpp"
+#include "FlowField.hpp"
+#include "VisibilitySet.hpp"
+#include "Automap.hpp"
+#include "LightMap.hpp"
+#include "MelodyPlayer.hpp"
+
+// positions spread over the shipped map, each swept through a full turn
+static const double testPositions[][2] =
+{
+  { 17.5, 22.5 },
+  {  3.5,  3.5 },
+  { 10.2, 13.5 },
+  { 11.5, 18.5 },
+  { 17.9, 21.1 },
+  {  8.5,  2.5 },
+  { 14.05, 16.5 },
+  { 20.5,  7.5 }
+};
+#define TEST_POSITION_COUNT (sizeof(testPositions) / sizeof(testPositions[0]))
+
+static double ElapsedMicroseconds(std::chrono::steady_clock::time_point start);
+static void SetTestPose(Raycaster *raycaster, unsigned int frame, unsigned int framesPerPosition);
+static int Preview(int argc, char **argv);
+static int PacketCheck(int argc, char **argv);
+static int KernelCheck(int argc, char **argv);
+static int ParallelBench(int argc, char **argv);
+static int BatchBench(int argc, char **argv);
+static int AudioBench(int argc, char **argv);
+static int SchedulerSim(int argc, char **argv);
+static int PacingSim(int argc, char **argv);
+static int RenderStatsSweep(int argc, char **argv);
+static int CaptureDecode(int argc, char **argv);
+static int CaptureCheck(int argc, char **argv);
+static int GoldenCheck(int argc, char **argv);
+static int GoldenUpdate(int argc, char **argv);
+static int Live(int argc, char **argv);
+static int View(int argc, char **argv);
+static int EntityBench(int argc, char **argv);
+static int FlowBench(int argc, char **argv);
+static int RayBench(int argc, char **argv);
+static int VisibilityBench(int argc, char **argv);
+static int AutomapCheck(int argc, char **argv);
+static int LightBench(int argc, char **argv);
+static int MelodyCheck(int argc, char **argv);
+static void PrintUsage(void);
+
+int main(int argc, char **argv)
+{
+  if (argc < 2)
+  {
+    PrintUsage();
+    return 1;
+  }
+
+  if (strcmp(argv[1], "preview") == 0)
+    return Preview(argc - 2, argv + 2);
+  if (strcmp(argv[1], "packet-check") == 0)
+    return PacketCheck(argc - 2, argv + 2);
+  if (strcmp(argv[1], "kernel-check") == 0)
+    return KernelCheck(argc - 2, argv + 2);
+  if (strcmp(argv[1], "parallel-bench") == 0)
+    return ParallelBench(argc - 2, argv + 2);
+  if (strcmp(argv[1], "batch-bench") == 0)
+    return BatchBench(argc - 2, argv + 2);
+  if (strcmp(argv[1], "audio-bench") == 0)
+    return AudioBench(argc - 2, argv + 2);
+  if (strcmp(argv[1], "scheduler-sim") == 0)
+    return SchedulerSim(argc - 2, argv + 2);
+  if (strcmp(argv[1], "pacing-sim") == 0)
+    return PacingSim(argc - 2, argv + 2);
+  if (strcmp(argv[1], "render-stats") == 0)
+    return RenderStatsSweep(argc - 2, argv + 2);
+  if (strcmp(argv[1], "capture-decode") == 0)
+    return CaptureDecode(argc - 2, argv + 2);
+  if (strcmp(argv[1], "capture-check") == 0)
+    return CaptureCheck(argc - 2, argv + 2);
+  if (strcmp(argv[1], "golden-check") == 0)
+    return GoldenCheck(argc - 2, argv + 2);
+  if (strcmp(argv[1], "golden-update") == 0)
+    return GoldenUpdate(argc - 2, argv + 2);
+  if (strcmp(argv[1], "live") == 0)
+    return Live(argc - 2, argv + 2);
+  if (strcmp(argv[1], "view") == 0)
+    return View(argc - 2, argv + 2);
+  if (strcmp(argv[1], "entity-bench") == 0)
+    return EntityBench(argc - 2, argv + 2);
+  if (strcmp(argv[1], "flow-bench") == 0)
+    return FlowBench(argc - 2, argv + 2);
+  if (strcmp(argv[1], "ray-bench") == 0)
+    return RayBench(argc - 2, argv + 2);
+  if (strcmp(argv[1], "pvs-bench") == 0)
+    return VisibilityBench(argc - 2, argv + 2);
+  if (strcmp(argv[1], "automap-check") == 0)
+    return AutomapCheck(argc - 2, argv + 2);
+  if (strcmp(argv[1], "light-bench") == 0)
+    return LightBench(argc - 2, argv + 2);
+  if (strcmp(argv[1], "melody-check") == 0)
+    return MelodyCheck(argc - 2, argv + 2);
+
+  PrintUsage();
+  return 1;
+}
+
+static void PrintUsage(void)
+{
+  printf("usage:\n");
+  printf("  preview <x> <y> <angle-degrees> <out.pgm> [width height]\n");
+  printf("                                              render one view of the map\n");
+  printf("  packet-check [frames]                       compare packet and scalar traversal\n");
+  printf("  kernel-check [words]                        check packed pixel kernels against per-byte arithmetic\n");
+  printf("  parallel-bench [width height frames threads] column-parallel scaling, 1 thread up to threads\n");
+  printf("  batch-bench [views threads out-prefix]      render many views at once, optionally saved as PGMs\n");
+  printf("  audio-bench [seconds out.wav]               mix all voices block by block, optionally saved as a WAV\n");
+  printf("  scheduler-sim [frames]                      run the task scheduler against a simulated clock\n");
+  printf("  pacing-sim [frames interval-us]             frame pacing and deltaTime modes against a simulated clock\n");
+  printf("  render-stats [out.csv]                      renderer counters and timings for every test view\n");
+  printf("  capture-decode <capture.bin> <out-prefix> [video.y4m]\n");
+  printf("                                              rebuild captured frames as PGM/PBM images and a video\n");
+  printf("  capture-check [frames capture.bin]          round-trip rendered frames through the capture stream\n");
+  printf("  golden-check <dir> [grey-tolerance flipped-pixels slowdown-percent]\n");
+  printf("                                              compare the golden poses with the reference images and timing\n");
+  printf("  golden-update <dir>                         rewrite the reference images and timing baseline\n");
+  printf("  live [seconds interval-us]                  tour the map in real time, publishing frames for view\n");
+  printf("  view [delay-ms grey]                        show the OLED frames of a running live in the terminal\n");
+  printf("  entity-bench [entities frames]              entity update and cell query cost, checked by brute force\n");
+  printf("  flow-bench [agents frames cells-per-frame]  flow field paths and chase cost against agent count\n");
+  printf("  ray-bench [queries targets]                 ray queries checked against rendered columns, single and batched\n");
+  printf("  pvs-bench [views toggles]                   potentially visible set size, build and rebuild cost, checked by rays\n");
+  printf("  automap-check [frames out.pbm]              seen wall faces against ray queries, incremental automap against a full redraw\n");
+  printf("  light-bench [lights changes faces-per-frame] face light bake and relight cost, checked against a full bake\n");
+  printf("  melody-check                                melody queue priorities, pre-emption and resume, tick by tick\n");
+}
+
+static double ElapsedMicroseconds(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void SetTestPose(Raycaster *raycaster, unsigned int frame, unsigned int framesPerPosition)
+{
+  const double *position = testPositions[(frame / framesPerPosition) % TEST_POSITION_COUNT];
+  const double angle = 2.0 * M_PI * (frame % framesPerPosition) / framesPerPosition;
+
+  raycaster->SetCameraPosition(Vector2(position[0], position[1]));
+  raycaster->SetCameraDirection(Vector2(cos(angle), sin(angle)));
+}
+
+static int Preview(int argc, char **argv)
+{
+  if (argc < 4)
+  {
+    PrintUsage();
+    return 1;
+  }
+
+  // larger previews render across every core
+  const bool large = (argc >= 6);
+  DisplayWrapper display(large ? atoi(argv[4]) : 128, large ? atoi(argv[5]) : 64);
+  if (display.GetWidth() > DEPTH_BUFFER_SIZE || display.GetHeight() % 8 != 0)
+  {
+    fprintf(stderr, "width must be at most %d and height a multiple of 8\n", DEPTH_BUFFER_SIZE);
+    return 1;
+  }
+  Raycaster raycaster(MAP_WIDTH, MAP_HEIGHT, *worldMap);
+
+  const double angle = atof(argv[2]) * M_PI / 180.0;
+  raycaster.SetCameraPosition(Vector2(atof(argv[0]), atof(argv[1])));
+  raycaster.SetCameraDirection(Vector2(cos(angle), sin(angle)));
+  if (large)
+  {
+    ParallelRenderer renderer(std::thread::hardware_concurrency());
+    renderer.Render(&raycaster, &display);
+  }
+  else
+    raycaster.RenderToDisplay(&display);
+
+  if (!ImageFile_WritePGM(argv[3], display.GetBuffer(), display.GetWidth(), display.GetHeight()))
+  {
+    fprintf(stderr, "could not write %s\n", argv[3]);
+    return 1;
+  }
+  return 0;
+}
+
+static int PacketCheck(int argc, char **argv)
+{
+  const unsigned int frames = (argc > 0) ? atoi(argv[0]) : 720;
+  const unsigned int framesPerPosition = 90;
+
+  DisplayWrapper scalarDisplay;
+  DisplayWrapper packetDisplay;
+  Raycaster raycaster(MAP_WIDTH, MAP_HEIGHT, *worldMap);
+  const int bufferSize = scalarDisplay.GetWidth() * scalarDisplay.GetHeight();
+
+  unsigned int mismatchedFrames = 0;
+  double scalarTime = 0.0;
+  double packetTime = 0.0;
+
+  for (unsigned int frame = 0; frame < frames; frame++)
+  {
+    SetTestPose(&raycaster, frame, framesPerPosition);
+
+    raycaster.SetPacketTraversal(false);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    raycaster.RenderToDisplay(&scalarDisplay);
+    scalarTime += ElapsedMicroseconds(start);
+
+    raycaster.SetPacketTraversal(true);
+    start = std::chrono::steady_clock::now();
+    raycaster.RenderToDisplay(&packetDisplay);
+    packetTime += ElapsedMicroseconds(start);
+
+    if (memcmp(scalarDisplay.GetBuffer(), packetDisplay.GetBuffer(), bufferSize) != 0)
+      mismatchedFrames++;
+  }
+
+#if defined(__AVX__)
+  const char *lanes = "AVX";
+#elif defined(__SSE2__)
+  const char *lanes = "SSE2";
+#else
+  const char *lanes = "scalar fallback";
+#endif
+
+  printf("packet traversal (%s): %u frames, %u mismatched\n", lanes, frames, mismatchedFrames);
+  printf("  scalar %.1f us/frame, packet %.1f us/frame\n", scalarTime / frames, packetTime / frames);
+
+  return (mismatchedFrames == 0) ? 0 : 1;
+}
+
+static int KernelCheck(int argc, char **argv)
+{
+  const unsigned int words = (argc > 0) ? atoi(argv[0]) : 1000000;
+  unsigned int failures = 0;
+
+  srand(1);
+  for (unsigned int i = 0; i < words; i++)
+  {
+    const uint32_t a = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+    const uint32_t b = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+    const uint32_t sum = PixelKernels_SaturatingAdd4(a, b);
+    const uint32_t difference = PixelKernels_SaturatingSubtract4(a, b);
+    const uint32_t lit = PixelKernels_Threshold4(a, b);
+
+    for (unsigned int lane = 0; lane < 4; lane++)
+    {
+      const int byteA = (a >> (lane * 8)) & 0xff;
+      const int byteB = (b >> (lane * 8)) & 0xff;
+
+      if (((sum >> (lane * 8)) & 0xff) != PixelKernels_ClampByte(byteA + byteB)
+          || ((difference >> (lane * 8)) & 0xff) != PixelKernels_ClampByte(byteA - byteB)
+          || ((lit >> (lane * 8)) & 0xff) != ((byteA >= byteB) ? 0xffu : 0u))
+      {
+        failures++;
+        break;
+      }
+    }
+  }
+
+  // page packing without dither against the per-pixel rule: lit when >= 128
+  DisplayWrapper display;
+  unsigned char *buffer = display.GetBuffer();
+  const unsigned int width = display.GetWidth();
+  const unsigned int height = display.GetHeight();
+  for (unsigned int i = 0; i < width * height; i++)
+    buffer[i] = rand() & 0xff;
+  display.Render(false);
+
+  unsigned int packingFailures = 0;
+  for (unsigned int y = 0; y < height; y++)
+  {
+    for (unsigned int x = 0; x < width; x++)
+    {
+      const bool lit = (display.GetPageBuffer()[(y >> 3) * width + x] >> (y & 7)) & 1;
+      if (lit != (buffer[y * width + x] >= 128))
+        packingFailures++;
+    }
+  }
+
+  printf("pixel kernels: %u words, %u failed; page packing: %u pixels wrong\n", words, failures, packingFailures);
+  return (failures == 0 && packingFailures == 0) ? 0 : 1;
+}
+
+// FNV-1a, enough to tell frames apart without keeping them all
+static uint64_t HashFrame(const unsigned char *pixels, unsigned int size)
+{
+  uint64_t hash = 14695981039346656037ull;
+  for (unsigned int i = 0; i < size; i++)
+    hash = (hash ^ pixels[i]) * 1099511628211ull;
+  return hash;
+}
+
+static int ParallelBench(int argc, char **argv)
+{
+  const unsigned int width = (argc > 0) ? atoi(argv[0]) : 1920;
+  const unsigned int height = (argc > 1) ? atoi(argv[1]) : 1080;
+  const unsigned int frames = (argc > 2) ? atoi(argv[2]) : 64;
+  unsigned int maxThreads = (argc > 3) ? atoi(argv[3]) : std::thread::hardware_concurrency();
+  const unsigned int framesPerPosition = 16;
+
+  if (maxThreads < 1)
+    maxThreads = 1;
+  if (width > DEPTH_BUFFER_SIZE || height % 8 != 0 || frames < 1)
+  {
+    fprintf(stderr, "width must be at most %d, height a multiple of 8\n", DEPTH_BUFFER_SIZE);
+    return 1;
+  }
+
+  DisplayWrapper display(width, height);
+  Raycaster raycaster(MAP_WIDTH, MAP_HEIGHT, *worldMap);
+  raycaster.SetFloorTexture(8);
+  raycaster.SetCeilingTexture(13);
+  raycaster.SetPacketTraversal(true);
+
+  // single-thread frames are the reference every other thread count must match
+  std::vector<uint64_t> referenceHashes(frames);
+  double singleThreadTime = 0.0;
+  unsigned int mismatchedFrames = 0;
+
+  printf("column-parallel render, %ux%u, %u frames, chunks of %d columns\n", width, height, frames, PARALLEL_CHUNK_WIDTH);
+  printf("threads  ms/frame  speedup  efficiency  steals/frame\n");
+
+  // 1, 2, 4, ... threads, finishing on maxThreads
+  unsigned int threads = 1;
+  while (true)
+  {
+    ParallelRenderer renderer(threads);
+    unsigned long steals = 0;
+    double time = 0.0;
+
+    for (unsigned int frame = 0; frame < frames; frame++)
+    {
+      SetTestPose(&raycaster, frame, framesPerPosition);
+
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      renderer.Render(&raycaster, &display);
+      time += ElapsedMicroseconds(start);
+      steals += renderer.GetStats().steals;
+
+      const uint64_t hash = HashFrame(display.GetBuffer(), width * height);
+      if (threads == 1)
+        referenceHashes[frame] = hash;
+      else if (hash != referenceHashes[frame])
+        mismatchedFrames++;
+    }
+
+    if (threads == 1)
+      singleThreadTime = time;
+
+    printf("%7u  %8.2f  %7.2f  %9.0f%%  %12.1f\n", threads, time / frames / 1000.0, singleThreadTime / time,
+      100.0 * singleThreadTime / time / threads, (double)steals / frames);
+
+    if (threads == maxThreads)
+      break;
+    threads = (threads * 2 < maxThreads) ? threads * 2 : maxThreads;
+  }
+
+  printf("%u frames differ from the single-thread render\n", mismatchedFrames);
+  return (mismatchedFrames == 0) ? 0 : 1;
+}
+
+static int BatchBench(int argc, char **argv)
+{
+  const unsigned int views = (argc > 0) ? atoi(argv[0]) : 2880;
+  const unsigned int threads = (argc > 1) ? atoi(argv[1]) : std::thread::hardware_concurrency();
+  const char *outPrefix = (argc > 2) ? argv[2] : nullptr;
+  const unsigned int framesPerPosition = 360;
+
+  if (views < 1)
+  {
+    PrintUsage();
+    return 1;
+  }
+
+  Raycaster prototype(MAP_WIDTH, MAP_HEIGHT, *worldMap);
+  prototype.SetFloorTexture(8);
+  prototype.SetCeilingTexture(13);
+  prototype.SetSegmentCoherence(true);
+
+  std::vector<CameraPose> poses(views);
+  std::vector<DisplayWrapper *> displays(views);
+  for (unsigned int view = 0; view < views; view++)
+  {
+    SetTestPose(&prototype, view, framesPerPosition);
+    poses[view].position = prototype.GetCameraPosition();
+    poses[view].direction = prototype.GetCameraDirection();
+    displays[view] = new DisplayWrapper();
+  }
+
+  BatchRenderer renderer(threads);
+  renderer.Render(prototype, &poses[0], &displays[0], views);
+  const BatchRenderStats stats = renderer.GetStats();
+
+  // every batch frame must match the same view rendered on its own
+  DisplayWrapper reference;
+  unsigned int mismatchedViews = 0;
+  for (unsigned int view = 0; view < views; view++)
+  {
+    prototype.SetCameraPosition(poses[view].position);
+    prototype.SetCameraDirection(poses[view].direction);
+    reference.Clear();
+    prototype.RenderToDisplay(&reference);
+    if (memcmp(reference.GetBuffer(), displays[view]->GetBuffer(), reference.GetWidth() * reference.GetHeight()) != 0)
+      mismatchedViews++;
+  }
+
+  printf("batch render: %u views of %ux%u on %u threads, %.3f s\n", views, displays[0]->GetWidth(), displays[0]->GetHeight(), stats.threads, stats.seconds);
+  printf("  %.0f frames/s, %.0f frames/s per core, %u views differ from single renders\n",
+    stats.frames / stats.seconds, stats.framesPerSecondPerCore, mismatchedViews);
+
+  int result = (mismatchedViews == 0) ? 0 : 1;
+  if (outPrefix)
+  {
+    char path[512];
+    for (unsigned int view = 0; view < views; view++)
+    {
+      snprintf(path, sizeof(path), "%s%04u.pgm", outPrefix, view);
+      if (!ImageFile_WritePGM(path, displays[view]->GetBuffer(), displays[view]->GetWidth(), displays[view]->GetHeight()))
+      {
+        fprintf(stderr, "could not write %s\n", path);
+        result = 1;
+        break;
+      }
+    }
+  }
+
+  for (unsigned int view = 0; view < views; view++)
+    delete displays[view];
+
+  return result;
+}
+
+// zero crossings going up over a stretch of mixer output, as a frequency
+static double MeasureFrequency(const int16_t *samples, unsigned int count)
+{
+  unsigned int crossings = 0;
+  for (unsigned int i = 1; i < count; i++)
+    if (samples[i - 1] < 0 && samples[i] >= 0)
+      crossings++;
+  return crossings * (double)AUDIO_SAMPLE_RATE / count;
+}
+
+static int AudioBench(int argc, char **argv)
+{
+  const double seconds = (argc > 0) ? atof(argv[0]) : 10.0;
+  const char *outPath = (argc > 1) ? argv[1] : nullptr;
+  const unsigned int blocks = (unsigned int)(seconds * AUDIO_SAMPLE_RATE / AUDIO_BLOCK_SAMPLES);
+
+  if (blocks < 1)
+  {
+    PrintUsage();
+    return 1;
+  }
+
+  // a lone sine must come out at its frequency and full scale, and silence must be silent
+  const unsigned int checkBlocks = AUDIO_SAMPLE_RATE / AUDIO_BLOCK_SAMPLES;
+  std::vector<int16_t> check(checkBlocks * AUDIO_BLOCK_SAMPLES);
+  AudioMixer_Play(0, Sine, 440, 255, 0);
+  for (unsigned int block = 0; block < checkBlocks; block++)
+    AudioMixer_RenderBlock(&check[block * AUDIO_BLOCK_SAMPLES]);
+  int peak = 0;
+  for (unsigned int i = 0; i < check.size(); i++)
+    peak = std::max(peak, abs((int)check[i]));
+  const double sineFrequency = MeasureFrequency(&check[0], check.size());
+
+  AudioMixer_Stop(0);
+  int16_t silence[AUDIO_BLOCK_SAMPLES];
+  AudioMixer_RenderBlock(silence);
+  bool silent = true;
+  for (unsigned int i = 0; i < AUDIO_BLOCK_SAMPLES; i++)
+    silent = silent && silence[i] == 0;
+
+  // music on two voices, percussion and an effect over the top, changed between blocks the
+  // way the game loop would
+  static const unsigned int arpeggio[] = { 220, 277, 330, 440, 330, 277 };
+  std::vector<int16_t> samples(blocks * AUDIO_BLOCK_SAMPLES);
+  std::vector<double> blockMicroseconds(blocks);
+  const unsigned int blocksPerStep = AUDIO_SAMPLE_RATE / AUDIO_BLOCK_SAMPLES / 8;
+  for (unsigned int block = 0; block < blocks; block++)
+  {
+    if (block % blocksPerStep == 0)
+    {
+      const unsigned int step = block / blocksPerStep;
+      AudioMixer_Play(0, Triangle, arpeggio[step % 6], 96, 0);
+      if (step % 4 == 0)
+        AudioMixer_Play(1, Square, arpeggio[(step / 4) % 6] / 2, 48, 250);
+      if (step % 2 == 1)
+        AudioMixer_Play(2, Noise, 8000, 64, 40);
+      if (step % 16 == 10)
+        AudioMixer_Play(3, Sawtooth, 880, 80, 120);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    AudioMixer_RenderBlock(&samples[block * AUDIO_BLOCK_SAMPLES]);
+    blockMicroseconds[block] = ElapsedMicroseconds(start);
+  }
+  for (unsigned int voice = 0; voice < AUDIO_VOICE_COUNT; voice++)
+    AudioMixer_Stop(voice);
+
+  double total = 0.0;
+  double slowest = 0.0;
+  for (unsigned int block = 0; block < blocks; block++)
+  {
+    total += blockMicroseconds[block];
+    slowest = std::max(slowest, blockMicroseconds[block]);
+  }
+  const double blockPeriod = AUDIO_BLOCK_SAMPLES * 1000000.0 / AUDIO_SAMPLE_RATE;
+
+  const bool sineGood = fabs(sineFrequency - 440.0) <= 2.0 && peak >= 32000;
+  printf("audio mixer: sine at %.1f Hz peak %d (%s), silence %s\n", sineFrequency, peak, sineGood ? "ok" : "WRONG", silent ? "ok" : "WRONG");
+  printf("  %u blocks of %u samples at %u Hz, %u voices\n", blocks, AUDIO_BLOCK_SAMPLES, AUDIO_SAMPLE_RATE, AUDIO_VOICE_COUNT);
+  printf("  %.2f us per block (slowest %.2f) of %.0f us, %.3f%% load\n", total / blocks, slowest, blockPeriod, 100.0 * total / blocks / blockPeriod);
+
+  int result = (sineGood && silent) ? 0 : 1;
+  if (outPath && !AudioFile_WriteWAV(outPath, &samples[0], samples.size(), AUDIO_SAMPLE_RATE))
+  {
+    fprintf(stderr, "could not write %s\n", outPath);
+    result = 1;
+  }
+
+  return result;
+}
+
+// simulated microseconds; tasks advance it by what they would cost on the device
+static uint32_t simulatedTime;
+static uint32_t simulatedDeadline;
+static unsigned int budgetViolations;
+
+static uint32_t SimulatedClock(void)
+{
+  return simulatedTime;
+}
+
+struct SimulatedWork
+{
+  uint32_t minimumCost;
+  uint32_t maximumCost;
+  uint32_t budget;     // background work checks it was only started with room for this
+  unsigned int chainLength; // one-shot work that defers itself this many more times
+};
+
+static void SimulatedTask(void *context)
+{
+  SimulatedWork *work = (SimulatedWork *)context;
+
+  if (work->budget > 0 && (int32_t)(simulatedDeadline - (simulatedTime + work->budget)) < 0)
+    budgetViolations++;
+
+  simulatedTime += work->minimumCost + rand() % (work->maximumCost - work->minimumCost + 1);
+
+  if (work->chainLength > 0)
+  {
+    work->chainLength--;
+    Scheduler_Defer("streaming", SimulatedTask, work, 0, work->budget, SCHEDULER_PRIORITY_BACKGROUND);
+  }
+}
+
+static int SchedulerSim(int argc, char **argv)
+{
+  const unsigned int frames = (argc > 0) ? atoi(argv[0]) : 3000;
+  const uint32_t frameMicroseconds = 33333;
+
+  // frame work sized like the device: rendering sometimes blows the frame on its own
+  SimulatedWork render = { 18000, 30000, 0, 0 };
+  SimulatedWork present = { 5500, 6500, 0, 0 };
+  SimulatedWork ai = { 2000, 2800, 3000, 0 };
+  SimulatedWork pathfinding = { 3000, 5000, 4000, 0 };
+  SimulatedWork streaming = { 1200, 1800, 2000, 200 };
+  SimulatedWork telemetry = { 600, 900, 1000, 0 };
+
+  srand(1);
+  simulatedTime = 0xfff00000u; // wraps during the run
+  budgetViolations = 0;
+  Scheduler_Init(SimulatedClock);
+  Scheduler_AddPeriodic("render", SimulatedTask, &render, 0, 25000, SCHEDULER_PRIORITY_FRAME);
+  Scheduler_AddPeriodic("present", SimulatedTask, &present, 0, 6000, SCHEDULER_PRIORITY_FRAME);
+  Scheduler_AddPeriodic("ai", SimulatedTask, &ai, 100000, ai.budget, SCHEDULER_PRIORITY_BACKGROUND);
+  Scheduler_AddPeriodic("pathfinding", SimulatedTask, &pathfinding, 0, pathfinding.budget, SCHEDULER_PRIORITY_BACKGROUND);
+  Scheduler_AddPeriodic("telemetry", SimulatedTask, &telemetry, 1000000, telemetry.budget, SCHEDULER_PRIORITY_BACKGROUND);
+  Scheduler_Defer("streaming", SimulatedTask, &streaming, 0, streaming.budget, SCHEDULER_PRIORITY_BACKGROUND);
+
+  uint64_t totalSlack = 0;
+  for (unsigned int frame = 0; frame < frames; frame++)
+  {
+    const uint32_t frameStart = simulatedTime;
+    simulatedDeadline = frameStart + frameMicroseconds;
+    totalSlack += Scheduler_RunFrame(frameMicroseconds);
+
+    // idle out the rest of the frame
+    if ((int32_t)(simulatedDeadline - simulatedTime) > 0)
+      simulatedTime = simulatedDeadline;
+  }
+
+  const SchedulerStats stats = Scheduler_GetStats();
+  printf("scheduler: %u frames of %u us, %u over deadline, %.0f us mean slack\n", stats.frames, frameMicroseconds,
+    stats.frameOverruns, (double)totalSlack / frames);
+  printf("  %-12s %8s %9s %9s %9s %9s\n", "task", "runs", "overruns", "deferred", "last us", "worst us");
+
+  TaskStats task;
+  unsigned int backgroundRuns = 0;
+  for (int id = 0; id < SCHEDULER_MAX_TASKS; id++)
+  {
+    if (!Scheduler_GetTaskStats(id, &task))
+      continue;
+    printf("  %-12s %8u %9u %9u %9u %9u\n", task.name, task.runs, task.overruns, task.deferrals, task.lastMicroseconds, task.worstMicroseconds);
+    if (id >= 2)
+      backgroundRuns += task.runs;
+  }
+  printf("  %u background tasks started without room for their budget\n", budgetViolations);
+
+  return (budgetViolations == 0 && backgroundRuns > 0) ? 0 : 1;
+}
+
+// every read costs a microsecond, as it would on the device, so spin waits finish
+static uint32_t PacingClock(void)
+{
+  return simulatedTime++;
+}
+
+static unsigned int simulatedSleeps;
+
+// WFI: asleep until the next 1 ms system tick
+static void SimulatedSleep(void)
+{
+  simulatedTime = (simulatedTime / 1000 + 1) * 1000;
+  simulatedSleeps++;
+}
+
+static int PacingSim(int argc, char **argv)
+{
+  const unsigned int frames = (argc > 0) ? atoi(argv[0]) : 3000;
+  const uint32_t interval = (argc > 1) ? atoi(argv[1]) : 33333;
+
+  struct PacingRun
+  {
+    const char *name;
+    uint32_t interval;
+    DeltaTimeMode mode;
+  };
+  const PacingRun runs[] =
+  {
+    { "unpaced, measured", 0, MeasuredDelta },
+    { "unpaced, smoothed", 0, SmoothedDelta },
+    { "paced, measured", interval, MeasuredDelta },
+    { "paced, smoothed", interval, SmoothedDelta },
+    { "paced, fixed", interval, FixedDelta }
+  };
+
+  printf("frame pacing: %u frames of 12-30 ms work, %u us interval\n", frames, interval);
+  printf("  %-18s %8s %8s %10s %10s %10s\n", "mode", "awake", "missed", "frame us", "deviation", "dt jitter");
+
+  bool fixedSteady = true;
+  for (unsigned int run = 0; run < sizeof(runs) / sizeof(runs[0]); run++)
+  {
+    srand(1);
+    simulatedTime = 0;
+    simulatedSleeps = 0;
+    FramePacer_Init(PacingClock, SimulatedSleep);
+    FramePacer_SetInterval(runs[run].interval);
+    FramePacer_SetDeltaTimeMode(runs[run].mode);
+
+    // spread of the time steps handed to the game, frame to frame
+    double previousDelta = 0.0;
+    double deltaChange = 0.0;
+    for (unsigned int frame = 0; frame < frames; frame++)
+    {
+      const double delta = FramePacer_StartFrame();
+      if (frame > 0)
+        deltaChange += fabs(delta - previousDelta);
+      previousDelta = delta;
+
+      // mostly comfortable frames with the odd heavy one
+      simulatedTime += (rand() % 8 == 0) ? 30000 + rand() % 8000 : 12000 + rand() % 14000;
+      FramePacer_FinishFrame();
+    }
+
+    const FramePacerStats stats = FramePacer_GetStats();
+    printf("  %-18s %7.1f%% %8u %10.0f %10.0f %9.2fms\n", runs[run].name, stats.utilisation * 100.0f, stats.missedFrames,
+      stats.meanFrameMicroseconds, stats.frameMicrosecondsDeviation, 1000.0 * deltaChange / (frames - 1));
+    if (runs[run].mode == FixedDelta && deltaChange != 0.0)
+      fixedSteady = false;
+  }
+
+  return fixedSteady ? 0 : 1;
+}
+
+static int RenderStatsSweep(int argc, char **argv)
+{
+#if RAYCASTER_STATS
+  const char *outPath = (argc > 0) ? argv[0] : nullptr;
+  const unsigned int framesPerPosition = 360;
+  const unsigned int frames = framesPerPosition * TEST_POSITION_COUNT;
+
+  FILE *csv = nullptr;
+  if (outPath)
+  {
+    csv = fopen(outPath, "w");
+    if (csv == nullptr)
+    {
+      fprintf(stderr, "could not write %s\n", outPath);
+      return 1;
+    }
+    fprintf(csv, "x,y,angle,microseconds,rays,dda_steps,clamped,half_rate,texels,pixels,max_column_steps,max_steps_column,max_column_wall_pixels\n");
+  }
+
+  DisplayWrapper display;
+  Raycaster raycaster(MAP_WIDTH, MAP_HEIGHT, *worldMap);
+  raycaster.SetFloorTexture(8);
+  raycaster.SetCeilingTexture(13);
+
+  printf("render stats: %u views per position, scalar walk\n", framesPerPosition);
+  printf("  %-13s %7s %9s %9s %8s %9s %17s\n", "position", "mean us", "worst us", "dda/view", "clamped", "half-rate", "longest walk");
+
+  unsigned int packetMismatches = 0;
+  for (unsigned int position = 0; position < TEST_POSITION_COUNT; position++)
+  {
+    double totalMicroseconds = 0.0;
+    double worstMicroseconds = 0.0;
+    unsigned long long ddaSteps = 0;
+    unsigned int clamped = 0;
+    unsigned int halfRate = 0;
+    unsigned int longestWalk = 0;
+    unsigned int longestWalkAngle = 0;
+
+    for (unsigned int angle = 0; angle < framesPerPosition; angle++)
+    {
+      SetTestPose(&raycaster, position * framesPerPosition + angle, framesPerPosition);
+
+      raycaster.SetPacketTraversal(false);
+      display.Clear();
+      const auto start = std::chrono::steady_clock::now();
+      raycaster.RenderToDisplay(&display);
+      const double microseconds = ElapsedMicroseconds(start);
+      const RenderStats stats = raycaster.GetRenderStats();
+
+      // the packet walk must count exactly the same work
+      raycaster.SetPacketTraversal(true);
+      raycaster.RenderToDisplay(&display);
+      if (memcmp(&stats, &raycaster.GetRenderStats(), sizeof(stats)) != 0)
+        packetMismatches++;
+
+      totalMicroseconds += microseconds;
+      worstMicroseconds = std::max(worstMicroseconds, microseconds);
+      ddaSteps += stats.ddaSteps;
+      clamped += stats.clampedRays;
+      halfRate += stats.halfRateColumns;
+      if (stats.maxColumnDdaSteps > longestWalk)
+      {
+        longestWalk = stats.maxColumnDdaSteps;
+        longestWalkAngle = angle;
+      }
+
+      if (csv)
+        fprintf(csv, "%.2f,%.2f,%u,%.2f,%u,%u,%u,%u,%u,%u,%u,%u,%u\n", testPositions[position][0], testPositions[position][1],
+          angle * 360 / framesPerPosition, microseconds, stats.raysCast, stats.ddaSteps, stats.clampedRays, stats.halfRateColumns,
+          stats.texelsSampled, stats.pixelsWritten, stats.maxColumnDdaSteps, stats.maxDdaStepsColumn, stats.maxColumnWallPixels);
+    }
+
+    char name[32];
+    snprintf(name, sizeof(name), "%.2f, %.2f", testPositions[position][0], testPositions[position][1]);
+    char walk[32];
+    snprintf(walk, sizeof(walk), "%u at %u deg", longestWalk, longestWalkAngle * 360 / framesPerPosition);
+    printf("  %-13s %7.1f %9.1f %9.0f %8u %9u %17s\n", name, totalMicroseconds / framesPerPosition, worstMicroseconds,
+      (double)ddaSteps / framesPerPosition, clamped, halfRate, walk);
+  }
+  printf("  %u of %u views count differently on the packet walk\n", packetMismatches, frames);
+
+  if (csv && fclose(csv) != 0)
+  {
+    fprintf(stderr, "could not write %s\n", outPath);
+    return 1;
+  }
+  return (packetMismatches == 0) ? 0 : 1;
+#else
+  fprintf(stderr, "built without RAYCASTER_STATS\n");
+  return 1;
+#endif
+}
+
+static int CaptureDecode(int argc, char **argv)
+{
+  if (argc < 2)
+  {
+    PrintUsage();
+    return 1;
+  }
+
+  FILE *file = fopen(argv[0], "rb");
+  if (file == nullptr)
+  {
+    fprintf(stderr, "could not read %s\n", argv[0]);
+    return 1;
+  }
+  std::vector<unsigned char> stream;
+  unsigned char chunk[4096];
+  size_t length;
+  while ((length = fread(chunk, 1, sizeof(chunk), file)) > 0)
+    stream.insert(stream.end(), chunk, chunk + length);
+  fclose(file);
+
+  std::vector<CapturedFrame> frames;
+  const CaptureDecodeStats stats = CaptureDecoder_Decode(stream, frames);
+
+  std::string indexPath = std::string(argv[1]) + "index.csv";
+  FILE *index = fopen(indexPath.c_str(), "w");
+  if (index == nullptr)
+  {
+    fprintf(stderr, "could not write %s\n", indexPath.c_str());
+    return 1;
+  }
+  fprintf(index, "frame,milliseconds,frame_microseconds,format,encoded_bytes,raw_bytes,checksum_ok\n");
+
+  // the video plays in real time: each frame is held until the next one was captured
+  const unsigned int videoFramesPerSecond = 30;
+  FILE *video = nullptr;
+  unsigned int videoFrames = 0;
+  unsigned int checksumFailures = 0;
+  unsigned long long encodedBytes = 0;
+  unsigned long long rawBytes = 0;
+
+  for (size_t f = 0; f < frames.size(); f++)
+  {
+    const CapturedFrame &frame = frames[f];
+    const std::vector<unsigned char> pixels = CaptureDecoder_ToGreyscale(frame);
+    const bool pages = (frame.format == CapturePages);
+
+    char path[1024];
+    snprintf(path, sizeof(path), "%s%05u.%s", argv[1], (unsigned int)frame.number, pages ? "pbm" : "pgm");
+    const bool written = pages ? ImageFile_WritePBM(path, &pixels[0], frame.width, frame.height)
+      : ImageFile_WritePGM(path, &pixels[0], frame.width, frame.height);
+    if (!written)
+    {
+      fprintf(stderr, "could not write %s\n", path);
+      return 1;
+    }
+
+    fprintf(index, "%u,%u,%u,%s,%u,%u,%d\n", (unsigned int)frame.number, (unsigned int)frame.milliseconds,
+      (unsigned int)frame.frameMicroseconds, pages ? "pages" : "greyscale", frame.encodedBytes, (unsigned int)frame.data.size(),
+      frame.checksumMatches ? 1 : 0);
+    if (!frame.checksumMatches)
+      checksumFailures++;
+    encodedBytes += frame.encodedBytes;
+    rawBytes += frame.data.size();
+
+    if (argc < 3)
+      continue;
+    if (video == nullptr)
+    {
+      video = ImageFile_OpenY4M(argv[2], frame.width, frame.height, videoFramesPerSecond);
+      if (video == nullptr)
+      {
+        fprintf(stderr, "could not write %s\n", argv[2]);
+        return 1;
+      }
+    }
+    if (frame.width * frame.height != pixels.size() || frame.width != frames[0].width || frame.height != frames[0].height)
+      continue;
+    unsigned int repeats = 1;
+    if (f + 1 < frames.size())
+    {
+      // a capture restarted mid-stream starts its clock again
+      const int32_t gap = (int32_t)(frames[f + 1].milliseconds - frame.milliseconds);
+      if (gap > 0)
+        repeats = std::max(1u, (unsigned int)(((uint64_t)gap * videoFramesPerSecond + 500) / 1000));
+    }
+    for (unsigned int repeat = 0; repeat < repeats; repeat++)
+      ImageFile_WriteY4MFrame(video, &pixels[0], frame.width, frame.height);
+    videoFrames += repeats;
+  }
+
+  const bool closed = (fclose(index) == 0) && (video == nullptr || ImageFile_CloseY4M(video));
+  if (!closed)
+  {
+    fprintf(stderr, "could not finish writing the output\n");
+    return 1;
+  }
+
+  printf("capture: %u frames from %u bytes, %u bytes skipped, %u incomplete, %u failed the checksum\n", (unsigned int)frames.size(),
+    (unsigned int)stream.size(), stats.skippedBytes, stats.incompleteFrames, checksumFailures);
+  if (rawBytes > 0)
+    printf("  %.1f%% of the raw frame size on the wire\n", 100.0 * encodedBytes / rawBytes);
+  if (video)
+    printf("  %u video frames at %u fps\n", videoFrames, videoFramesPerSecond);
+  return (checksumFailures == 0) ? 0 : 1;
+}
+
+// renders a walk through the test positions, streams it the way the capture task does (a random
+// amount of room each frame, log text in between) and checks every frame that went out comes back
+static int CaptureCheck(int argc, char **argv)
+{
+  const unsigned int frames = (argc > 0) ? atoi(argv[0]) : 240;
+  const char *outPath = (argc > 1) ? argv[1] : nullptr;
+  const unsigned int framesPerPosition = 120;
+  const char *logLine = "frames: 120, 0 over deadline\n";
+
+  DisplayWrapper display;
+  Raycaster raycaster(MAP_WIDTH, MAP_HEIGHT, *worldMap);
+  raycaster.SetFloorTexture(8);
+  raycaster.SetCeilingTexture(13);
+
+  printf("capture check: %u frames per format\n", frames);
+  printf("  %-10s %6s %8s %8s %10s %10s %10s\n", "format", "sent", "skipped", "failed", "bytes/frame", "of raw", "worst");
+
+  bool passed = true;
+  std::vector<unsigned char> capture;
+  const CaptureFormat formats[] = { CaptureGreyscale, CapturePages };
+  for (CaptureFormat format : formats)
+  {
+    srand(1);
+    std::vector<unsigned char> stream;
+    std::vector<std::vector<unsigned char>> sent;
+    std::vector<uint32_t> sentNumbers;
+    unsigned char packets[512];
+
+    FrameCapture_Start(format, 0);
+    for (unsigned int frame = 0; frame < frames; frame++)
+    {
+      SetTestPose(&raycaster, frame / 4, framesPerPosition);
+      display.Clear();
+      raycaster.RenderToDisplay(&display);
+      // now and then a frame of noise, which PackBits cannot shrink, so it goes out stored
+      if (frame % 16 == 15)
+      {
+        unsigned char *buffer = display.GetBuffer();
+        for (unsigned int i = 0; i < 128 * 64; i++)
+          buffer[i] = rand() & 0xff;
+      }
+
+      // as PresentTask does it: greyscale before dithering, pages after
+      if (format == CapturePages)
+        display.PreparePages(true);
+      if (FrameCapture_Snapshot(&display, frame * 33, 20000))
+      {
+        const unsigned char *raw = (format == CaptureGreyscale) ? display.GetBuffer() : display.GetPageBuffer();
+        sent.push_back(std::vector<unsigned char>(raw, raw + ((format == CaptureGreyscale) ? 128 * 64 : 128 * 64 / 8)));
+        sentNumbers.push_back(frame);
+      }
+      if (format == CaptureGreyscale)
+        display.PreparePages(true);
+      display.SendPages();
+
+      // roughly what a full-speed USB serial link drains in a frame, in uneven writes
+      unsigned int budget = 1000 + rand() % 3000;
+      while (budget > 0)
+      {
+        const unsigned int space = std::min(budget, (unsigned int)(1 + rand() % sizeof(packets)));
+        const unsigned int length = FrameCapture_Pump(packets, space);
+        if (length == 0)
+          break;
+        stream.insert(stream.end(), packets, packets + length);
+        budget -= length;
+      }
+      if (frame % 10 == 0)
+        stream.insert(stream.end(), logLine, logLine + strlen(logLine));
+    }
+    FrameCapture_Stop();
+    unsigned int length;
+    while ((length = FrameCapture_Pump(packets, sizeof(packets))) > 0)
+      stream.insert(stream.end(), packets, packets + length);
+
+    std::vector<CapturedFrame> decoded;
+    const CaptureDecodeStats stats = CaptureDecoder_Decode(stream, decoded);
+    unsigned int failed = stats.incompleteFrames + (unsigned int)(sent.size() - std::min(sent.size(), decoded.size()));
+    unsigned long long encodedBytes = 0;
+    unsigned int worstBytes = 0;
+    for (size_t f = 0; f < decoded.size() && f < sent.size(); f++)
+    {
+      if (!decoded[f].checksumMatches || decoded[f].number != sentNumbers[f] || decoded[f].data != sent[f])
+        failed++;
+      encodedBytes += decoded[f].encodedBytes;
+      worstBytes = std::max(worstBytes, decoded[f].encodedBytes);
+    }
+
+    const double bytesPerFrame = decoded.empty() ? 0.0 : (double)encodedBytes / decoded.size();
+    printf("  %-10s %6u %8u %8u %10.0f %9.1f%% %9.1f%%\n", (format == CaptureGreyscale) ? "greyscale" : "pages", (unsigned int)sent.size(),
+      frames - (unsigned int)sent.size(), failed, bytesPerFrame, sent.empty() ? 0.0 : 100.0 * bytesPerFrame / sent[0].size(),
+      sent.empty() ? 0.0 : 100.0 * worstBytes / sent[0].size());
+    passed = passed && failed == 0 && !sent.empty() && stats.skippedBytes == (frames + 9) / 10 * strlen(logLine);
+    capture.insert(capture.end(), stream.begin(), stream.end());
+  }
+
+  if (outPath)
+  {
+    FILE *file = fopen(outPath, "wb");
+    if (file == nullptr || fwrite(&capture[0], 1, capture.size(), file) != capture.size() || fclose(file) != 0)
+    {
+      fprintf(stderr, "could not write %s\n", outPath);
+      return 1;
+    }
+  }
+
+  return passed ? 0 : 1;
+}
+
+// Golden poses: the device frame (walls, textured floor and ceiling, sprites) at fixed binary
+// angles, so every build renders exactly the same views. Angles straight down an axis and at 45
+// degrees catch the side shading split, close walls catch texture column errors. Lit poses add
+// the torches' baked face light.
+struct GoldenPose
+{
+  double x;
+  double y;
+  BinaryAngle angle;
+  bool lit;
+};
+
+static const GoldenPose goldenPoses[] =
+{
+  { 17.5, 22.5, 0x0000, false },
+  { 17.5, 22.5, 0x2000, false },
+  { 17.5, 22.5, 0xc000, false },
+  { 17.5, 21.0, 0xb3a0, false },
+  {  3.5,  3.5, 0x4000, false },
+  {  3.5,  3.5, 0x6000, false },
+  { 10.2, 13.5, 0x1234, false },
+  { 10.2, 13.5, 0x8000, false },
+  { 11.5, 18.5, 0x5555, false },
+  { 17.9, 21.1, 0xe000, false },
+  { 19.0, 18.0, 0x9c40, false },
+  {  8.5,  2.5, 0x0fff, false },
+  { 14.05, 16.5, 0x4000, false },
+  { 14.05, 16.5, 0xa000, false },
+  { 20.5,  7.5, 0x7000, false },
+  { 20.5,  7.5, 0xf123, false },
+  { 17.5, 22.5, 0x0000, true },
+  { 10.2, 13.5, 0x1234, true },
+  { 19.5,  5.5, 0xc000, true },
+  {  6.5, 15.5, 0x4000, true }
+};
+#define GOLDEN_POSE_COUNT (sizeof(goldenPoses) / sizeof(goldenPoses[0]))
+
+// frame time per pose is the fastest of this many renders, which steadies it against scheduling noise
+#define GOLDEN_TIMING_RUNS 25
+#define GOLDEN_BASELINE_FILE "baseline.csv"
+
+struct GoldenFrame
+{
+  std::vector<unsigned char> greyscale;
+  std::vector<unsigned char> pages; // unpacked to 0 or 255 per pixel
+  double microseconds;
+};
+
+static void RenderGoldenPose(Raycaster *raycaster, SpriteRenderer *sprites, LightMap *lights, DisplayWrapper *display, const GoldenPose &pose, GoldenFrame *frame)
+{
+  const unsigned int width = display->GetWidth();
+  const unsigned int height = display->GetHeight();
+  raycaster->SetCameraPosition(Vector2(pose.x, pose.y));
+  raycaster->SetCameraAngle(pose.angle);
+  raycaster->SetLightMap(pose.lit ? lights : nullptr);
+
+  frame->microseconds = 0.0;
+  for (unsigned int run = 0; run < GOLDEN_TIMING_RUNS; run++)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    display->Clear();
+    raycaster->RenderToDisplay(display);
+    sprites->RenderToDisplay(raycaster, display);
+    if (run == 0)
+      frame->greyscale.assign(display->GetBuffer(), display->GetBuffer() + width * height);
+    // dithering works in place on the greyscale frame, so it is copied first
+    display->Render(true);
+    const double microseconds = ElapsedMicroseconds(start);
+    frame->microseconds = (run == 0) ? microseconds : std::min(frame->microseconds, microseconds);
+  }
+
+  const unsigned char *pages = display->GetPageBuffer();
+  frame->pages.resize(width * height);
+  for (unsigned int y = 0; y < height; y++)
+  {
+    for (unsigned int x = 0; x < width; x++)
+      frame->pages[y * width + x] = ((pages[(y >> 3) * width + x] >> (y & 7)) & 1) ? 255 : 0;
+  }
+}
+
+// the engine objects set up the way main.cpp sets them up, with only the fixed props as sprites and
+// main's torches baked into the light map; the light map is attached for lit poses only
+static void SetUpGoldenScene(Raycaster *raycaster, SpriteRenderer *sprites, LightMap *lights)
+{
+  raycaster->SetFloorTexture(8);
+  raycaster->SetCeilingTexture(13);
+  raycaster->SetSegmentCoherence(true);
+  sprites->AddSprite(Vector2(17.5, 19.5), 0);
+  sprites->AddSprite(Vector2(20.5, 19.5), 0);
+  sprites->AddSprite(Vector2(18.5, 16.5), 1);
+  sprites->AddSprite(Vector2(14.5, 17.5), 1);
+
+  // radius 4 and intensity 0.8, as in PlaceLights
+  lights->AddLight(Vector2(20.5, 21.5), 4.0f, 0.8f);
+  lights->AddLight(Vector2(6.5, 17.5), 4.0f, 0.8f);
+  lights->AddLight(Vector2(12.5, 13.5), 4.0f, 0.8f);
+  lights->AddLight(Vector2(8.5, 8.5), 4.0f, 0.8f);
+  lights->AddLight(Vector2(19.5, 3.5), 4.0f, 0.8f);
+  lights->Bake();
+}
+
+static std::string GoldenPath(const char *directory, unsigned int pose, const char *suffix)
+{
+  char name[32];
+  snprintf(name, sizeof(name), "/pose-%02u%s", pose, suffix);
+  return std::string(directory) + name;
+}
+
+static int GoldenCheck(int argc, char **argv)
+{
+  if (argc < 1)
+  {
+    PrintUsage();
+    return 1;
+  }
+  const char *directory = argv[0];
+  const unsigned int greyTolerance = (argc > 1) ? atoi(argv[1]) : 2;
+  const unsigned int flippedPixelTolerance = (argc > 2) ? atoi(argv[2]) : 0;
+  const double slowdownPercent = (argc > 3) ? atof(argv[3]) : 20.0;
+
+  const std::string baselinePath = std::string(directory) + "/" GOLDEN_BASELINE_FILE;
+  FILE *baselineFile = fopen(baselinePath.c_str(), "r");
+  double baseline[GOLDEN_POSE_COUNT] = {};
+  double baselineTotal = 0.0;
+  if (baselineFile == nullptr)
+  {
+    fprintf(stderr, "could not read %s, run golden-update first\n", baselinePath.c_str());
+    return 1;
+  }
+  fscanf(baselineFile, "%*[^\n]");
+  unsigned int pose;
+  double microseconds;
+  while (fscanf(baselineFile, " %u,%lf", &pose, &microseconds) == 2)
+  {
+    if (pose < GOLDEN_POSE_COUNT)
+    {
+      baseline[pose] = microseconds;
+      baselineTotal += microseconds;
+    }
+  }
+  fclose(baselineFile);
+
+  DisplayWrapper display;
+  Raycaster raycaster(MAP_WIDTH, MAP_HEIGHT, *worldMap);
+  SpriteRenderer sprites;
+  LightMap lights(&raycaster);
+  SetUpGoldenScene(&raycaster, &sprites, &lights);
+
+  printf("golden check: %u poses, grey tolerance %u, %u flipped pixels allowed, %.0f%% slowdown allowed\n",
+    (unsigned int)GOLDEN_POSE_COUNT, greyTolerance, flippedPixelTolerance, slowdownPercent);
+  printf("  %-5s %-8s %10s %8s %10s %8s %8s\n", "pose", "walk", "grey off", "max diff", "flipped", "us", "baseline");
+
+  unsigned int failures = 0;
+  double total = 0.0;
+  for (int packet = 0; packet <= 1; packet++)
+  {
+    // both walks must land on the same references
+    raycaster.SetPacketTraversal(packet != 0);
+    for (pose = 0; pose < GOLDEN_POSE_COUNT; pose++)
+    {
+      GoldenFrame frame;
+      RenderGoldenPose(&raycaster, &sprites, &lights, &display, goldenPoses[pose], &frame);
+
+      std::vector<unsigned char> greyReference;
+      std::vector<unsigned char> pagesReference;
+      unsigned int width;
+      unsigned int height;
+      const std::string greyPath = GoldenPath(directory, pose, ".pgm");
+      const std::string pagesPath = GoldenPath(directory, pose, ".pbm");
+      if (!ImageFile_ReadPGM(greyPath.c_str(), greyReference, &width, &height) || greyReference.size() != frame.greyscale.size()
+        || !ImageFile_ReadPBM(pagesPath.c_str(), pagesReference, &width, &height) || pagesReference.size() != frame.pages.size())
+      {
+        fprintf(stderr, "could not read the references for pose %u from %s\n", pose, directory);
+        return 1;
+      }
+
+      unsigned int greyOff = 0;
+      unsigned int maxDifference = 0;
+      for (size_t i = 0; i < frame.greyscale.size(); i++)
+      {
+        const unsigned int difference = abs((int)frame.greyscale[i] - (int)greyReference[i]);
+        maxDifference = std::max(maxDifference, difference);
+        greyOff += (difference > greyTolerance);
+      }
+      unsigned int flipped = 0;
+      for (size_t i = 0; i < frame.pages.size(); i++)
+        flipped += (frame.pages[i] != pagesReference[i]);
+
+      const bool failed = (greyOff > 0 || flipped > flippedPixelTolerance);
+      if (failed)
+      {
+        // written next to the references for a side-by-side look
+        failures++;
+        ImageFile_WritePGM(GoldenPath(directory, pose, "-actual.pgm").c_str(), &frame.greyscale[0], display.GetWidth(), display.GetHeight());
+        ImageFile_WritePBM(GoldenPath(directory, pose, "-actual.pbm").c_str(), &frame.pages[0], display.GetWidth(), display.GetHeight());
+      }
+      if (!packet)
+        total += frame.microseconds;
+
+      printf("  %-5u %-8s %10u %8u %10u %8.1f %8.1f%s\n", pose, packet ? "packet" : "scalar", greyOff, maxDifference, flipped,
+        frame.microseconds, baseline[pose], failed ? "  FAIL" : "");
+    }
+  }
+
+  // the scalar walk is the one timed against the baseline; per pose times are too noisy to judge alone
+  const double limit = baselineTotal * (1.0 + slowdownPercent / 100.0);
+  const bool slow = total > limit;
+  printf("  %u of %u images differ from the references\n", failures, (unsigned int)GOLDEN_POSE_COUNT * 2);
+  printf("  %.1f us for all poses against a %.1f us baseline (%+.1f%%)%s\n", total, baselineTotal,
+    100.0 * (total - baselineTotal) / baselineTotal, slow ? ", too slow" : "");
+
+  return (failures == 0 && !slow) ? 0 : 1;
+}
+
+static int GoldenUpdate(int argc, char **argv)
+{
+  if (argc < 1)
+  {
+    PrintUsage();
+    return 1;
+  }
+  const char *directory = argv[0];
+
+  const std::string baselinePath = std::string(directory) + "/" GOLDEN_BASELINE_FILE;
+  FILE *baselineFile = fopen(baselinePath.c_str(), "w");
+  if (baselineFile == nullptr)
+  {
+    fprintf(stderr, "could not write %s\n", baselinePath.c_str());
+    return 1;
+  }
+  fprintf(baselineFile, "pose,microseconds\n");
+
+  DisplayWrapper display;
+  Raycaster raycaster(MAP_WIDTH, MAP_HEIGHT, *worldMap);
+  SpriteRenderer sprites;
+  LightMap lights(&raycaster);
+  SetUpGoldenScene(&raycaster, &sprites, &lights);
+
+  double total = 0.0;
+  for (unsigned int pose = 0; pose < GOLDEN_POSE_COUNT; pose++)
+  {
+    GoldenFrame frame;
+    RenderGoldenPose(&raycaster, &sprites, &lights, &display, goldenPoses[pose], &frame);
+    if (!ImageFile_WritePGM(GoldenPath(directory, pose, ".pgm").c_str(), &frame.greyscale[0], display.GetWidth(), display.GetHeight())
+      || !ImageFile_WritePBM(GoldenPath(directory, pose, ".pbm").c_str(), &frame.pages[0], display.GetWidth(), display.GetHeight()))
+    {
+      fprintf(stderr, "could not write the references for pose %u to %s\n", pose, directory);
+      fclose(baselineFile);
+      return 1;
+    }
+    fprintf(baselineFile, "%u,%.1f\n", pose, frame.microseconds);
+    total += frame.microseconds;
+  }
+
+  if (fclose(baselineFile) != 0)
+  {
+    fprintf(stderr, "could not write %s\n", baselinePath.c_str());
+    return 1;
+  }
+  printf("golden update: %u poses written to %s, %.1f us baseline\n", (unsigned int)GOLDEN_POSE_COUNT, directory, total);
+  return 0;
+}
+
+static std::chrono::steady_clock::time_point hostClockStart = std::chrono::steady_clock::now();
+
+static uint32_t HostMicros(void)
+{
+  return (uint32_t)ElapsedMicroseconds(hostClockStart);
+}
+
+static void HostSleep(void)
+{
+  std::this_thread::sleep_for(std::chrono::microseconds(500));
+}
+
+// The device frame loop on the host: a camera tour of the test positions at the device frame rate,
+// each frame rendered straight into the shared frame ring for any number of view processes
+static int Live(int argc, char **argv)
+{
+  const double seconds = (argc > 0) ? atof(argv[0]) : 60.0;
+  const uint32_t interval = (argc > 1) ? atoi(argv[1]) : 33333;
+  const unsigned int framesPerPosition = 360;
+
+  SharedFrameRing ring;
+  if (!ring.Create(SHARED_FRAME_RING_NAME, 128, 64, SHARED_FRAME_RING_SLOTS))
+  {
+    fprintf(stderr, "could not create shared memory %s\n", SHARED_FRAME_RING_NAME);
+    return 1;
+  }
+
+  DisplayWrapper display(&ring);
+  Raycaster raycaster(MAP_WIDTH, MAP_HEIGHT, *worldMap);
+  SpriteRenderer sprites;
+  LightMap lights(&raycaster);
+  SetUpGoldenScene(&raycaster, &sprites, &lights);
+  raycaster.SetLightMap(&lights);
+
+  FramePacer_Init(HostMicros, HostSleep);
+  FramePacer_SetInterval(interval);
+  printf("live: publishing to %s, run \"view\" in another terminal\n", SHARED_FRAME_RING_NAME);
+
+  const auto start = std::chrono::steady_clock::now();
+  double worstFrame = 0.0;
+  for (unsigned int frame = 0; ElapsedMicroseconds(start) < seconds * 1e6; frame++)
+  {
+    FramePacer_StartFrame();
+    const auto frameStart = std::chrono::steady_clock::now();
+    SetTestPose(&raycaster, frame, framesPerPosition);
+    display.Clear();
+    raycaster.RenderToDisplay(&display);
+    sprites.RenderToDisplay(&raycaster, &display);
+    display.Render(true);
+    worstFrame = std::max(worstFrame, ElapsedMicroseconds(frameStart));
+    FramePacer_FinishFrame();
+
+    if (frame % 300 == 299)
+    {
+      const SharedFrameStats stats = ring.GetStats();
+      printf("  %llu frames published, viewer at %llu, %llu dropped\n", (unsigned long long)stats.published,
+        (unsigned long long)stats.shown, (unsigned long long)stats.dropped);
+    }
+  }
+
+  const SharedFrameStats stats = ring.GetStats();
+  const FramePacerStats pacing = FramePacer_GetStats();
+  printf("  %llu frames published, %u missed their interval, slowest render %.0f us\n", (unsigned long long)stats.published,
+    pacing.missedFrames, worstFrame);
+  printf("  viewers showed up to frame %llu and dropped %llu between them\n", (unsigned long long)stats.shown, (unsigned long long)stats.dropped);
+  return 0;
+}
+
+// Two pixels per character cell with the upper half block: the foreground is the top pixel and
+// the background the bottom one. Colours are only sent when they change along a row.
+static int View(int argc, char **argv)
+{
+  const unsigned int delayMilliseconds = (argc > 0) ? atoi(argv[0]) : 0;
+  const bool showGreyscale = (argc > 1 && strcmp(argv[1], "grey") == 0);
+
+  SharedFrameRing ring;
+  if (!ring.Open(SHARED_FRAME_RING_NAME))
+  {
+    fprintf(stderr, "nothing is publishing to %s, start live first\n", SHARED_FRAME_RING_NAME);
+    return 1;
+  }
+
+  const unsigned int width = ring.GetWidth();
+  const unsigned int height = ring.GetHeight();
+  std::vector<unsigned char> greyscale(width * height);
+  std::vector<unsigned char> pages(width * height / 8);
+  std::vector<unsigned char> pixels(width * height);
+  std::string screen;
+  uint64_t sequence = 0;
+  uint64_t previousSequence = 0;
+  unsigned long long dropped = 0;
+  unsigned int framesShown = 0;
+  const auto start = std::chrono::steady_clock::now();
+
+  printf("\x1b[2J");
+  while (true)
+  {
+    if (!ring.ReadFrame(&greyscale[0], &pages[0], &sequence))
+    {
+      if (!ring.IsProducerActive())
+        break;
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      continue;
+    }
+    if (framesShown > 0)
+      dropped += sequence - previousSequence - 1;
+    previousSequence = sequence;
+
+    for (unsigned int y = 0; y < height; y++)
+    {
+      for (unsigned int x = 0; x < width; x++)
+        pixels[y * width + x] = showGreyscale ? greyscale[y * width + x] : (((pages[(y >> 3) * width + x] >> (y & 7)) & 1) ? 255 : 0);
+    }
+
+    screen.assign("\x1b[H");
+    char code[48];
+    for (unsigned int y = 0; y + 1 < height; y += 2)
+    {
+      int top = -1;
+      int bottom = -1;
+      for (unsigned int x = 0; x < width; x++)
+      {
+        const int upper = pixels[y * width + x];
+        const int lower = pixels[(y + 1) * width + x];
+        if (upper != top || lower != bottom)
+        {
+          snprintf(code, sizeof(code), "\x1b[38;2;%d;%d;%dm\x1b[48;2;%d;%d;%dm", upper, upper, upper, lower, lower, lower);
+          screen += code;
+          top = upper;
+          bottom = lower;
+        }
+        screen += "\xe2\x96\x80";
+      }
+      screen += "\x1b[0m\n";
+    }
+
+    snprintf(code, sizeof(code), "frame %llu, %llu dropped\x1b[K\n", (unsigned long long)sequence, dropped);
+    screen += code;
+    fwrite(screen.data(), 1, screen.size(), stdout);
+    fflush(stdout);
+    framesShown++;
+
+    if (delayMilliseconds > 0)
+      std::this_thread::sleep_for(std::chrono::milliseconds(delayMilliseconds));
+  }
+
+  printf("view: %u frames shown in %.1f s, %llu dropped, %llu published\n", framesShown, ElapsedMicroseconds(start) / 1e6,
+    dropped, (unsigned long long)ring.GetStats().published);
+  return 0;
+}
+
+static float RandomUnit(void)
+{
+  return rand() / (float)RAND_MAX;
+}
+
+static EntityHandle SpawnWanderer(EntityStore *store)
+{
+  while (true)
+  {
+    const Vector2 position(rand() % MAP_WIDTH + 0.5, rand() % MAP_HEIGHT + 0.5);
+    if (store->IsWall(position.x, position.y))
+      continue;
+
+    const double angle = 2.0 * M_PI * RandomUnit();
+    return store->Add(position, Vector2(cos(angle), sin(angle)), rand() % 2, EntityMoving | EntitySolid | EntityVisible);
+  }
+}
+
+// Wandering entities on the shipped map with a little churn every frame (1% removed and respawned),
+// timing Update and radius queries and checking every query against a scan of all entities
+static int EntityBench(int argc, char **argv)
+{
+  const unsigned int entityCount = (argc > 0) ? atoi(argv[0]) : 1000;
+  const unsigned int frames = (argc > 1) ? atoi(argv[1]) : 1000;
+  const unsigned int queriesPerFrame = 64;
+  const float queryRadius = 1.5f;
+  const float deltaTime = 1.0f / 30.0f;
+  if (entityCount > ENTITY_MAX_COUNT)
+  {
+    fprintf(stderr, "at most %d entities, raise ENTITY_MAX_COUNT\n", ENTITY_MAX_COUNT);
+    return 1;
+  }
+
+  srand(1);
+  std::unique_ptr<EntityStore> store(new EntityStore(MAP_WIDTH, MAP_HEIGHT, *worldMap));
+  for (unsigned int i = 0; i < entityCount; i++)
+    SpawnWanderer(store.get());
+
+  double updateMicroseconds = 0.0;
+  double queryMicroseconds = 0.0;
+  unsigned long long results = 0;
+  unsigned int mismatches = 0;
+  unsigned int inWalls = 0;
+  std::vector<EntityHandle> found(ENTITY_MAX_COUNT);
+
+  for (unsigned int frame = 0; frame < frames; frame++)
+  {
+    for (unsigned int churn = 0; churn < entityCount / 100; churn++)
+    {
+      store->Remove(store->handles[rand() % store->GetCount()]);
+      SpawnWanderer(store.get());
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    store->Update(deltaTime);
+    updateMicroseconds += ElapsedMicroseconds(start);
+
+    for (unsigned int query = 0; query < queriesPerFrame; query++)
+    {
+      const Vector2 centre(MAP_WIDTH * RandomUnit(), MAP_HEIGHT * RandomUnit());
+      start = std::chrono::steady_clock::now();
+      const unsigned int count = store->QueryRadius(centre, queryRadius, &found[0], found.size());
+      queryMicroseconds += ElapsedMicroseconds(start);
+      results += count;
+
+      unsigned int expected = 0;
+      for (unsigned int i = 0; i < store->GetCount(); i++)
+      {
+        const float dx = store->positionX[i] - (float)centre.x;
+        const float dy = store->positionY[i] - (float)centre.y;
+        expected += (dx * dx + dy * dy <= queryRadius * queryRadius);
+      }
+      if (count != expected)
+        mismatches++;
+    }
+  }
+
+  for (unsigned int i = 0; i < store->GetCount(); i++)
+    inWalls += store->IsWall(store->positionX[i], store->positionY[i]);
+
+  const unsigned int queries = frames * queriesPerFrame;
+  printf("entity bench: %u entities, %u frames, 1%% respawned per frame\n", entityCount, frames);
+  printf("  update %.2f us per frame, %.2f us per 1000 entities\n", updateMicroseconds / frames,
+    updateMicroseconds / frames * 1000.0 / entityCount);
+  printf("  radius %.1f query %.3f us, %.1f entities found on average\n", queryRadius, queryMicroseconds / queries, (double)results / queries);
+  printf("  %u of %u queries differ from a full scan, %u entities inside walls\n", mismatches, queries, inWalls);
+  return (mismatches == 0 && inWalls == 0) ? 0 : 1;
+}
+
+// shortest step counts from the goal over open cells, -1 where it cannot be reached
+static std::vector<int> ReferenceDistances(EntityStore *map, int goalX, int goalY)
+{
+  std::vector<int> distance(MAP_WIDTH * MAP_HEIGHT, -1);
+  std::vector<int> queue(1, goalY * MAP_WIDTH + goalX);
+  distance[queue[0]] = 0;
+  for (size_t head = 0; head < queue.size(); head++)
+  {
+    const int x = queue[head] % MAP_WIDTH;
+    const int y = queue[head] / MAP_WIDTH;
+    const int neighbours[4][2] = { { x + 1, y }, { x - 1, y }, { x, y + 1 }, { x, y - 1 } };
+    for (const auto &neighbour : neighbours)
+    {
+      if (map->IsWall(neighbour[0] + 0.5f, neighbour[1] + 0.5f))
+        continue;
+      const int cell = neighbour[1] * MAP_WIDTH + neighbour[0];
+      if (distance[cell] < 0)
+      {
+        distance[cell] = distance[queue[head]] + 1;
+        queue.push_back(cell);
+      }
+    }
+  }
+  return distance;
+}
+
+// cells from which following the field does not take the shortest path to the goal
+static unsigned int CountWrongCells(EntityStore *map, FlowField *field, int goalX, int goalY)
+{
+  unsigned int wrongCells = 0;
+  const std::vector<int> distance = ReferenceDistances(map, goalX, goalY);
+  for (int cell = 0; cell < MAP_WIDTH * MAP_HEIGHT; cell++)
+  {
+    if (distance[cell] < 0)
+      continue;
+    int x = cell % MAP_WIDTH;
+    int y = cell / MAP_WIDTH;
+    int steps = 0;
+    Vector2 next;
+    while (steps <= MAP_WIDTH * MAP_HEIGHT && field->GetNextCellCentre(Vector2(x + 0.5, y + 0.5), &next))
+    {
+      x = (int)next.x;
+      y = (int)next.y;
+      steps++;
+    }
+    if (steps != distance[cell] || x != goalX || y != goalY)
+      wrongCells++;
+  }
+  return wrongCells;
+}
+
+// Every open cell as the goal in turn: following the field from each reachable cell must take the
+// shortest number of steps, and so must it after searches abandoned part way. Then agents chase a
+// wandering player, with the field and the steering timed separately for growing agent counts.
+static int FlowBench(int argc, char **argv)
+{
+  const unsigned int maxAgents = (argc > 0) ? atoi(argv[0]) : 1000;
+  const unsigned int frames = (argc > 1) ? atoi(argv[1]) : 900;
+  const unsigned int cellsPerFrame = (argc > 2) ? atoi(argv[2]) : FLOW_FIELD_CELLS_PER_FRAME;
+  const float agentSpeed = 1.5f;
+  const float deltaTime = 1.0f / 30.0f;
+  if (maxAgents > ENTITY_MAX_COUNT)
+  {
+    fprintf(stderr, "at most %d agents, raise ENTITY_MAX_COUNT\n", ENTITY_MAX_COUNT);
+    return 1;
+  }
+
+  std::unique_ptr<EntityStore> store(new EntityStore(MAP_WIDTH, MAP_HEIGHT, *worldMap));
+  std::unique_ptr<FlowField> field(new FlowField(MAP_WIDTH, MAP_HEIGHT, *worldMap));
+
+  unsigned int goals = 0;
+  unsigned int wrongCells = 0;
+  unsigned int slowestSettle = 0;
+  for (int goalY = 0; goalY < MAP_HEIGHT; goalY++)
+  {
+    for (int goalX = 0; goalX < MAP_WIDTH; goalX++)
+    {
+      if (store->IsWall(goalX + 0.5f, goalY + 0.5f))
+        continue;
+
+      field->SetGoal(Vector2(goalX + 0.5, goalY + 0.5));
+      unsigned int settleFrames = 0;
+      while (!field->IsSettled())
+      {
+        field->Update(cellsPerFrame);
+        settleFrames++;
+      }
+      slowestSettle = std::max(slowestSettle, settleFrames);
+      goals++;
+      wrongCells += CountWrongCells(store.get(), field.get(), goalX, goalY);
+    }
+  }
+
+  // the player moving on before a search finishes: a few searches abandoned after a handful of
+  // cells each, then one run to completion, enough times to wrap the search generations
+  srand(1);
+  const unsigned int restartRuns = 200;
+  unsigned int restartWrongCells = 0;
+  for (unsigned int run = 0; run < restartRuns; run++)
+  {
+    const unsigned int abandoned = 1 + rand() % 4;
+    for (unsigned int search = 0; search <= abandoned; search++)
+    {
+      int goalX;
+      int goalY;
+      do
+      {
+        goalX = rand() % MAP_WIDTH;
+        goalY = rand() % MAP_HEIGHT;
+      } while (store->IsWall(goalX + 0.5f, goalY + 0.5f));
+
+      field->SetGoal(Vector2(goalX + 0.5, goalY + 0.5));
+      if (search < abandoned)
+      {
+        field->Update(1 + rand() % 40);
+        continue;
+      }
+      while (!field->IsSettled())
+        field->Update(cellsPerFrame);
+      restartWrongCells += CountWrongCells(store.get(), field.get(), goalX, goalY);
+    }
+  }
+
+  printf("flow bench: %u cells per frame\n", cellsPerFrame);
+  printf("  %u goals, %u cells off the shortest path, slowest search settled in %u frames\n", goals, wrongCells, slowestSettle);
+  printf("  %u searches after abandoned ones, %u cells off the shortest path\n", restartRuns, restartWrongCells);
+  printf("  %8s %14s %14s %12s %10s\n", "agents", "field us/frame", "steer us/frame", "steer ns/agent", "caught up");
+
+  bool caughtUp = true;
+  for (unsigned int agents = 10; agents <= maxAgents; agents *= 10)
+  {
+    srand(1);
+    store->Clear();
+    for (unsigned int i = 0; i < agents; i++)
+    {
+      while (true)
+      {
+        const Vector2 position(rand() % MAP_WIDTH + 0.5, rand() % MAP_HEIGHT + 0.5);
+        if (store->IsWall(position.x, position.y))
+          continue;
+        store->Add(position, Vector2(), 1, EntityMoving | EntitySolid | EntityChasing);
+        break;
+      }
+    }
+
+    // the player wanders a cell at a time for two thirds of the run, then waits to be caught
+    Vector2 player(17.5, 22.5);
+    double fieldMicroseconds = 0.0;
+    double steerMicroseconds = 0.0;
+    for (unsigned int frame = 0; frame < frames; frame++)
+    {
+      if (frame < frames * 2 / 3 && frame % 15 == 0)
+      {
+        const int direction = rand() % 4;
+        const Vector2 next(player.x + (direction == 0) - (direction == 1), player.y + (direction == 2) - (direction == 3));
+        if (!store->IsWall(next.x, next.y))
+          player = next;
+      }
+
+      auto start = std::chrono::steady_clock::now();
+      field->SetGoal(player);
+      field->Update(cellsPerFrame);
+      fieldMicroseconds += ElapsedMicroseconds(start);
+
+      start = std::chrono::steady_clock::now();
+      for (unsigned int i = 0; i < store->GetCount(); i++)
+      {
+        const Vector2 position(store->positionX[i], store->positionY[i]);
+        Vector2 target;
+        if (!field->GetNextCellCentre(position, &target))
+          target = player;
+        Vector2 heading(target.x - position.x, target.y - position.y);
+        const double distance = heading.Length();
+        heading.Scale((distance > 0.05) ? agentSpeed / distance : 0.0);
+        store->velocityX[i] = heading.x;
+        store->velocityY[i] = heading.y;
+      }
+      steerMicroseconds += ElapsedMicroseconds(start);
+      store->Update(deltaTime);
+    }
+
+    EntityHandle near[ENTITY_MAX_COUNT];
+    const unsigned int caught = store->QueryRadius(player, 1.0f, near, ENTITY_MAX_COUNT);
+    caughtUp = caughtUp && caught == agents;
+    printf("  %8u %14.2f %14.2f %12.1f %9u%%\n", agents, fieldMicroseconds / frames, steerMicroseconds / frames,
+      steerMicroseconds * 1000.0 / frames / agents, caught * 100 / agents);
+  }
+
+  return (wrongCells == 0 && restartWrongCells == 0 && caughtUp) ? 0 : 1;
+}
+
+// anywhere in an open cell of the shipped map
+static Vector2 RandomOpenPosition(void)
+{
+  while (true)
+  {
+    const Vector2 position(MAP_WIDTH * RandomUnit(), MAP_HEIGHT * RandomUnit());
+    if (worldMap[(int)position.y][MAP_WIDTH - 1 - (int)position.x] == 0)
+      return position;
+  }
+}
+
+static bool SameHit(const RayHit &a, const RayHit &b)
+{
+  if (a.hit != b.hit || a.steps != b.steps)
+    return false;
+  return !a.hit || (a.cellX == b.cellX && a.cellY == b.cellY && a.side == b.side && a.wall == b.wall &&
+    a.distance == b.distance && a.textureU == b.textureU);
+}
+
+// Three checks and a timing run for the ray queries: every rendered column of the test views cast
+// again as a query must reach the wall the renderer drew at the same distance; random segments are
+// sampled finely, and no sample may lie in a wall before the query's hit; and the batched calls
+// must answer exactly as the single ones do
+static int RayBench(int argc, char **argv)
+{
+  const unsigned int queryCount = (argc > 0) ? atoi(argv[0]) : 100000;
+  const unsigned int targetCount = (argc > 1) ? atoi(argv[1]) : 1000;
+  const unsigned int framesPerPosition = 64;
+  const double sampleStep = 0.001;
+
+  std::unique_ptr<DisplayWrapper> display(new DisplayWrapper());
+  std::unique_ptr<Raycaster> raycaster(new Raycaster(MAP_WIDTH, MAP_HEIGHT, *worldMap));
+  const unsigned int width = display->GetWidth();
+
+  unsigned int columns = 0;
+  unsigned int columnMismatches = 0;
+  unsigned int cornerTies = 0;
+  double worstColumnError = 0.0;
+  for (unsigned int frame = 0; frame < TEST_POSITION_COUNT * framesPerPosition; frame++)
+  {
+    SetTestPose(raycaster.get(), frame, framesPerPosition);
+    display->Clear();
+    raycaster->RenderToDisplay(display.get());
+    const float *depth = raycaster->GetDepthBuffer();
+
+    const Vector2 camera = raycaster->GetCameraPosition();
+    const Vector2 direction = raycaster->GetCameraDirection();
+    const Vector2 right = raycaster->GetClipPlaneRightVector();
+    const double clip = raycaster->GetClipPlaneDistance();
+    for (unsigned int x = 0; x < width; x++)
+    {
+      const double cameraX = 2.0 * x / double(width) - 1;
+      Vector2 ray(right.x * cameraX + direction.x * clip, right.y * cameraX + direction.y * clip);
+
+      // the depth buffer is projected onto the camera direction, the query measures along the ray
+      RayHit hit;
+      const double expected = depth[x] * ray.Length();
+      const bool found = raycaster->CastRay(camera, ray, MAP_WIDTH + MAP_HEIGHT, &hit);
+      const double error = found ? fabs(hit.distance - expected) / expected : 1.0;
+      columns++;
+      if (error <= 1e-4)
+        continue;
+
+      // a ray through the exact corner of a cell may pass either side of it: float and double
+      // round the tie differently
+      const double cornerX = camera.x + hit.distance * ray.x / ray.Length();
+      const double cornerY = camera.y + hit.distance * ray.y / ray.Length();
+      if (found && fabs(cornerX - floor(cornerX + 0.5)) < 1e-4 && fabs(cornerY - floor(cornerY + 0.5)) < 1e-4)
+      {
+        cornerTies++;
+        continue;
+      }
+      worstColumnError = std::max(worstColumnError, error);
+      columnMismatches++;
+    }
+  }
+
+  srand(1);
+  std::vector<RayQuery> queries(queryCount);
+  for (unsigned int i = 0; i < queryCount; i++)
+  {
+    // runs of eight queries share an origin, as a spread of shots would
+    queries[i].origin = (i % 8 == 0) ? RandomOpenPosition() : queries[i - 1].origin;
+    const double angle = 2.0 * M_PI * RandomUnit();
+    queries[i].direction = Vector2(cos(angle), sin(angle));
+    queries[i].maxDistance = 16.0f * RandomUnit();
+  }
+
+  unsigned int seenThroughWalls = 0;
+  unsigned int grazes = 0;
+  for (unsigned int i = 0; i < queryCount; i++)
+  {
+    const RayQuery &query = queries[i];
+    RayHit hit;
+    raycaster->CastRay(query.origin, query.direction, query.maxDistance, &hit);
+
+    // samples within a hair of a grid line could fall either side of it, so they are skipped
+    double firstWall = -1.0;
+    for (double t = 0.0; t <= query.maxDistance; t += sampleStep)
+    {
+      const double x = query.origin.x + t * query.direction.x;
+      const double y = query.origin.y + t * query.direction.y;
+      if (fabs(x - floor(x + 0.5)) < 1e-5 || fabs(y - floor(y + 0.5)) < 1e-5)
+        continue;
+      const int column = MAP_WIDTH - 1 - (int)floor(x);
+      const int row = (int)floor(y);
+      if (column < 0 || column >= MAP_WIDTH || row < 0 || row >= MAP_HEIGHT || worldMap[row][column] != 0)
+      {
+        firstWall = t;
+        break;
+      }
+    }
+
+    if (firstWall >= 0.0 && (!hit.hit || hit.distance > firstWall + 1e-4))
+      seenThroughWalls++;
+    // a hit the samples stepped over clips a corner by less than a sample step
+    if (firstWall < 0.0 && hit.hit)
+      grazes++;
+  }
+
+  // the fastest of a few alternating runs of each, so neither gets the warm caches
+  std::vector<RayHit> single(queryCount);
+  std::vector<RayHit> batched(queryCount);
+  double singleMicroseconds = 1e30;
+  double batchedMicroseconds = 1e30;
+  unsigned int singleHits = 0;
+  unsigned int batchedHits = 0;
+  for (unsigned int run = 0; run < 5; run++)
+  {
+    auto start = std::chrono::steady_clock::now();
+    singleHits = 0;
+    for (unsigned int i = 0; i < queryCount; i++)
+      singleHits += raycaster->CastRay(queries[i].origin, queries[i].direction, queries[i].maxDistance, &single[i]);
+    singleMicroseconds = std::min(singleMicroseconds, ElapsedMicroseconds(start));
+
+    start = std::chrono::steady_clock::now();
+    batchedHits = raycaster->CastRays(&queries[0], &batched[0], queryCount);
+    batchedMicroseconds = std::min(batchedMicroseconds, ElapsedMicroseconds(start));
+  }
+
+  unsigned int batchMismatches = (singleHits != batchedHits);
+  unsigned long long steps = 0;
+  for (unsigned int i = 0; i < queryCount; i++)
+  {
+    batchMismatches += !SameHit(single[i], batched[i]);
+    steps += single[i].steps;
+  }
+
+  // line of sight from the player to every target at once, against one segment per target
+  std::vector<Vector2> targets(targetCount);
+  for (unsigned int i = 0; i < targetCount; i++)
+    targets[i] = RandomOpenPosition();
+  std::unique_ptr<bool[]> visible(new bool[targetCount]);
+  const unsigned int sightRuns = 100;
+  double separateMicroseconds = 0.0;
+  double sharedMicroseconds = 0.0;
+  unsigned int separateVisible = 0;
+  unsigned int sharedVisible = 0;
+  unsigned int sightMismatches = 0;
+  for (unsigned int run = 0; run < sightRuns; run++)
+  {
+    const Vector2 player = RandomOpenPosition();
+
+    double separateBest = 1e30;
+    double sharedBest = 1e30;
+    unsigned int count = 0;
+    unsigned int sharedCount = 0;
+    for (unsigned int repeat = 0; repeat < 3; repeat++)
+    {
+      auto start = std::chrono::steady_clock::now();
+      count = 0;
+      for (unsigned int i = 0; i < targetCount; i++)
+        count += raycaster->HasLineOfSight(player, targets[i]);
+      separateBest = std::min(separateBest, ElapsedMicroseconds(start));
+
+      start = std::chrono::steady_clock::now();
+      sharedCount = raycaster->CheckLineOfSight(player, &targets[0], visible.get(), targetCount);
+      sharedBest = std::min(sharedBest, ElapsedMicroseconds(start));
+    }
+    separateMicroseconds += separateBest;
+    sharedMicroseconds += sharedBest;
+    separateVisible += count;
+    sharedVisible += sharedCount;
+
+    for (unsigned int i = 0; i < targetCount; i++)
+      sightMismatches += (visible[i] != raycaster->HasLineOfSight(player, targets[i]));
+  }
+
+  printf("ray bench: %u queries, %u line-of-sight targets\n", queryCount, targetCount);
+  printf("  %u of %u rendered columns off the query distance (worst relative error %.2e), %u through an exact corner\n",
+    columnMismatches, columns, worstColumnError, cornerTies);
+  printf("  %u of %u random rays passed a wall the samples found, %u grazed a corner between samples\n", seenThroughWalls, queryCount, grazes);
+  printf("  single  %.3f us per ray, %.2f cells per ray, %u hits\n", singleMicroseconds / queryCount, (double)steps / queryCount, singleHits);
+  printf("  batched %.3f us per ray, %u results differ from single\n", batchedMicroseconds / queryCount, batchMismatches);
+  printf("  line of sight: separate %.3f us per target, shared %.3f us per target, %.1f%% visible, %u differ\n",
+    separateMicroseconds / sightRuns / targetCount, sharedMicroseconds / sightRuns / targetCount,
+    100.0 * sharedVisible / sightRuns / targetCount, sightMismatches + (separateVisible != sharedVisible));
+
+  return (columnMismatches == 0 && seenThroughWalls == 0 && batchMismatches == 0 && sightMismatches == 0) ? 0 : 1;
+}
+
+// cells a ray passes through before its wall that the set says cannot be seen from its origin
+static unsigned int CountUnlistedCells(Raycaster *raycaster, VisibilitySet *visibility, Vector2 origin, Vector2 ray, unsigned int *checked)
+{
+  RayHit hit;
+  if (!raycaster->CastRay(origin, ray, MAP_WIDTH + MAP_HEIGHT, &hit))
+    return 0;
+
+  const double length = ray.Length();
+  unsigned int unlisted = 0;
+  int lastX = (int)floor(origin.x);
+  int lastY = (int)floor(origin.y);
+  for (double t = 0.0; t < hit.distance; t += 0.01)
+  {
+    const int x = (int)floor(origin.x + t * ray.x / length);
+    const int y = (int)floor(origin.y + t * ray.y / length);
+    if (x == lastX && y == lastY)
+      continue;
+    lastX = x;
+    lastY = y;
+    // the last sample before the wall can land in it
+    if (worldMap[y][MAP_WIDTH - 1 - x] != 0)
+      continue;
+    (*checked)++;
+    if (!visibility->IsPotentiallyVisible(origin, Vector2(x + 0.5, y + 0.5)))
+      unlisted++;
+  }
+  return unlisted;
+}
+
+static unsigned int CountDifferentPairs(VisibilitySet *a, VisibilitySet *b)
+{
+  unsigned int different = 0;
+  for (int from = 0; from < MAP_WIDTH * MAP_HEIGHT; from++)
+  {
+    for (int to = from; to < MAP_WIDTH * MAP_HEIGHT; to++)
+    {
+      different += a->IsPotentiallyVisible(from % MAP_WIDTH, from / MAP_WIDTH, to % MAP_WIDTH, to / MAP_WIDTH) !=
+        b->IsPotentiallyVisible(from % MAP_WIDTH, from / MAP_WIDTH, to % MAP_WIDTH, to / MAP_WIDTH);
+    }
+  }
+  return different;
+}
+
+// Builds the set for the shipped map and checks it against the renderer: every open cell a
+// rendered column (and a ray in every direction from random points) passes through must be listed
+// as visible from the camera's cell. Then inner tiles are toggled one at a time, and the set
+// rebuilt incrementally after each change must match one built from scratch.
+static int VisibilityBench(int argc, char **argv)
+{
+  const unsigned int views = (argc > 0) ? atoi(argv[0]) : 2000;
+  const unsigned int toggles = (argc > 1) ? atoi(argv[1]) : 100;
+  const unsigned int raysPerView = 128;
+
+  std::unique_ptr<Raycaster> raycaster(new Raycaster(MAP_WIDTH, MAP_HEIGHT, *worldMap));
+  std::unique_ptr<VisibilitySet> visibility(new VisibilitySet(raycaster.get()));
+  std::unique_ptr<VisibilitySet> reference(new VisibilitySet(raycaster.get()));
+
+  auto start = std::chrono::steady_clock::now();
+  visibility->Build();
+  const double buildMicroseconds = ElapsedMicroseconds(start);
+  const VisibilityStats built = visibility->GetStats();
+  const unsigned int openPairs = built.openCells * (built.openCells - 1) / 2;
+
+  // the renderer's own columns over the test views, then rays all round from random points
+  std::unique_ptr<DisplayWrapper> display(new DisplayWrapper());
+  const unsigned int framesPerPosition = 64;
+  unsigned int renderedUnlisted = 0;
+  unsigned int renderedChecked = 0;
+  for (unsigned int frame = 0; frame < TEST_POSITION_COUNT * framesPerPosition; frame++)
+  {
+    SetTestPose(raycaster.get(), frame, framesPerPosition);
+    const Vector2 camera = raycaster->GetCameraPosition();
+    const Vector2 direction = raycaster->GetCameraDirection();
+    const Vector2 right = raycaster->GetClipPlaneRightVector();
+    const double clip = raycaster->GetClipPlaneDistance();
+    for (unsigned int x = 0; x < display->GetWidth(); x++)
+    {
+      const double cameraX = 2.0 * x / double(display->GetWidth()) - 1;
+      renderedUnlisted += CountUnlistedCells(raycaster.get(), visibility.get(), camera,
+        Vector2(right.x * cameraX + direction.x * clip, right.y * cameraX + direction.y * clip), &renderedChecked);
+    }
+  }
+
+  srand(1);
+  unsigned int randomUnlisted = 0;
+  unsigned int randomChecked = 0;
+  for (unsigned int view = 0; view < views; view++)
+  {
+    const Vector2 origin = RandomOpenPosition();
+    for (unsigned int r = 0; r < raysPerView; r++)
+    {
+      const double angle = 2.0 * M_PI * (r + RandomUnit()) / raysPerView;
+      randomUnlisted += CountUnlistedCells(raycaster.get(), visibility.get(), origin, Vector2(cos(angle), sin(angle)), &randomChecked);
+    }
+  }
+
+  const unsigned int queryCount = 1000000;
+  std::vector<uint16_t> queryCells(2 * 1024);
+  for (unsigned int i = 0; i < queryCells.size(); i++)
+  {
+    const Vector2 position = RandomOpenPosition();
+    queryCells[i] = (int)position.y * MAP_WIDTH + (int)position.x;
+  }
+  start = std::chrono::steady_clock::now();
+  unsigned int visibleQueries = 0;
+  for (unsigned int i = 0; i < queryCount; i++)
+  {
+    const unsigned int from = queryCells[(2 * i) & 2047];
+    const unsigned int to = queryCells[(2 * i + 1) & 2047];
+    visibleQueries += visibility->IsPotentiallyVisible(from % MAP_WIDTH, from / MAP_WIDTH, to % MAP_WIDTH, to / MAP_WIDTH);
+  }
+  const double queryMicroseconds = ElapsedMicroseconds(start);
+
+  // each toggle flips an inner tile and flips it back, checking the set after both changes
+  unsigned int rebuildMismatches = 0;
+  unsigned int changes = 0;
+  double rebuildMicroseconds = 0.0;
+  unsigned long long rebuildPairs = 0;
+  for (unsigned int toggle = 0; toggle < toggles; toggle++)
+  {
+    const int x = 1 + rand() % (MAP_WIDTH - 2);
+    const int y = 1 + rand() % (MAP_HEIGHT - 2);
+    int &tile = worldMap[y][MAP_WIDTH - 1 - x];
+    const int original = tile;
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+      tile = (pass == 0) ? (original == 0 ? 1 : 0) : original;
+
+      const uint32_t pairsBefore = visibility->GetStats().pairsTested;
+      start = std::chrono::steady_clock::now();
+      visibility->TileChanged(x, y);
+      while (!visibility->IsComplete())
+        visibility->Update(VISIBILITY_PAIRS_PER_FRAME);
+      rebuildMicroseconds += ElapsedMicroseconds(start);
+      rebuildPairs += visibility->GetStats().pairsTested - pairsBefore;
+      changes++;
+
+      reference->Build();
+      rebuildMismatches += (CountDifferentPairs(visibility.get(), reference.get()) != 0);
+    }
+  }
+
+  printf("pvs bench: %d samples per cell\n", VISIBILITY_SAMPLES_PER_AXIS * VISIBILITY_SAMPLES_PER_AXIS);
+  printf("  %u open cells, %u of %u pairs visible (%.1f%%), %u cells visible from the average cell\n", built.openCells,
+    built.visiblePairs, openPairs, 100.0 * built.visiblePairs / openPairs, 2 * built.visiblePairs / built.openCells);
+  printf("  %u bytes (%u of them pair bits), against %u for a bit per pair of map cells\n", built.bytes,
+    (unsigned int)((VISIBILITY_PAIR_BITS + 7) / 8), MAP_WIDTH * MAP_HEIGHT * MAP_WIDTH * MAP_HEIGHT / 8);
+  printf("  built in %.1f ms: %u pairs tested, %u rays cast, %.1f rays per pair\n", buildMicroseconds / 1000.0,
+    built.pairsTested, built.raysCast, (double)built.raysCast / built.pairsTested);
+  printf("  query %.1f ns, %.1f%% of random open cell pairs visible\n", queryMicroseconds * 1000.0 / queryCount, 100.0 * visibleQueries / queryCount);
+  printf("  %u of %u cells seen by rendered columns missing from the set\n", renderedUnlisted, renderedChecked);
+  printf("  %u of %u cells seen by rays from %u random points missing (%.3f%%): sampling's blind spots\n", randomUnlisted,
+    randomChecked, views, 100.0 * randomUnlisted / randomChecked);
+  printf("  %u tile changes: %.2f ms and %.0f pairs (%.1f%% of a full build) per rebuild, %u differ from a full build\n",
+    changes, rebuildMicroseconds / 1000.0 / changes, (double)rebuildPairs / changes, 100.0 * rebuildPairs / changes / built.pairsTested,
+    rebuildMismatches);
+
+  return (renderedUnlisted == 0 && rebuildMismatches == 0) ? 0 : 1;
+}
+
+// the face a ray query came in through, as the renderer would record it
+static WallFace FaceOfHit(const RayHit &hit, Vector2 ray)
+{
+  if (hit.side == RayHitNorthSouth)
+    return (ray.x > 0) ? FaceWest : FaceEast;
+  return (ray.y > 0) ? FaceSouth : FaceNorth;
+}
+
+// Checks the renderer's seen faces against every rendered column of a tour cast again as a ray
+// query, and times the tour with the tracking on and off. Then draws the automap incrementally
+// each frame of the tour, through scale changes, and checks every frame against an automap
+// invalidated and drawn from nothing.
+static int AutomapCheck(int argc, char **argv)
+{
+  const unsigned int frames = (argc > 0) ? atoi(argv[0]) : TEST_POSITION_COUNT * 64;
+  const char *outPath = (argc > 1) ? argv[1] : nullptr;
+  const unsigned int framesPerPosition = 64;
+
+  std::unique_ptr<DisplayWrapper> display(new DisplayWrapper());
+  std::unique_ptr<Raycaster> raycaster(new Raycaster(MAP_WIDTH, MAP_HEIGHT, *worldMap));
+  raycaster->SetSegmentCoherence(true);
+  const unsigned int width = display->GetWidth();
+  const unsigned int pageBytes = width * display->GetHeight() / 8;
+
+  // faces the same rays hit, one byte per cell
+  std::vector<unsigned char> expected(MAP_WIDTH * MAP_HEIGHT, 0);
+  unsigned int cornerTies = 0;
+  for (unsigned int frame = 0; frame < frames; frame++)
+  {
+    SetTestPose(raycaster.get(), frame, framesPerPosition);
+    display->Clear();
+    raycaster->RenderToDisplay(display.get());
+
+    const Vector2 camera = raycaster->GetCameraPosition();
+    const Vector2 direction = raycaster->GetCameraDirection();
+    const Vector2 right = raycaster->GetClipPlaneRightVector();
+    const double clip = raycaster->GetClipPlaneDistance();
+    for (unsigned int x = 0; x < width; x++)
+    {
+      const double cameraX = 2.0 * x / double(width) - 1;
+      Vector2 ray(right.x * cameraX + direction.x * clip, right.y * cameraX + direction.y * clip);
+      RayHit hit;
+      if (!raycaster->CastRay(camera, ray, MAP_WIDTH + MAP_HEIGHT, &hit))
+        continue;
+      if (hit.cellX < 0 || hit.cellX >= MAP_WIDTH || hit.cellY < 0 || hit.cellY >= MAP_HEIGHT)
+        continue;
+
+      // through an exact corner the renderer may have entered the cell by the other face
+      const double hitX = camera.x + hit.distance * ray.x / ray.Length();
+      const double hitY = camera.y + hit.distance * ray.y / ray.Length();
+      if (fabs(hitX - floor(hitX + 0.5)) < 1e-4 && fabs(hitY - floor(hitY + 0.5)) < 1e-4)
+      {
+        cornerTies++;
+        continue;
+      }
+      expected[hit.cellY * MAP_WIDTH + hit.cellX] |= 1 << FaceOfHit(hit, ray);
+    }
+  }
+
+  unsigned int missing = 0;
+  unsigned int extra = 0;
+  unsigned int seenFaces = 0;
+  for (int y = 0; y < MAP_HEIGHT; y++)
+  {
+    for (int x = 0; x < MAP_WIDTH; x++)
+    {
+      const unsigned char seen = raycaster->GetSeenFaces(x, y);
+      const unsigned char wanted = expected[y * MAP_WIDTH + x];
+      for (int face = 0; face < 4; face++)
+      {
+        missing += ((wanted & ~seen) >> face) & 1;
+        extra += ((seen & ~wanted) >> face) & 1;
+        seenFaces += (seen >> face) & 1;
+      }
+    }
+  }
+
+  // the fastest of a few alternating tours with the tracking on and off
+  double trackedMicroseconds = 1e30;
+  double untrackedMicroseconds = 1e30;
+  for (unsigned int run = 0; run < 5; run++)
+  {
+    for (int tracked = 1; tracked >= 0; tracked--)
+    {
+      raycaster->SetSeenTracking(tracked);
+      const auto start = std::chrono::steady_clock::now();
+      for (unsigned int frame = 0; frame < frames; frame++)
+      {
+        SetTestPose(raycaster.get(), frame, framesPerPosition);
+        display->Clear();
+        raycaster->RenderToDisplay(display.get());
+      }
+      double &best = tracked ? trackedMicroseconds : untrackedMicroseconds;
+      best = std::min(best, ElapsedMicroseconds(start));
+    }
+  }
+  raycaster->SetSeenTracking(true);
+
+  // the same tour from a clean slate, the automap drawn every frame both ways
+  raycaster->ClearSeen();
+  std::unique_ptr<Automap> incremental(new Automap(raycaster.get()));
+  std::unique_ptr<Automap> full(new Automap(raycaster.get()));
+  std::vector<unsigned char> rendered(pageBytes);
+  std::vector<unsigned char> drawn(pageBytes);
+  unsigned int frameMismatches = 0;
+  double incrementalMicroseconds = 0.0;
+  double fullMicroseconds = 0.0;
+  for (unsigned int frame = 0; frame < frames; frame++)
+  {
+    SetTestPose(raycaster.get(), frame, framesPerPosition);
+    display->Clear();
+    raycaster->RenderToDisplay(display.get());
+    display->PreparePages(true);
+    memcpy(&rendered[0], display->GetPageBuffer(), pageBytes);
+
+    // a different scale every quarter of the tour
+    const unsigned int scale = 1 + (AUTOMAP_DEFAULT_SCALE - 1 + 4 * frame / frames) % AUTOMAP_MAX_SCALE;
+    incremental->SetScale(scale);
+    full->SetScale(scale);
+
+    const Vector2 player = raycaster->GetCameraPosition();
+    const Vector2 direction = raycaster->GetCameraDirection();
+    auto start = std::chrono::steady_clock::now();
+    incremental->Draw(display.get(), player, direction);
+    incrementalMicroseconds += ElapsedMicroseconds(start);
+    memcpy(&drawn[0], display->GetPageBuffer(), pageBytes);
+
+    memcpy(display->GetPageBuffer(), &rendered[0], pageBytes);
+    start = std::chrono::steady_clock::now();
+    full->Invalidate();
+    full->Draw(display.get(), player, direction);
+    fullMicroseconds += ElapsedMicroseconds(start);
+    frameMismatches += (memcmp(&drawn[0], display->GetPageBuffer(), pageBytes) != 0);
+  }
+  const AutomapStats incrementalStats = incremental->GetStats();
+  const AutomapStats fullStats = full->GetStats();
+
+  bool written = true;
+  if (outPath)
+  {
+    std::vector<unsigned char> pixels(width * display->GetHeight());
+    for (unsigned int y = 0; y < display->GetHeight(); y++)
+      for (unsigned int x = 0; x < width; x++)
+        pixels[y * width + x] = ((drawn[(y / 8) * width + x] >> (y & 7)) & 1) ? 255 : 0;
+    written = ImageFile_WritePBM(outPath, &pixels[0], width, display->GetHeight());
+    if (!written)
+      printf("could not write %s\n", outPath);
+  }
+
+  printf("automap check: %u frames, %u faces seen\n", frames, seenFaces);
+  printf("  %u faces hit by ray queries missing from the seen faces, %u seen that no query hit, %u columns through an exact corner\n",
+    missing, extra, cornerTies);
+  printf("  render %.1f us per frame tracking faces, %.1f us without (%+.2f%%)\n", trackedMicroseconds / frames,
+    untrackedMicroseconds / frames, 100.0 * (trackedMicroseconds - untrackedMicroseconds) / untrackedMicroseconds);
+  printf("  incremental %.2f us per frame, %.2f tiles redrawn per frame; full redraw %.2f us per frame, %.2f tiles\n",
+    incrementalMicroseconds / frames, (double)incrementalStats.tilesRedrawn / frames, fullMicroseconds / frames,
+    (double)fullStats.tilesRedrawn / frames);
+  printf("  %u of %u frames differ from the full redraw\n", frameMismatches, frames);
+
+  return (missing == 0 && frameMismatches == 0 && written) ? 0 : 1;
+}
+
+// faces whose light differs between two maps of the same world
+static unsigned int CountDifferentFaces(LightMap *a, LightMap *b)
+{
+  unsigned int different = 0;
+  for (int y = 0; y < MAP_HEIGHT; y++)
+    for (int x = 0; x < MAP_WIDTH; x++)
+      for (int face = 0; face < 4; face++)
+        different += (a->GetFaceLevel(x, y, (WallFace)face) != b->GetFaceLevel(x, y, (WallFace)face));
+  return different;
+}
+
+// Bakes random lights over the shipped map, then moves, toggles and walls in lights one change at
+// a time. After each change the map is relit a budget of faces per frame until it settles, and
+// must then match a map baked from scratch with the same lights. Finally times the renderer with
+// and without the face light.
+static int LightBench(int argc, char **argv)
+{
+  const unsigned int lightCount = (argc > 0) ? atoi(argv[0]) : 8;
+  const unsigned int changeCount = (argc > 1) ? atoi(argv[1]) : 500;
+  const unsigned int budget = (argc > 2) ? atoi(argv[2]) : LIGHT_MAP_FACES_PER_FRAME;
+  const unsigned int framesPerPosition = 64;
+
+  std::unique_ptr<DisplayWrapper> display(new DisplayWrapper());
+  std::unique_ptr<Raycaster> raycaster(new Raycaster(MAP_WIDTH, MAP_HEIGHT, *worldMap));
+  raycaster->SetFloorTexture(8);
+  raycaster->SetCeilingTexture(13);
+  raycaster->SetSegmentCoherence(true);
+  std::unique_ptr<LightMap> lights(new LightMap(raycaster.get()));
+
+  srand(1);
+  const unsigned int count = std::min(lightCount, (unsigned int)LIGHT_MAP_MAX_LIGHTS);
+  std::vector<int> handles(count);
+  std::vector<Vector2> positions(count);
+  std::vector<float> radii(count);
+  std::vector<float> intensities(count);
+  std::vector<bool> enabled(count, true);
+  for (unsigned int i = 0; i < count; i++)
+  {
+    positions[i] = RandomOpenPosition();
+    radii[i] = 2.0f + 4.0f * RandomUnit();
+    intensities[i] = 0.5f + 0.5f * RandomUnit();
+    handles[i] = lights->AddLight(positions[i], radii[i], intensities[i]);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  lights->Bake();
+  const double bakeMicroseconds = ElapsedMicroseconds(start);
+  const LightMapStats baked = lights->GetStats();
+
+  unsigned int litFaces = 0;
+  for (int y = 0; y < MAP_HEIGHT; y++)
+    for (int x = 0; x < MAP_WIDTH; x++)
+      for (int face = 0; face < 4; face++)
+        litFaces += (lights->GetFaceLevel(x, y, (WallFace)face) != 0);
+
+  unsigned int mismatches = 0;
+  unsigned int overBudget = 0;
+  unsigned int changes = 0;
+  unsigned int frames = 0;
+  unsigned int longestSettle = 0;
+  unsigned long long relitFaces = 0;
+  double relightMicroseconds = 0.0;
+  for (unsigned int change = 0; change < changeCount; change++)
+  {
+    const unsigned int light = rand() % handles.size();
+    const unsigned int kind = rand() % 8;
+    int tileX = -1;
+    int tileY = -1;
+    int tileWas = 0;
+    if (kind < 5)
+    {
+      // a short step, as a carried light would take in a frame or two
+      const Vector2 step(positions[light].x + 0.5 * (RandomUnit() - 0.5), positions[light].y + 0.5 * (RandomUnit() - 0.5));
+      if (worldMap[(int)step.y][MAP_WIDTH - 1 - (int)step.x] == 0)
+        positions[light] = step;
+      lights->MoveLight(handles[light], positions[light]);
+    }
+    else if (kind < 7)
+    {
+      enabled[light] = !enabled[light];
+      lights->SetLightEnabled(handles[light], enabled[light]);
+    }
+    else
+    {
+      tileX = 1 + rand() % (MAP_WIDTH - 2);
+      tileY = 1 + rand() % (MAP_HEIGHT - 2);
+      int &tile = worldMap[tileY][MAP_WIDTH - 1 - tileX];
+      tileWas = tile;
+      tile = (tile == 0) ? 1 : 0;
+      lights->TileChanged(tileX, tileY);
+    }
+
+    const uint32_t relitBefore = lights->GetStats().facesRelit;
+    unsigned int settle = 0;
+    start = std::chrono::steady_clock::now();
+    while (!lights->IsSettled())
+    {
+      lights->Update(budget);
+      overBudget += (lights->GetStats().lastFacesRelit > budget);
+      settle++;
+    }
+    relightMicroseconds += ElapsedMicroseconds(start);
+    relitFaces += lights->GetStats().facesRelit - relitBefore;
+    longestSettle = std::max(longestSettle, settle);
+    frames += settle;
+    changes++;
+
+    // the same lights baked from nothing, added in the same order so the sums round alike
+    std::unique_ptr<LightMap> fresh(new LightMap(raycaster.get()));
+    for (unsigned int i = 0; i < handles.size(); i++)
+    {
+      const int handle = fresh->AddLight(positions[i], radii[i], intensities[i]);
+      fresh->SetLightEnabled(handle, enabled[i]);
+    }
+    fresh->Bake();
+    mismatches += (CountDifferentFaces(lights.get(), fresh.get()) != 0);
+
+    // tiles go back straight away, so the map stays the shipped one between changes
+    if (tileX >= 0)
+    {
+      worldMap[tileY][MAP_WIDTH - 1 - tileX] = tileWas;
+      lights->TileChanged(tileX, tileY);
+      while (!lights->IsSettled())
+        lights->Update(budget);
+    }
+  }
+
+  // the fastest of a few alternating tours with and without the face light
+  double litMicroseconds = 1e30;
+  double unlitMicroseconds = 1e30;
+  const unsigned int tourFrames = TEST_POSITION_COUNT * framesPerPosition;
+  for (unsigned int run = 0; run < 5; run++)
+  {
+    for (int lit = 1; lit >= 0; lit--)
+    {
+      raycaster->SetLightMap(lit ? lights.get() : nullptr);
+      start = std::chrono::steady_clock::now();
+      for (unsigned int frame = 0; frame < tourFrames; frame++)
+      {
+        SetTestPose(raycaster.get(), frame, framesPerPosition);
+        display->Clear();
+        raycaster->RenderToDisplay(display.get());
+      }
+      double &best = lit ? litMicroseconds : unlitMicroseconds;
+      best = std::min(best, ElapsedMicroseconds(start));
+    }
+  }
+
+  printf("light bench: %u lights, %u samples per face, %u faces relit per frame\n", (unsigned int)handles.size(),
+    LIGHT_MAP_SAMPLES_PER_FACE, budget);
+  printf("  %u bytes (%u of them face light), %u faces lit\n", baked.bytes, LIGHT_MAP_FACE_BYTES, litFaces);
+  printf("  baked in %.2f ms: %u faces, %u rays cast\n", bakeMicroseconds / 1000.0, baked.facesRelit, baked.raysCast);
+  printf("  %u changes: %.1f faces and %.1f us per change, settled in %.1f frames on average, %u at most\n", changes,
+    (double)relitFaces / changes, relightMicroseconds / changes, (double)frames / changes, longestSettle);
+  printf("  %u updates over the budget, %u of %u changes differ from a full bake\n", overBudget, mismatches, changes);
+  printf("  render %.1f us per frame with face light, %.1f us without (%+.2f%%)\n", litMicroseconds / tourFrames,
+    unlitMicroseconds / tourFrames, 100.0 * (litMicroseconds - unlitMicroseconds) / unlitMicroseconds);
+
+  return (mismatches == 0 && overBudget == 0) ? 0 : 1;
+}
+
+static uint16_t melodyFrequency;
+
+static void RecordMelodyOutput(uint16_t frequency)
+{
+  melodyFrequency = frequency;
+}
+
+// the frequency sounding after that many more sequencer ticks
+static uint16_t TickMelody(unsigned int ticks)
+{
+  for (unsigned int i = 0; i < ticks; i++)
+    MelodyPlayer_Tick();
+  return melodyFrequency;
+}
+
+static bool ReportMelodyCheck(const char *what, bool passed)
+{
+  printf("  %-58s %s\n", what, passed ? "ok" : "FAIL");
+  return passed;
+}
+
+// The melody sequencer ticked by hand: looping music with more music queued behind it until its
+// queue is full, then an effect, which must start on the next tick and hand back to the looping
+// music where it was cut off.
+static int MelodyCheck(int argc, char **argv)
+{
+  static const Note music[] = { { 262, 50 }, { 294, 50 } };
+  static const Note nextMusic[] = { { 330, 50 } };
+  static const Note effect[] = { { 880, 20 }, { 0, 10 }, { 988, 20 } };
+  (void)argc;
+  (void)argv;
+
+  MelodyPlayer_Init(RecordMelodyOutput);
+  printf("melody check: %d priorities, %d tracks queued per priority\n", MELODY_PRIORITY_COUNT, MELODY_QUEUE_SIZE - 1);
+
+  bool passed = true;
+  MelodyPlayer_Queue(music, 2, MELODY_PRIORITY_MUSIC, true);
+  passed &= ReportMelodyCheck("looping music starts on the next tick", TickMelody(1) == 262);
+  passed &= ReportMelodyCheck("and moves on to its second note", TickMelody(60) == 294);
+
+  unsigned int queued = 0;
+  while (MelodyPlayer_Queue(nextMusic, 1, MELODY_PRIORITY_MUSIC, false))
+    queued++;
+  passed &= ReportMelodyCheck("more music fills its queue", queued == MELODY_QUEUE_SIZE - 1);
+  passed &= ReportMelodyCheck("and waits behind the looping music", TickMelody(5) == 294);
+
+  passed &= ReportMelodyCheck("an effect is queued with the music queue full",
+    MelodyPlayer_Queue(effect, 3, MELODY_PRIORITY_EFFECT, false));
+  passed &= ReportMelodyCheck("and pre-empts the music on the next tick", TickMelody(1) == 880);
+  passed &= ReportMelodyCheck("then plays its rest and second note", TickMelody(20) == 0 && TickMelody(10) == 988);
+  passed &= ReportMelodyCheck("then the looping music resumes with its next note", TickMelody(20) == 262);
+  passed &= ReportMelodyCheck("and the queued music still waits", TickMelody(200) != 330 && MelodyPlayer_IsPlaying());
+
+  MelodyPlayer_Stop();
+  passed &= ReportMelodyCheck("stop silences everything and empties the queues", TickMelody(1) == 0 && !MelodyPlayer_IsPlaying());
+
+  return passed ? 0 : 1;
+}
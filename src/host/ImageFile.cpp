@@ -0,0 +1,104 @@
+#include "ImageFile.hpp"
+
+#include <stdio.h>
+#include <algorithm>
+#include <vector>
+
+bool ImageFile_WritePGM(const char *path, const unsigned char *pixels, unsigned int width, unsigned int height)
+{
+  FILE *file = fopen(path, "wb");
+  if (file == nullptr)
+    return false;
+
+  fprintf(file, "P5\n%u %u\n255\n", width, height);
+  const bool written = fwrite(pixels, 1, width * height, file) == width * height;
+
+  return (fclose(file) == 0) && written;
+}
+
+bool ImageFile_WritePBM(const char *path, const unsigned char *pixels, unsigned int width, unsigned int height)
+{
+  FILE *file = fopen(path, "wb");
+  if (file == nullptr)
+    return false;
+
+  fprintf(file, "P4\n%u %u\n", width, height);
+  // rows are padded to whole bytes, most significant bit first
+  const unsigned int rowBytes = (width + 7) / 8;
+  std::vector<unsigned char> row(rowBytes);
+  bool written = true;
+  for (unsigned int y = 0; y < height; y++)
+  {
+    std::fill(row.begin(), row.end(), 0);
+    for (unsigned int x = 0; x < width; x++)
+    {
+      if (pixels[y * width + x] >= 128)
+        row[x >> 3] |= 0x80 >> (x & 7);
+    }
+    written = written && fwrite(&row[0], 1, rowBytes, file) == rowBytes;
+  }
+
+  return (fclose(file) == 0) && written;
+}
+
+bool ImageFile_ReadPGM(const char *path, std::vector<unsigned char> &pixels, unsigned int *width, unsigned int *height)
+{
+  FILE *file = fopen(path, "rb");
+  if (file == nullptr)
+    return false;
+
+  unsigned int maxValue = 0;
+  bool read = fscanf(file, "P5 %u %u %u", width, height, &maxValue) == 3 && maxValue == 255 && *width * *height > 0
+    && fgetc(file) != EOF;
+  if (read)
+  {
+    pixels.resize(*width * *height);
+    read = fread(&pixels[0], 1, pixels.size(), file) == pixels.size();
+  }
+
+  fclose(file);
+  return read;
+}
+
+bool ImageFile_ReadPBM(const char *path, std::vector<unsigned char> &pixels, unsigned int *width, unsigned int *height)
+{
+  FILE *file = fopen(path, "rb");
+  if (file == nullptr)
+    return false;
+
+  bool read = fscanf(file, "P4 %u %u", width, height) == 2 && *width * *height > 0 && fgetc(file) != EOF;
+  if (read)
+  {
+    const unsigned int rowBytes = (*width + 7) / 8;
+    std::vector<unsigned char> row(rowBytes);
+    pixels.resize(*width * *height);
+    for (unsigned int y = 0; read && y < *height; y++)
+    {
+      read = fread(&row[0], 1, rowBytes, file) == rowBytes;
+      for (unsigned int x = 0; x < *width; x++)
+        pixels[y * *width + x] = (row[x >> 3] & (0x80 >> (x & 7))) ? 255 : 0;
+    }
+  }
+
+  fclose(file);
+  return read;
+}
+
+FILE* ImageFile_OpenY4M(const char *path, unsigned int width, unsigned int height, unsigned int framesPerSecond)
+{
+  FILE *file = fopen(path, "wb");
+  if (file != nullptr)
+    fprintf(file, "YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 Cmono\n", width, height, framesPerSecond);
+  return file;
+}
+
+bool ImageFile_WriteY4MFrame(FILE *file, const unsigned char *pixels, unsigned int width, unsigned int height)
+{
+  fputs("FRAME\n", file);
+  return fwrite(pixels, 1, width * height, file) == width * height;
+}
+
+bool ImageFile_CloseY4M(FILE *file)
+{
+  return fclose(file) == 0;
+}
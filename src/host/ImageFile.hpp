@@ -0,0 +1,22 @@
+#ifndef IMAGE_FILE_HPP
+#define IMAGE_FILE_HPP
+
+#include <stdio.h>
+#include <vector>
+
+// binary greyscale PGM (P5), one byte per pixel
+bool ImageFile_WritePGM(const char *path, const unsigned char *pixels, unsigned int width, unsigned int height);
+
+// binary bitmap PBM (P4): pixels at 128 or above are written as lit, which PBM stores as 1
+bool ImageFile_WritePBM(const char *path, const unsigned char *pixels, unsigned int width, unsigned int height);
+
+// read back files written by the functions above; PBM pixels come back as 0 or 255
+bool ImageFile_ReadPGM(const char *path, std::vector<unsigned char> &pixels, unsigned int *width, unsigned int *height);
+bool ImageFile_ReadPBM(const char *path, std::vector<unsigned char> &pixels, unsigned int *width, unsigned int *height);
+
+// greyscale YUV4MPEG2 video, one frame per ImageFile_WriteY4MFrame
+FILE* ImageFile_OpenY4M(const char *path, unsigned int width, unsigned int height, unsigned int framesPerSecond);
+bool ImageFile_WriteY4MFrame(FILE *file, const unsigned char *pixels, unsigned int width, unsigned int height);
+bool ImageFile_CloseY4M(FILE *file);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,193 @@
+#include "ParallelRenderer.hpp"
+
+#include <stdlib.h>
+#include <new>
+
+static inline uint64_t PackRange(unsigned int next, unsigned int end)
+{
+  return ((uint64_t)end << 32) | next;
+}
+
+static inline unsigned int RangeNext(uint64_t range)
+{
+  return (unsigned int)range;
+}
+
+static inline unsigned int RangeEnd(uint64_t range)
+{
+  return (unsigned int)(range >> 32);
+}
+
+ParallelRenderer::ParallelRenderer(unsigned int threadCount)
+{
+  if (threadCount < 1)
+    threadCount = 1;
+
+  this->threadCount = threadCount;
+  // plain new only guarantees the alignment of the largest fundamental type before C++17
+  queues = (WorkerQueue *)aligned_alloc(alignof(WorkerQueue), sizeof(WorkerQueue) * threadCount);
+  // fails the way new would, as every other host allocation does
+  if (queues == nullptr)
+    throw std::bad_alloc();
+  for (unsigned int worker = 0; worker < threadCount; worker++)
+    new (&queues[worker]) WorkerQueue();
+  frameNumber = 0;
+  workersBusy = 0;
+  shuttingDown = false;
+  raycaster = nullptr;
+  display = nullptr;
+  stats = ParallelRenderStats();
+
+  // worker 0 is the calling thread
+  for (unsigned int worker = 1; worker < threadCount; worker++)
+    threads.push_back(std::thread(&ParallelRenderer::WorkerLoop, this, worker));
+}
+
+ParallelRenderer::~ParallelRenderer(void)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    shuttingDown = true;
+  }
+  frameStart.notify_all();
+
+  for (unsigned int i = 0; i < threads.size(); i++)
+    threads[i].join();
+
+  for (unsigned int worker = 0; worker < threadCount; worker++)
+    queues[worker].~WorkerQueue();
+  free(queues);
+}
+
+unsigned int ParallelRenderer::GetThreadCount(void)
+{
+  return threadCount;
+}
+
+ParallelRenderStats ParallelRenderer::GetStats(void)
+{
+  return stats;
+}
+
+void ParallelRenderer::Render(Raycaster *raycaster, DisplayWrapper *display)
+{
+  const unsigned int chunks = (display->GetWidth() + PARALLEL_CHUNK_WIDTH - 1) / PARALLEL_CHUNK_WIDTH;
+
+  // even split to start with, stealing evens out the rest
+  for (unsigned int worker = 0; worker < threadCount; worker++)
+  {
+    queues[worker].range.store(PackRange(chunks * worker / threadCount, chunks * (worker + 1) / threadCount), std::memory_order_relaxed);
+    queues[worker].raysCast = 0;
+    queues[worker].steals = 0;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->raycaster = raycaster;
+    this->display = display;
+    workersBusy = threadCount - 1;
+    frameNumber++;
+  }
+  frameStart.notify_all();
+
+  RenderChunks(0);
+
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    frameDone.wait(lock, [this] { return workersBusy == 0; });
+  }
+
+  stats.chunks = chunks;
+  stats.steals = 0;
+  stats.raysCast = 0;
+  for (unsigned int worker = 0; worker < threadCount; worker++)
+  {
+    stats.steals += queues[worker].steals;
+    stats.raysCast += queues[worker].raysCast;
+  }
+}
+
+void ParallelRenderer::WorkerLoop(unsigned int worker)
+{
+  unsigned int lastFrame = 0;
+
+  while (true)
+  {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      frameStart.wait(lock, [this, lastFrame] { return shuttingDown || frameNumber != lastFrame; });
+      if (shuttingDown)
+        return;
+      lastFrame = frameNumber;
+    }
+
+    RenderChunks(worker);
+
+    bool lastWorker;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      lastWorker = (--workersBusy == 0);
+    }
+    if (lastWorker)
+      frameDone.notify_one();
+  }
+}
+
+void ParallelRenderer::RenderChunks(unsigned int worker)
+{
+  unsigned int chunk;
+
+  do
+  {
+    while (TakeChunk(worker, chunk))
+    {
+      const unsigned int firstX = chunk * PARALLEL_CHUNK_WIDTH;
+      queues[worker].raysCast += raycaster->RenderColumnRange(display, firstX, firstX + PARALLEL_CHUNK_WIDTH);
+    }
+  } while (StealChunks(worker));
+}
+
+bool ParallelRenderer::TakeChunk(unsigned int worker, unsigned int &chunk)
+{
+  std::atomic<uint64_t> &range = queues[worker].range;
+  uint64_t current = range.load(std::memory_order_acquire);
+
+  while (RangeNext(current) < RangeEnd(current))
+  {
+    if (range.compare_exchange_weak(current, PackRange(RangeNext(current) + 1, RangeEnd(current)), std::memory_order_acq_rel))
+    {
+      chunk = RangeNext(current);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool ParallelRenderer::StealChunks(unsigned int worker)
+{
+  // visit the other workers in turn, starting with the next one, and split the back half off
+  // the first queue with anything left in it
+  for (unsigned int i = 1; i < threadCount; i++)
+  {
+    const unsigned int victim = (worker + i) % threadCount;
+    std::atomic<uint64_t> &range = queues[victim].range;
+    uint64_t current = range.load(std::memory_order_acquire);
+
+    while (RangeNext(current) < RangeEnd(current))
+    {
+      const unsigned int remaining = RangeEnd(current) - RangeNext(current);
+      const unsigned int split = RangeEnd(current) - (remaining + 1) / 2;
+
+      if (range.compare_exchange_weak(current, PackRange(RangeNext(current), split), std::memory_order_acq_rel))
+      {
+        // our own queue is empty, so no one else can be taking from it
+        queues[worker].range.store(PackRange(split, RangeEnd(current)), std::memory_order_release);
+        queues[worker].steals++;
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
@@ -0,0 +1,72 @@
+#ifndef PARALLEL_RENDERER_HPP
+#define PARALLEL_RENDERER_HPP
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Raycaster.hpp"
+#include "DisplayWrapper.hpp"
+
+// columns per unit of work: a multiple of the packet and coherence widths
+#define PARALLEL_CHUNK_WIDTH 16
+
+#define PARALLEL_CACHE_LINE 64
+
+struct ParallelRenderStats
+{
+  unsigned int chunks;     // units of work in the last frame
+  unsigned int steals;     // times an idle worker took chunks from another worker
+  unsigned int raysCast;
+};
+
+// Column-parallel rendering for host builds. Each frame the columns are cut into chunks and dealt
+// out evenly; a worker that runs out takes half of the remaining chunks from another worker, so
+// ranges of near (expensive) walls do not leave the rest of the pool idle. The raycaster's camera,
+// map and textures are only read; workers write disjoint columns of the frame and depth buffer.
+class ParallelRenderer
+{
+public:
+  ParallelRenderer(unsigned int threadCount);
+  ~ParallelRenderer(void);
+
+  void Render(Raycaster *raycaster, DisplayWrapper *display);
+  unsigned int GetThreadCount(void);
+  ParallelRenderStats GetStats(void);
+
+private:
+  // [next, end) chunk indices packed into one word, so taking from the front (owner) and
+  // splitting off the back (thieves) are both a single compare-and-swap. Aligned to a cache line,
+  // so workers do not contend over each other's counters.
+  struct alignas(PARALLEL_CACHE_LINE) WorkerQueue
+  {
+    std::atomic<uint64_t> range;
+    unsigned int raysCast;
+    unsigned int steals;
+  };
+
+  unsigned int threadCount;
+  WorkerQueue *queues;
+  std::vector<std::thread> threads;
+
+  std::mutex mutex;
+  std::condition_variable frameStart;
+  std::condition_variable frameDone;
+  unsigned int frameNumber;
+  unsigned int workersBusy;
+  bool shuttingDown;
+
+  Raycaster *raycaster;
+  DisplayWrapper *display;
+  ParallelRenderStats stats;
+
+  void WorkerLoop(unsigned int worker);
+  void RenderChunks(unsigned int worker);
+  bool TakeChunk(unsigned int worker, unsigned int &chunk);
+  bool StealChunks(unsigned int worker);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,233 @@
+#include "SharedFrameRing.hpp"
+
+#include <fcntl.h>
+#include <string.h>
+#include <new>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SHARED_FRAME_MAGIC 0x52434652u // "RCFR"
+#define SLOT_ALIGNMENT 64
+
+// a viewer that is lapped twice in a row while copying gives up on this poll
+#define READ_ATTEMPTS 3
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "shared frame counters must be lock-free to work across processes");
+
+struct SharedFrameRing::Header
+{
+  uint32_t magic;
+  uint32_t width;
+  uint32_t height;
+  uint32_t slotCount;
+  uint32_t slotBytes;
+  std::atomic<uint32_t> producerActive;
+  std::atomic<uint64_t> published;
+  std::atomic<uint64_t> shown;
+  std::atomic<uint64_t> dropped;
+};
+
+// followed by the greyscale frame and then its pages
+struct SharedFrameRing::Slot
+{
+  // the frame's sequence number once complete; 0 while it is being drawn
+  std::atomic<uint64_t> sequence;
+};
+
+static size_t RoundUp(size_t bytes)
+{
+  return (bytes + SLOT_ALIGNMENT - 1) & ~(size_t)(SLOT_ALIGNMENT - 1);
+}
+
+SharedFrameRing::SharedFrameRing(void)
+{
+  header = nullptr;
+  mappedBytes = 0;
+  name[0] = '\0';
+  producer = false;
+  frameOpen = false;
+  lastShown = 0;
+}
+
+SharedFrameRing::~SharedFrameRing(void)
+{
+  if (header == nullptr)
+    return;
+
+  if (producer)
+  {
+    header->producerActive.store(0, std::memory_order_release);
+    // viewers keep their mapping until they let go of it
+    shm_unlink(name);
+  }
+  munmap(header, mappedBytes);
+}
+
+bool SharedFrameRing::Create(const char *name, unsigned int width, unsigned int height, unsigned int slots)
+{
+  strncpy(this->name, name, sizeof(this->name) - 1);
+  this->name[sizeof(this->name) - 1] = '\0';
+  shm_unlink(this->name);
+
+  const int file = shm_open(this->name, O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (file < 0)
+    return false;
+
+  const size_t slotBytes = RoundUp(sizeof(Slot)) + RoundUp(width * height + width * height / 8);
+  mappedBytes = RoundUp(sizeof(Header)) + slotBytes * slots;
+  void *mapping = MAP_FAILED;
+  if (ftruncate(file, mappedBytes) == 0)
+    mapping = mmap(nullptr, mappedBytes, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+  close(file);
+  if (mapping == MAP_FAILED)
+  {
+    shm_unlink(this->name);
+    return false;
+  }
+
+  // a fresh segment is zero-filled, so every slot starts out incomplete
+  header = new (mapping) Header();
+  header->width = width;
+  header->height = height;
+  header->slotCount = slots;
+  header->slotBytes = slotBytes;
+  header->producerActive.store(1, std::memory_order_relaxed);
+  header->published.store(0, std::memory_order_relaxed);
+  header->shown.store(0, std::memory_order_relaxed);
+  header->dropped.store(0, std::memory_order_relaxed);
+  // the magic goes in last, so a viewer never sees a half-written header as valid
+  std::atomic_thread_fence(std::memory_order_release);
+  header->magic = SHARED_FRAME_MAGIC;
+  producer = true;
+  return true;
+}
+
+bool SharedFrameRing::Open(const char *name)
+{
+  const int file = shm_open(name, O_RDWR, 0);
+  if (file < 0)
+    return false;
+
+  struct stat status;
+  void *mapping = MAP_FAILED;
+  if (fstat(file, &status) == 0 && (size_t)status.st_size >= sizeof(Header))
+  {
+    mappedBytes = status.st_size;
+    mapping = mmap(nullptr, mappedBytes, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+  }
+  close(file);
+  if (mapping == MAP_FAILED)
+    return false;
+
+  header = (Header*)mapping;
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (header->magic != SHARED_FRAME_MAGIC || RoundUp(sizeof(Header)) + (size_t)header->slotBytes * header->slotCount > mappedBytes)
+  {
+    munmap(header, mappedBytes);
+    header = nullptr;
+    return false;
+  }
+
+  // frames from before the viewer started are not counted as dropped
+  lastShown = header->published.load(std::memory_order_acquire);
+  if (lastShown > 0)
+    lastShown--;
+  return true;
+}
+
+unsigned int SharedFrameRing::GetWidth(void)
+{
+  return header->width;
+}
+
+unsigned int SharedFrameRing::GetHeight(void)
+{
+  return header->height;
+}
+
+void SharedFrameRing::BeginFrame(unsigned char **greyscale, unsigned char **pages)
+{
+  const uint64_t sequence = header->published.load(std::memory_order_relaxed) + 1;
+  Slot *slot = GetSlot(sequence);
+
+  // marked incomplete before any pixel changes, so a viewer copying the old frame notices
+  slot->sequence.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  *greyscale = (unsigned char*)slot + RoundUp(sizeof(Slot));
+  *pages = *greyscale + header->width * header->height;
+  frameOpen = true;
+}
+
+void SharedFrameRing::Publish(void)
+{
+  if (!frameOpen)
+    return;
+
+  const uint64_t sequence = header->published.load(std::memory_order_relaxed) + 1;
+  GetSlot(sequence)->sequence.store(sequence, std::memory_order_release);
+  header->published.store(sequence, std::memory_order_release);
+  frameOpen = false;
+}
+
+bool SharedFrameRing::ReadFrame(unsigned char *greyscale, unsigned char *pages, uint64_t *sequence)
+{
+  for (int attempt = 0; attempt < READ_ATTEMPTS; attempt++)
+  {
+    const uint64_t newest = header->published.load(std::memory_order_acquire);
+    if (newest <= lastShown)
+      return false;
+
+    // the next frame in order if the renderer has not started reusing its slot, else the newest
+    uint64_t wanted = lastShown + 1;
+    if (newest - wanted >= header->slotCount - 1)
+      wanted = newest;
+
+    if (CopySlot(wanted, greyscale, pages))
+    {
+      header->dropped.fetch_add(wanted - lastShown - 1, std::memory_order_relaxed);
+      header->shown.store(wanted, std::memory_order_relaxed);
+      lastShown = wanted;
+      *sequence = wanted;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool SharedFrameRing::IsProducerActive(void)
+{
+  return header->producerActive.load(std::memory_order_acquire) != 0;
+}
+
+SharedFrameStats SharedFrameRing::GetStats(void)
+{
+  SharedFrameStats stats;
+  stats.published = header->published.load(std::memory_order_relaxed);
+  stats.shown = header->shown.load(std::memory_order_relaxed);
+  stats.dropped = header->dropped.load(std::memory_order_relaxed);
+  return stats;
+}
+
+SharedFrameRing::Slot *SharedFrameRing::GetSlot(uint64_t sequence)
+{
+  unsigned char *slots = (unsigned char*)header + RoundUp(sizeof(Header));
+  return (Slot*)(slots + (size_t)(sequence % header->slotCount) * header->slotBytes);
+}
+
+bool SharedFrameRing::CopySlot(uint64_t sequence, unsigned char *greyscale, unsigned char *pages)
+{
+  Slot *slot = GetSlot(sequence);
+  if (slot->sequence.load(std::memory_order_acquire) != sequence)
+    return false;
+
+  const unsigned int size = header->width * header->height;
+  const unsigned char *frame = (unsigned char*)slot + RoundUp(sizeof(Slot));
+  memcpy(greyscale, frame, size);
+  memcpy(pages, frame + size, size / 8);
+
+  // still the same frame afterwards means the renderer did not start over it during the copy
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return slot->sequence.load(std::memory_order_relaxed) == sequence;
+}
@@ -0,0 +1,64 @@
+#ifndef SHARED_FRAME_RING_HPP
+#define SHARED_FRAME_RING_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+#define SHARED_FRAME_RING_NAME "/raycast-frames"
+#define SHARED_FRAME_RING_SLOTS 4
+
+struct SharedFrameStats
+{
+  uint64_t published; // frames the renderer finished
+  uint64_t shown;     // newest frame a viewer displayed
+  uint64_t dropped;   // frames viewers never displayed because newer ones overtook them, all viewers together
+};
+
+// Finished frames in a POSIX shared-memory segment for a viewer in another process. The renderer
+// draws straight into the slots (see the DisplayWrapper ring constructor) and only stores sequence
+// numbers, so it never copies a frame and never waits for a viewer. A viewer copies a slot out and
+// checks its sequence number again afterwards: if the renderer lapped it meanwhile, the copy is
+// thrown away and the newest frame is taken instead.
+class SharedFrameRing
+{
+public:
+  SharedFrameRing(void);
+  ~SharedFrameRing(void);
+
+  // renderer side: creates the segment, replacing any left over from an earlier run
+  bool Create(const char *name, unsigned int width, unsigned int height, unsigned int slots);
+  // viewer side: maps an existing segment
+  bool Open(const char *name);
+
+  unsigned int GetWidth(void);
+  unsigned int GetHeight(void);
+
+  // renderer side: the greyscale and page buffers of the next slot, to be drawn into until Publish
+  void BeginFrame(unsigned char **greyscale, unsigned char **pages);
+  void Publish(void);
+
+  // viewer side: copies the next frame, or the newest if the viewer fell behind; false when nothing
+  // new has been published. The greyscale frame is the one Render dithered in place
+  bool ReadFrame(unsigned char *greyscale, unsigned char *pages, uint64_t *sequence);
+  // false once the renderer has closed the segment
+  bool IsProducerActive(void);
+
+  SharedFrameStats GetStats(void);
+
+private:
+  struct Header;
+  struct Slot;
+
+  Slot *GetSlot(uint64_t sequence);
+  bool CopySlot(uint64_t sequence, unsigned char *greyscale, unsigned char *pages);
+
+  Header *header;
+  size_t mappedBytes;
+  char name[64];
+  bool producer;
+  bool frameOpen;
+  uint64_t lastShown;
+};
+
+#endif
\ No newline at end of file
@@ -3,57 +3,135 @@
 #include "DisplayWrapper.hpp"
 #include "Vector2.hpp"
 #include "Raycaster.hpp"
+#include "SpriteRenderer.hpp"
+#include "EntityStore.hpp"
+#include "FlowField.hpp"
+#include "VisibilitySet.hpp"
+#include "Automap.hpp"
+#include "LightMap.hpp"
 #include "Input.hpp"
 #include "FPS.hpp"
 #include "MelodyPlayer.hpp"
+#include "AudioMixer.hpp"
+#include "AudioOutput.hpp"
+#include "WorldMap.hpp"
+#include "TrigTables.hpp"
+#include "StaticArena.hpp"
+#include "MemoryReport.hpp"
+#include "Scheduler.hpp"
+#include "FramePacer.hpp"
+#include "FrameCapture.hpp"
 #include <SPI.h>
 
 #define ANALOG_PIN_1 15
-
-#define MAP_WIDTH 24
-#define MAP_HEIGHT 24
+#define BUZZER_PIN 22
 
 #define WALK_SPEED 3.0
 #define TURN_SPEED 1.5
 
-int worldMap[MAP_WIDTH][MAP_HEIGHT]=
-{
-  {4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 8, 8, 8, 8, 8, 8, 8, 8},
-  {4, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 8, 0, 0, 0, 0, 0, 0, 8},
-  {4, 0,13, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 8},
-  {4, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 8},
-  {4, 0,10, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 8, 0, 0, 0, 0, 0, 0, 8},
-  {4, 0, 4, 0, 0, 0, 0,13,13,13,13,13,13,13,13,13, 8, 8, 0, 8, 8, 8, 8, 8},
-  {4, 0,13, 0, 0, 0, 0,13, 0,13, 0,13, 0,13, 0,13, 8, 0, 0, 0, 8, 8, 8, 8},
-  {4, 0, 9, 0, 0, 0, 0,13, 0, 0, 0, 0, 0, 0, 0,13, 8, 0, 0, 0, 0, 0, 0,14},
-  {4, 0, 8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 8, 8, 8, 8},
-  {4, 0,14, 0, 0, 0, 0,13, 0, 0, 0, 0, 0, 0, 0,13, 8, 0, 0, 0, 0, 0, 0,14},
-  {4, 0, 0, 0, 0, 0, 0,13, 0, 0, 0, 0, 0, 0, 0,13, 8, 0, 0, 0, 8, 8, 8, 8},
-  {4, 0, 0, 0, 0, 0, 0,13,13,13,13, 0,13,13,13,13, 8, 8, 8, 8, 8, 8, 8, 8},
-  {9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 0, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9},
-  {9, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 4},
-  {9, 9, 9, 9, 9, 9, 0, 9, 9, 9, 9, 0, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9},
-  {4, 4, 4, 4, 4, 4, 0, 4, 4, 4, 9, 0, 9, 3, 3, 3, 3, 3, 3, 3,10,10,10, 3},
-  {4, 0, 0, 0, 0, 0, 0, 0, 0, 4, 9, 0, 9, 3, 0, 0, 0, 0, 0, 3, 0, 0, 0, 3},
-  {4, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 9, 3, 0, 0,13, 0, 0, 3, 0, 0, 0, 3},
-  {4, 0, 0, 0, 0, 0, 0, 0, 0, 4, 9, 0, 9, 3, 0, 0, 0, 0, 0, 3, 3, 0, 3, 3},
-  {4, 0, 9, 0, 9, 0, 0, 0, 0, 4, 9, 0, 0, 0, 0, 0,13, 0, 0, 0, 0, 0, 0, 3},
-  {4, 0, 0,13, 0, 0, 0, 0, 0, 4, 9, 0, 9, 3, 0, 0, 0, 0, 0, 3, 3, 0, 3, 3},
-  {4, 0, 9, 0, 9, 0, 0, 0, 0, 4, 9, 0, 9, 3, 0, 0,13, 0, 0, 3, 0, 0, 0, 3},
-  {4, 0, 0, 0, 0, 0, 0, 0, 0, 4, 9, 0, 9, 3, 0, 0, 0, 0, 0, 3, 0, 0, 0, 3},
-  {4, 4, 4, 4, 4, 4, 4, 4, 4, 4,13,13,13, 3, 3, 3, 3, 3, 3, 3,10,10,10, 3}
+// entities wandering the map besides the fixed props, and how far from the camera they are drawn
+#define WANDERER_COUNT 32
+#define WANDERER_SPEED 1.0f
+#define CHASER_COUNT 8
+#define CHASER_SPEED 1.5f
+#define SPRITE_RANGE 8.0f
+
+// torches fixed around the map, and the flash lighting the walls round the player when A fires
+#define TORCH_RADIUS 4.0f
+#define TORCH_INTENSITY 0.8f
+#define FLASH_RADIUS 3.0f
+#define FLASH_INTENSITY 1.0f
+#define FLASH_SECONDS 0.15
+
+// mixer voices on the DAC: background music, and the shot fired with A
+#define MUSIC_VOICE 0
+#define MUSIC_VOLUME 48
+#define SHOT_VOICE 1
+#define SHOT_VOLUME 96
+
+// frame interval and deadline: background tasks only run in whatever the frame tasks leave of
+// it and the CPU sleeps through the rest. 0 runs flat out
+#define FRAME_MICROSECONDS 33333
+
+// capture bytes queued per frame at most; the USB serial buffer takes the rest on its own time
+#define CAPTURE_BYTES_PER_FRAME 2048
+
+// Teensy 3.1 RAM, and what is kept back from the large buffers below for the stack, the Arduino
+// core's USB and serial buffers and the small tables each module keeps to itself
+#define DEVICE_RAM_SIZE 65536
+#define DEVICE_RAM_RESERVE 12288
+
+// every engine object lives in the static arena
+static_assert(sizeof(DisplayWrapper) + sizeof(Raycaster) + sizeof(SpriteRenderer) + sizeof(EntityStore) + sizeof(FlowField)
+  + sizeof(VisibilitySet) + sizeof(Automap) + sizeof(LightMap) + sizeof(FPS) + 9 * 8 <= STATIC_ARENA_SIZE,
+  "STATIC_ARENA_SIZE is too small for the engine objects");
+
+// the large static buffers: the arena, the greyscale frame and u8g2's pages, the capture snapshot,
+// the map and the DAC's double buffer; const tables stay in flash and are not counted
+static_assert(STATIC_ARENA_SIZE + DISPLAY_WIDTH * DISPLAY_HEIGHT + DISPLAY_WIDTH * DISPLAY_HEIGHT / 8
+  + FRAME_CAPTURE_BUFFER_SIZE + sizeof(worldMap) + AUDIO_BLOCK_SAMPLES * 2 * sizeof(uint16_t)
+  <= DEVICE_RAM_SIZE - DEVICE_RAM_RESERVE, "static buffers leave too little RAM for the stack");
+
+// played in place from flash
+static constexpr Note testMelody[] =
+{
+  { 440, 200 }, { 0, 66 },
+  { 440, 100 }, { 0, 33 },
+  { 440, 100 }, { 0, 33 },
+  { 330, 100 }, { 0, 33 },
+  { 440, 400 }
+};
+
+// the music voice's loop, a bass line; rests are silence
+static constexpr Note backgroundMusic[] =
+{
+  { 110, 300 }, { 0, 100 }, { 110, 200 }, { 131, 200 },
+  { 147, 300 }, { 0, 100 }, { 131, 200 }, { 98, 200 },
+  { 110, 300 }, { 0, 100 }, { 165, 200 }, { 147, 200 },
+  { 131, 400 }, { 98, 400 }
 };
 
 static DisplayWrapper *display;
 static Raycaster *raycaster;
+static SpriteRenderer *spriteRenderer;
+static EntityStore *entities;
+static FlowField *flowField;
+static VisibilitySet *visibility;
+static Automap *automap;
+static LightMap *lightMap;
 static FPS *fps;
 
-static uint32_t time;
+static double deltaTime;
 
 static Vector2 playerPosition;
-static Vector2 playerDirection;
+static Vector2 playerDirection; // always TrigTables_Direction(playerAngle)
+static BinaryAngle playerAngle;
+static bool showAutomap;
+static unsigned int musicNote;
+static double musicTimeLeft;
+static int flashLight;
+static double flashTimeLeft;
+
+static int gameTaskId;
+static IntervalTimer melodyTimer;
+#if RAYCASTER_STATS
+static RenderStats lastRenderStats; // copied in UpdateGame straight after the walls are drawn
+#endif
 
+void Sleep(void);
+void Buzzer(uint16_t frequency);
+void GameTask(void *context);
+void PresentTask(void *context);
+void ReportTask(void *context);
+void RenderStatsTask(void *context);
+void CaptureTask(void *context);
+void VisibilityTask(void *context);
 void UpdateGame(double deltaTime);
+void PlayMusic(double deltaTime);
+void SpawnEntities(void);
+void PlaceLights(void);
+Vector2 RandomOpenCell(void);
+void SteerChasers(void);
 void WalkForward(double distance);
 void WalkBackward(double distance);
 void StrafeLeft(double distance);
@@ -63,58 +141,194 @@ void TurnRight(double radians);
 
 void setup()
 {
+  MemoryReport_PaintStack();
+
   SPI.setSCK(14);
-  display = new DisplayWrapper();
+  display = StaticArena_New<DisplayWrapper>();
 
   Serial.begin(9600);
   unsigned int rngSeed = analogRead(ANALOG_PIN_1);
   randomSeed(rngSeed);
 
-  raycaster = new Raycaster(MAP_WIDTH, MAP_HEIGHT, *worldMap);
+  raycaster = StaticArena_New<Raycaster>(MAP_WIDTH, MAP_HEIGHT, *worldMap);
+  raycaster->SetFloorTexture(8);
+  raycaster->SetCeilingTexture(13);
+  raycaster->SetSegmentCoherence(true);
 
-  fps = new FPS();
+  spriteRenderer = StaticArena_New<SpriteRenderer>();
+  entities = StaticArena_New<EntityStore>(MAP_WIDTH, MAP_HEIGHT, *worldMap);
+  flowField = StaticArena_New<FlowField>(MAP_WIDTH, MAP_HEIGHT, *worldMap);
+  visibility = StaticArena_New<VisibilitySet>(raycaster);
+  automap = StaticArena_New<Automap>(raycaster);
+  lightMap = StaticArena_New<LightMap>(raycaster);
+  PlaceLights();
+  raycaster->SetLightMap(lightMap);
+  SpawnEntities();
 
-  Input_InitPins();
+  fps = StaticArena_New<FPS>();
 
-  time = millis();
+  Input_InitPins();
 
   playerPosition.x = 17.5;
   playerPosition.y = 22.5;
 
-  playerDirection.x = 1;
-  playerDirection.y = 0;
-  playerDirection.Normalise();
-
-  int testMelody[] =
-  {
-    440, 200, 0, 66,
-    440, 100, 0, 33,
-    440, 100, 0, 33,
-    330, 100, 0, 33,
-    440, 400
-  };
+  playerAngle = 0;
+  playerDirection = TrigTables_Direction(playerAngle);
 
   // // rumble / noise
-  // int testMelody[1000];
-  // for (int i = 0; i < 1000; i += 2)
+  // static Note rumble[500];
+  // for (int i = 0; i < 500; i++)
   // {
-  //   testMelody[i] = random(100, 200);
-  //   testMelody[i + 1] = 2;
+  //   rumble[i].frequency = random(100, 200);
+  //   rumble[i].duration = 2;
   // }
 
-  MelodyPlayer_SetPassiveBuzzerPin(22);
-  MelodyPlayer_SetMelody(testMelody, sizeof(testMelody) / sizeof(int));
+  MelodyPlayer_Init(Buzzer);
+  melodyTimer.begin(MelodyPlayer_Tick, MELODY_TICK_MICROSECONDS);
+  AudioOutput_Begin();
+
+  Scheduler_Init(micros);
+  FramePacer_Init(micros, Sleep);
+  FramePacer_SetInterval(FRAME_MICROSECONDS);
+  FramePacer_SetDeltaTimeMode(SmoothedDelta);
+  gameTaskId = Scheduler_AddPeriodic("game", GameTask, nullptr, 0, 25000, SCHEDULER_PRIORITY_FRAME);
+  Scheduler_AddPeriodic("present", PresentTask, nullptr, 0, 8000, SCHEDULER_PRIORITY_FRAME);
+  Scheduler_AddPeriodic("capture", CaptureTask, nullptr, 0, 1500, SCHEDULER_PRIORITY_BACKGROUND);
+  Scheduler_AddPeriodic("visibility", VisibilityTask, nullptr, 0, 4000, SCHEDULER_PRIORITY_BACKGROUND);
+#if RAYCASTER_STATS
+  Scheduler_AddPeriodic("render-stats", RenderStatsTask, nullptr, 500000, 2000, SCHEDULER_PRIORITY_BACKGROUND);
+#endif
+
+  // no engine allocations after this point
+  StaticArena_Seal();
+  MemoryReport_MarkStartup();
+  MemoryReport_Print();
 }
 
 void loop()
 {
-  const uint32_t currentTime = millis();
-  const double deltaTime = (currentTime - time) / 1000.0;
-  time = currentTime;
+  deltaTime = FramePacer_StartFrame();
+  Scheduler_RunFrame(FRAME_MICROSECONDS);
+  FramePacer_FinishFrame();
+}
 
+// any interrupt wakes it: the 1 ms system tick, audio blocks, the melody tick
+void Sleep(void)
+{
+  __asm__ volatile("wfi");
+}
+
+// the melody player's output: a square wave on the passive buzzer
+void Buzzer(uint16_t frequency)
+{
+  if (frequency > 0)
+    tone(BUZZER_PIN, frequency);
+  else
+    noTone(BUZZER_PIN);
+}
+
+void GameTask(void *context)
+{
   UpdateGame(deltaTime);
+  PlayMusic(deltaTime);
   Input_Clear();
-  display->Render(true); // dithering parameter
+}
+
+void PresentTask(void *context)
+{
+  TaskStats game;
+  Scheduler_GetTaskStats(gameTaskId, &game);
+
+  // dithering rewrites the greyscale frame, so greyscale captures are taken before it and page
+  // captures after the overlays
+  if (FrameCapture_GetFormat() == CaptureGreyscale)
+    FrameCapture_Snapshot(display, millis(), game.lastMicroseconds);
+  display->PreparePages(true); // dithering parameter
+  if (showAutomap)
+    automap->Draw(display, playerPosition, playerDirection);
+  if (FrameCapture_GetFormat() == CapturePages)
+    FrameCapture_Snapshot(display, millis(), game.lastMicroseconds);
+  display->SendPages();
+}
+
+// Serial output is slow, so the reports wait for a frame with room for them
+void ReportTask(void *context)
+{
+  MemoryReport_Print();
+  AudioOutput_PrintLoad();
+
+  const SchedulerStats stats = Scheduler_GetStats();
+  Serial.printf("frames: %u, %u over deadline, %u us slack last frame\n", (unsigned int)stats.frames,
+    (unsigned int)stats.frameOverruns, (unsigned int)stats.lastSlackMicroseconds);
+
+  const FramePacerStats pacing = FramePacer_GetStats();
+  Serial.printf("pacing: %u frames, %u missed, %u us mean frame (deviation %u us), %u%% awake\n", (unsigned int)pacing.frames,
+    (unsigned int)pacing.missedFrames, (unsigned int)pacing.meanFrameMicroseconds, (unsigned int)pacing.frameMicrosecondsDeviation,
+    (unsigned int)(pacing.utilisation * 100.0f));
+
+  TaskStats task;
+  for (int id = 0; id < SCHEDULER_MAX_TASKS; id++)
+  {
+    if (Scheduler_GetTaskStats(id, &task))
+      Serial.printf("  %s: %u runs, %u overruns, %u deferred, %u us last, %u us worst\n", task.name, (unsigned int)task.runs,
+        (unsigned int)task.overruns, (unsigned int)task.deferrals, (unsigned int)task.lastMicroseconds, (unsigned int)task.worstMicroseconds);
+  }
+}
+
+#if RAYCASTER_STATS
+// one CSV line twice a second while a serial monitor is attached: where the camera was, how long
+// the game task took and what the renderer did, so slow frames can be traced to map regions
+void RenderStatsTask(void *context)
+{
+  if (!Serial)
+    return;
+
+  TaskStats game;
+  Scheduler_GetTaskStats(gameTaskId, &game);
+  const RenderStats &stats = lastRenderStats;
+  Serial.printf("render,%u,%d,%d,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u\n", (unsigned int)millis(),
+    (int)(playerPosition.x * 100.0), (int)(playerPosition.y * 100.0), (unsigned int)playerAngle, (unsigned int)game.lastMicroseconds,
+    stats.raysCast, stats.ddaSteps, stats.clampedRays, stats.halfRateColumns, stats.texelsSampled, stats.pixelsWritten,
+    stats.maxColumnDdaSteps, stats.maxDdaStepsColumn, stats.maxColumnWallPixels);
+}
+#endif
+
+// Serial commands: g / p stream greyscale or page frames, G / P send a single frame, s stops.
+// Frames go out a few packets at a time, only as fast as the port drains.
+void CaptureTask(void *context)
+{
+  while (Serial.available() > 0)
+  {
+    const int command = Serial.read();
+    if (command == 'g' || command == 'G')
+      FrameCapture_Start(CaptureGreyscale, (command == 'g') ? 0 : 1);
+    else if (command == 'p' || command == 'P')
+      FrameCapture_Start(CapturePages, (command == 'p') ? 0 : 1);
+    else if (command == 's')
+      FrameCapture_Stop();
+  }
+
+  unsigned char packets[256];
+  unsigned int sent = 0;
+  while (sent < CAPTURE_BYTES_PER_FRAME)
+  {
+    int space = Serial.availableForWrite();
+    if (space > (int)sizeof(packets))
+      space = sizeof(packets);
+    const unsigned int length = FrameCapture_Pump(packets, space);
+    if (length == 0)
+      break;
+    Serial.write(packets, length);
+    sent += length;
+  }
+}
+
+// the visibility set is built over the first seconds after startup, in time the frame tasks leave
+// spare; until then nothing is culled
+void VisibilityTask(void *context)
+{
+  if (!visibility->IsComplete())
+    visibility->Update(VISIBILITY_PAIRS_PER_FRAME);
 }
 
 void UpdateGame(double deltaTime)
@@ -124,9 +338,18 @@ void UpdateGame(double deltaTime)
   if (Input_IsHeld(Button::Down))
     WalkBackward(WALK_SPEED * deltaTime);
   if (Input_WasPressed(Button::A))
-    MelodyPlayer_Play();
-  // if (Input_WasPressed(Button::B))
-  //   tone(22, 330, 250);
+  {
+    MelodyPlayer_Queue(testMelody, sizeof(testMelody) / sizeof(Note), MELODY_PRIORITY_EFFECT, false);
+    AudioMixer_Play(SHOT_VOICE, Noise, 6000, SHOT_VOLUME, (unsigned int)(FLASH_SECONDS * 1000));
+    lightMap->MoveLight(flashLight, playerPosition);
+    lightMap->SetLightEnabled(flashLight, true);
+    flashTimeLeft = FLASH_SECONDS;
+  }
+  // B with A held shows or hides the automap
+  if (Input_WasPressed(Button::B) && Input_IsHeld(Button::A))
+    showAutomap = !showAutomap;
+  else if (Input_WasPressed(Button::B))
+    Scheduler_Defer("report", ReportTask, nullptr, 0, 5000, SCHEDULER_PRIORITY_BACKGROUND);
   // if (Input_IsHeld(Button::A))
   //   StrafeLeft(WALK_SPEED * deltaTime);
   // if (Input_IsHeld(Button::B))
@@ -136,13 +359,129 @@ void UpdateGame(double deltaTime)
   if (Input_IsHeld(Button::Right))
     TurnRight(TURN_SPEED * deltaTime);
 
+  // the path search costs the same each frame however many chasers there are
+  flowField->SetGoal(playerPosition);
+  flowField->Update(FLOW_FIELD_CELLS_PER_FRAME);
+  SteerChasers();
+  entities->Update(deltaTime);
+  entities->SubmitSprites(spriteRenderer, playerPosition, SPRITE_RANGE, visibility);
+
+  // the flash follows the player until it goes out; faces it touches are relit over a few frames
+  if (flashTimeLeft > 0.0)
+  {
+    flashTimeLeft -= deltaTime;
+    lightMap->MoveLight(flashLight, playerPosition);
+    if (flashTimeLeft <= 0.0)
+      lightMap->SetLightEnabled(flashLight, false);
+  }
+  lightMap->Update(LIGHT_MAP_FACES_PER_FRAME);
+
   display->Clear();
   raycaster->SetCameraPosition(playerPosition);
-  raycaster->SetCameraDirection(playerDirection);
+  raycaster->SetCameraAngle(playerAngle);
   raycaster->RenderToDisplay(display);
+  RAYCASTER_STAT(lastRenderStats = raycaster->GetRenderStats());
+  spriteRenderer->RenderToDisplay(raycaster, display);
   fps->ShowFPS(display, deltaTime);
 }
 
+// the music voice a note at a time: each note starts on the first frame after the last one is
+// due, and the mixer times its length to the block
+void PlayMusic(double deltaTime)
+{
+  musicTimeLeft -= deltaTime;
+  if (musicTimeLeft > 0.0)
+    return;
+
+  const Note &note = backgroundMusic[musicNote];
+  if (note.frequency > 31)
+    AudioMixer_Play(MUSIC_VOICE, Triangle, note.frequency, MUSIC_VOLUME, note.duration);
+  else
+    AudioMixer_Stop(MUSIC_VOICE);
+
+  // carried over, so late frames do not slow the tempo
+  musicTimeLeft += note.duration / 1000.0;
+  musicNote = (musicNote + 1) % (sizeof(backgroundMusic) / sizeof(Note));
+}
+
+void SpawnEntities(void)
+{
+  entities->Add(Vector2(17.5, 19.5), Vector2(), 0, EntityVisible);
+  entities->Add(Vector2(20.5, 19.5), Vector2(), 0, EntityVisible);
+  entities->Add(Vector2(18.5, 16.5), Vector2(), 1, EntityVisible);
+  entities->Add(Vector2(14.5, 17.5), Vector2(), 1, EntityVisible);
+
+  // wanderers and chasers start in the middle of a random open cell, wanderers heading in a
+  // random direction
+  for (int i = 0; i < WANDERER_COUNT; i++)
+  {
+    Vector2 velocity = TrigTables_Direction((BinaryAngle)random(65536));
+    velocity.Scale(WANDERER_SPEED);
+    entities->Add(RandomOpenCell(), velocity, random(2), EntityMoving | EntitySolid | EntityVisible);
+  }
+  for (int i = 0; i < CHASER_COUNT; i++)
+    entities->Add(RandomOpenCell(), Vector2(), 1, EntityMoving | EntitySolid | EntityVisible | EntityChasing);
+}
+
+Vector2 RandomOpenCell(void)
+{
+  while (true)
+  {
+    const Vector2 position(random(MAP_WIDTH) + 0.5, random(MAP_HEIGHT) + 0.5);
+    if (!entities->IsWall(position.x, position.y))
+      return position;
+  }
+}
+
+// heads each chaser straight at the player when it can see them, otherwise for the centre of its
+// next cell, or straight at the player anyway somewhere the search has not reached
+void SteerChasers(void)
+{
+  unsigned int chasers[CHASER_COUNT];
+  Vector2 positions[CHASER_COUNT];
+  bool seesPlayer[CHASER_COUNT];
+  unsigned int chaserCount = 0;
+  for (unsigned int i = 0; i < entities->GetCount() && chaserCount < CHASER_COUNT; i++)
+  {
+    if (!(entities->flags[i] & EntityChasing))
+      continue;
+    chasers[chaserCount] = i;
+    positions[chaserCount] = Vector2(entities->positionX[i], entities->positionY[i]);
+    chaserCount++;
+  }
+
+  // only chasers in cells the player's cell can see are worth a ray
+  unsigned int candidates[CHASER_COUNT];
+  Vector2 candidatePositions[CHASER_COUNT];
+  bool candidateSees[CHASER_COUNT];
+  unsigned int candidateCount = 0;
+  for (unsigned int c = 0; c < chaserCount; c++)
+  {
+    seesPlayer[c] = false;
+    if (!visibility->IsPotentiallyVisible(playerPosition, positions[c]))
+      continue;
+    candidates[candidateCount] = c;
+    candidatePositions[candidateCount++] = positions[c];
+  }
+  raycaster->CheckLineOfSight(playerPosition, candidatePositions, candidateSees, candidateCount);
+  for (unsigned int k = 0; k < candidateCount; k++)
+    seesPlayer[candidates[k]] = candidateSees[k];
+
+  for (unsigned int c = 0; c < chaserCount; c++)
+  {
+    const Vector2 &position = positions[c];
+    Vector2 target;
+    if (seesPlayer[c] || !flowField->GetNextCellCentre(position, &target))
+      target = playerPosition;
+
+    Vector2 heading(target.x - position.x, target.y - position.y);
+    const double distance = heading.Length();
+    heading.Scale((distance > 0.05) ? CHASER_SPEED / distance : 0.0);
+    entities->velocityX[chasers[c]] = heading.x;
+    entities->velocityY[chasers[c]] = heading.y;
+  }
+}
+
 void WalkForward(double distance)
 {
   Vector2 delta;
@@ -174,10 +513,27 @@ void StrafeRight(double distance)
 
 void TurnLeft(double radians)
 {
-  playerDirection.Rotate(radians);
+  // the angle is the only state turned; the direction is looked up from it, so it cannot drift
+  playerAngle += TrigTables_FromRadians(radians);
+  playerDirection = TrigTables_Direction(playerAngle);
 }
 
 void TurnRight(double radians)
 {
-  playerDirection.Rotate(-radians);
+  TurnLeft(-radians);
+}
+
+void PlaceLights(void)
+{
+  lightMap->AddLight(Vector2(20.5, 21.5), TORCH_RADIUS, TORCH_INTENSITY);
+  lightMap->AddLight(Vector2(6.5, 17.5), TORCH_RADIUS, TORCH_INTENSITY);
+  lightMap->AddLight(Vector2(12.5, 13.5), TORCH_RADIUS, TORCH_INTENSITY);
+  lightMap->AddLight(Vector2(8.5, 8.5), TORCH_RADIUS, TORCH_INTENSITY);
+  lightMap->AddLight(Vector2(19.5, 3.5), TORCH_RADIUS, TORCH_INTENSITY);
+
+  flashLight = lightMap->AddLight(playerPosition, FLASH_RADIUS, FLASH_INTENSITY);
+  lightMap->SetLightEnabled(flashLight, false);
+
+  // baked at load time; from here on only changed lights cost anything
+  lightMap->Bake();
 }